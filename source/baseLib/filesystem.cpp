@@ -1,8 +1,11 @@
 #include "filesystem.h"
 
 #include <array>
+#include <chrono>
 #include <iostream>
 #include <cstdio>
+#include <functional>
+#include <thread>
 
 #ifndef _WIN32
 // filesystem is only available on macOS Catalina 10.15+
@@ -277,6 +280,26 @@ namespace baseLib::filesystem
         return written == _size;
     }
 
+    bool writeFileAtomic(const std::string& _filename, const uint8_t* _data, const size_t _size)
+    {
+        // unique per thread and point in time, multiple processes may write the same file concurrently
+        const auto temp = _filename + '.' +
+            std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + '_' +
+            std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + ".tmp";
+
+        if(!writeFile(temp, _data, _size))
+        {
+            remove(temp);
+            return false;
+        }
+
+        if(rename(temp, _filename))
+            return true;
+
+        remove(temp);
+        return false;
+    }
+
     bool readFile(std::vector<uint8_t>& _data, const std::string& _filename)
     {
         auto* hFile = openFile(_filename, "rb");
@@ -435,4 +458,13 @@ namespace baseLib::filesystem
 	{
 		return 0 == ::remove(_filename.c_str());
 	}
+
+	bool rename(const std::string& _from, const std::string& _to)
+	{
+#ifdef _WIN32
+		return MoveFileExW(utf8ToWide(_from).c_str(), utf8ToWide(_to).c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+		return 0 == ::rename(_from.c_str(), _to.c_str());
+#endif
+	}
 }
@@ -44,6 +44,16 @@ namespace baseLib
 			return writeFile(_filename, &_data[0], _data.size());
 		}
 
+		// writes to a temporary file first and then replaces the target. Readers either see the previous or the complete
+		// new file, never a partially written one
+		bool writeFileAtomic(const std::string& _filename, const uint8_t* _data, size_t _size);
+
+		template<typename Alloc>
+		bool writeFileAtomic(const std::string& _filename, const std::vector<uint8_t, Alloc>& _data)
+		{
+			return writeFileAtomic(_filename, _data.data(), _data.size());
+		}
+
 		bool readFile(std::vector<uint8_t>& _data, const std::string& _filename);
 
 		template<typename T> bool readFile(T& _data, const std::string& _filename)
@@ -72,5 +82,6 @@ namespace baseLib
 #endif
 		bool exists(const std::string& _filename);
 		bool remove(const std::string& _filename);
+		bool rename(const std::string& _from, const std::string& _to);	// replaces _to if it exists
 	};
 }
@@ -21,6 +21,11 @@ namespace bridgeLib
 	}
 
 	void AudioBuffers::readInput(const uint32_t _channel, std::vector<float>& _data, const uint32_t _numSamples)
+	{
+		readInput(_channel, _data.data(), _numSamples);
+	}
+
+	void AudioBuffers::readInput(const uint32_t _channel, float* _data, const uint32_t _numSamples)
 	{
 		for(uint32_t i=0; i<_numSamples; ++i)
 			_data[i] = m_inputBuffers[_channel].pop_front();
@@ -44,6 +49,11 @@ namespace bridgeLib
 	}
 
 	void AudioBuffers::writeOutput(const uint32_t _channel, const std::vector<float>& _data, const uint32_t _numSamples)
+	{
+		writeOutput(_channel, _data.data(), _numSamples);
+	}
+
+	void AudioBuffers::writeOutput(const uint32_t _channel, const float* _data, const uint32_t _numSamples)
 	{
 		for(uint32_t i=0; i<_numSamples; ++i)
 			m_outputBuffers[_channel].push_back(_data[i]);
@@ -34,9 +34,11 @@ namespace bridgeLib
 
 		void writeInput(const synthLib::TAudioInputs& _inputs, uint32_t _size);
 		void readInput(uint32_t _channel, std::vector<float>& _data, uint32_t _numSamples);
+		void readInput(uint32_t _channel, float* _data, uint32_t _numSamples);
 
 		void readOutput(const synthLib::TAudioOutputs& _outputs, uint32_t _size);
 		void writeOutput(uint32_t _channel, const std::vector<float>& _data, uint32_t _numSamples);
+		void writeOutput(uint32_t _channel, const float* _data, uint32_t _numSamples);
 		void setLatency(uint32_t _newLatency, uint32_t _numSamplesToKeep);
 
 	private:
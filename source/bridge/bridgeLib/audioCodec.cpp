@@ -0,0 +1,233 @@
+#include "audioCodec.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "baseLib/binarystream.h"
+
+namespace bridgeLib
+{
+	namespace
+	{
+		// a zig zag encoded delta of two 24 bit values has 25 bits, which needs up to four 7 bit groups
+		constexpr uint32_t g_maxVarintBytes = 4;
+
+		constexpr float g_int24Scale = 8388608.0f;
+		constexpr float g_int24ScaleInv = 1.0f / g_int24Scale;
+
+		int32_t toInt24(const float _v)
+		{
+			const auto i = static_cast<int32_t>(std::lrint(_v * g_int24Scale));
+			return std::clamp(i, -0x800000, 0x7fffff);
+		}
+
+		float fromInt24(const int32_t _v)
+		{
+			return static_cast<float>(_v) * g_int24ScaleInv;
+		}
+
+		uint32_t zigZagEncode(const int32_t _v)
+		{
+			return (static_cast<uint32_t>(_v) << 1) ^ static_cast<uint32_t>(_v >> 31);
+		}
+
+		int32_t zigZagDecode(const uint32_t _v)
+		{
+			return static_cast<int32_t>(_v >> 1) ^ -static_cast<int32_t>(_v & 1);
+		}
+	}
+
+	AudioCodec::AudioCodec()
+	{
+		m_writeBuffer.reserve(16384 * 4);
+		m_readBuffer.reserve(16384 * 4);
+	}
+
+	void AudioCodec::write(baseLib::BinaryStream& _out, const float* _data, const uint32_t _numSamples)
+	{
+		if(!_data)
+		{
+			_out.write(Format::Absent);
+			return;
+		}
+
+		if(isSilent(_data, _numSamples))
+		{
+			_out.write(Format::Silent);
+			return;
+		}
+
+		switch (getType())
+		{
+		case AudioCodecType::Int24Delta:
+			if(encodeInt24Delta(_data, _numSamples))
+			{
+				_out.write(Format::Int24Delta);
+				_out.write(_numSamples);
+				_out.write(static_cast<uint32_t>(m_writeBuffer.size()));
+				_out.write(m_writeBuffer.data(), m_writeBuffer.size());
+				return;
+			}
+			[[fallthrough]];
+		case AudioCodecType::Int24:
+			encodeInt24(_data, _numSamples);
+			_out.write(Format::Int24);
+			_out.write(_numSamples);
+			_out.write(m_writeBuffer.data(), m_writeBuffer.size());
+			return;
+		default:
+			_out.write(Format::Float32);
+			_out.write(_numSamples);
+			_out.write(_data, _numSamples);
+			return;
+		}
+	}
+
+	uint32_t AudioCodec::read(baseLib::BinaryStream& _in, float* _dst, const uint32_t _numSamplesMax)
+	{
+		const auto format = _in.read<Format>();
+
+		if(format == Format::Absent)
+			return 0;
+
+		if(format == Format::Silent)
+		{
+			std::fill_n(_dst, _numSamplesMax, 0.0f);
+			return _numSamplesMax;
+		}
+
+		const auto numSamples = _in.read<uint32_t>();
+
+		if(numSamples > _numSamplesMax)
+			throw std::range_error("audio channel exceeds block size");
+
+		switch (format)
+		{
+		case Format::Float32:
+			_in.read(_dst, numSamples);
+			break;
+		case Format::Int24:
+			{
+				m_readBuffer.resize(static_cast<size_t>(numSamples) * 3);
+				_in.read(m_readBuffer.data(), m_readBuffer.size());
+
+				const auto* src = m_readBuffer.data();
+
+				for(uint32_t i=0; i<numSamples; ++i, src += 3)
+				{
+					// sign extend from 24 to 32 bits
+					const auto v = static_cast<int32_t>((static_cast<uint32_t>(src[0]) << 8) | (static_cast<uint32_t>(src[1]) << 16) | (static_cast<uint32_t>(src[2]) << 24)) >> 8;
+					_dst[i] = fromInt24(v);
+				}
+			}
+			break;
+		case Format::Int24Delta:
+			{
+				// the size is untrusted, do not allocate more than valid data can ever need
+				const auto size = _in.read<uint32_t>();
+
+				if(size > static_cast<size_t>(numSamples) * g_maxVarintBytes)
+					throw std::range_error("invalid delta encoded audio data size");
+
+				m_readBuffer.resize(size);
+				_in.read(m_readBuffer.data(), m_readBuffer.size());
+
+				const auto* src = m_readBuffer.data();
+				const auto* const end = src + m_readBuffer.size();
+
+				int32_t v = 0;
+
+				for(uint32_t i=0; i<numSamples; ++i)
+				{
+					uint32_t delta = 0;
+					uint32_t shift = 0;
+
+					while(true)
+					{
+						if(src == end || shift >= g_maxVarintBytes * 7)
+							throw std::range_error("invalid delta encoded audio data");
+
+						const auto b = *src++;
+						delta |= static_cast<uint32_t>(b & 0x7f) << shift;
+						shift += 7;
+
+						if(!(b & 0x80))
+							break;
+					}
+
+					v += zigZagDecode(delta);
+					_dst[i] = fromInt24(v);
+				}
+			}
+			break;
+		default:
+			throw std::range_error("unknown audio format");
+		}
+
+		return numSamples;
+	}
+
+	AudioCodecType AudioCodec::sanitize(const AudioCodecType _type)
+	{
+		return _type < AudioCodecType::Count ? _type : AudioCodecType::Best;
+	}
+
+	bool AudioCodec::isSilent(const float* _data, const uint32_t _numSamples)
+	{
+		for(uint32_t i=0; i<_numSamples; ++i)
+		{
+			if(_data[i] != 0.0f)	// NOLINT(clang-diagnostic-float-equal)
+				return false;
+		}
+		return true;
+	}
+
+	void AudioCodec::encodeInt24(const float* _data, const uint32_t _numSamples)
+	{
+		m_writeBuffer.resize(static_cast<size_t>(_numSamples) * 3);
+
+		auto* dst = m_writeBuffer.data();
+
+		for(uint32_t i=0; i<_numSamples; ++i, dst += 3)
+		{
+			const auto v = static_cast<uint32_t>(toInt24(_data[i]));
+			dst[0] = static_cast<uint8_t>(v);
+			dst[1] = static_cast<uint8_t>(v >> 8);
+			dst[2] = static_cast<uint8_t>(v >> 16);
+		}
+	}
+
+	bool AudioCodec::encodeInt24Delta(const float* _data, const uint32_t _numSamples)
+	{
+		// deltas of 24 bit values need at most four bytes. Give up as soon as the result is not smaller than plain 24 bit
+		const size_t maxSize = static_cast<size_t>(_numSamples) * 3;
+
+		m_writeBuffer.resize(maxSize + 4);
+
+		auto* dst = m_writeBuffer.data();
+		const auto* const end = dst + maxSize;
+
+		int32_t prev = 0;
+
+		for(uint32_t i=0; i<_numSamples; ++i)
+		{
+			const auto v = toInt24(_data[i]);
+			auto delta = zigZagEncode(v - prev);
+			prev = v;
+
+			while(delta >= 0x80)
+			{
+				*dst++ = static_cast<uint8_t>(delta | 0x80);
+				delta >>= 7;
+			}
+			*dst++ = static_cast<uint8_t>(delta);
+
+			if(dst >= end)
+				return false;
+		}
+
+		m_writeBuffer.resize(dst - m_writeBuffer.data());
+		return true;
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace baseLib
+{
+	class BinaryStream;
+}
+
+namespace bridgeLib
+{
+	// Float32 is the default. The 24 bit formats reduce the bandwidth but are lossy for anything that is not 24 bit data,
+	// such as resampled or gain adjusted output, and therefore need to be enabled explicitly
+	enum class AudioCodecType : uint8_t
+	{
+		Float32,		// raw 32 bit float
+		Int24,			// 24 bit integer, the DSPs are 24 bit anyway
+		Int24Delta,		// 24 bit integer, delta encoded with variable length integers. Lossless for 24 bit data
+
+		Count,
+		Best = Count - 1
+	};
+
+	// Encodes and decodes the audio data of one channel of an audio command. Each channel is tagged with the format
+	// that it is encoded with. The negotiated codec type defines the best format a sender is allowed to use, it falls
+	// back to a simpler one if the result would be larger.
+	// Silent channels are transmitted as a tag only, regardless of the codec type
+	class AudioCodec
+	{
+	public:
+		AudioCodec();
+
+		void setType(AudioCodecType _type) { m_type.store(_type, std::memory_order_relaxed); }
+		AudioCodecType getType() const { return m_type.load(std::memory_order_relaxed); }
+
+		// _data may be null if a channel is not available
+		void write(baseLib::BinaryStream& _out, const float* _data, uint32_t _numSamples);
+
+		// returns the number of samples written to _dst, zero if the channel is not available
+		uint32_t read(baseLib::BinaryStream& _in, float* _dst, uint32_t _numSamplesMax);
+
+		static AudioCodecType sanitize(AudioCodecType _type);
+
+	private:
+		enum class Format : uint8_t
+		{
+			Absent,
+			Silent,
+			Float32,
+			Int24,
+			Int24Delta
+		};
+
+		static bool isSilent(const float* _data, uint32_t _numSamples);
+		void encodeInt24(const float* _data, uint32_t _numSamples);
+		bool encodeInt24Delta(const float* _data, uint32_t _numSamples);
+
+		std::atomic<AudioCodecType> m_type{AudioCodecType::Float32};
+
+		std::vector<uint8_t> m_writeBuffer;
+		std::vector<uint8_t> m_readBuffer;
+	};
+}
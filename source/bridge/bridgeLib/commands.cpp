@@ -60,6 +60,7 @@ namespace bridgeLib
 		_s.write(pluginVersion);
 		_s.write(plugin4CC);
 		_s.write(sessionId);
+		_s.write(audioCodec);
 		return _s;
 	}
 
@@ -70,6 +71,7 @@ namespace bridgeLib
 		_s.read(pluginVersion);
 		plugin4CC = _s.readString();
 		_s.read(sessionId);
+		_s.read(audioCodec);
 		return _s;
 	}
 
@@ -78,7 +80,9 @@ namespace bridgeLib
 		_s.read(params.preferredSamplerate);
 		_s.read(params.hostSamplerate);
 		params.romName = _s.readString();
-		_s.read(params.romData);
+		std::vector<uint8_t> romData;
+		_s.read(romData);
+		params.romData = synthLib::RomData(std::move(romData));
 		_s.read(params.romHash);
 		_s.read(params.customData);
 		return _s;
@@ -89,7 +93,7 @@ namespace bridgeLib
 		_s.write(params.preferredSamplerate);
 		_s.write(params.hostSamplerate);
 		_s.write(params.romName);
-		_s.write(params.romData);
+		_s.write(params.romData.get());
 		_s.write(params.romHash);
 		_s.write(params.customData);
 		return _s;
@@ -106,6 +110,7 @@ namespace bridgeLib
 		_s.write(latencyMidiToOut);
 		_s.write(preferredSamplerates);
 		_s.write(supportedSamplerates);
+		_s.write(audioCodec);
 		return _s;
 	}
 
@@ -120,6 +125,7 @@ namespace bridgeLib
 		_s.read(latencyMidiToOut);
 		_s.read(preferredSamplerates);
 		_s.read(supportedSamplerates);
+		_s.read(audioCodec);
 		return _s;
 	}
 
@@ -184,4 +190,38 @@ namespace bridgeLib
 		_s.read(percent);
 		return _s;
 	}
+
+	baseLib::BinaryStream& SharedAudioDesc::write(baseLib::BinaryStream& _s) const
+	{
+		_s.write(name);
+		_s.write(size);
+		_s.write<uint8_t>(accepted ? 1 : 0);
+		return _s;
+	}
+
+	baseLib::BinaryStream& SharedAudioDesc::read(baseLib::BinaryStream& _s)
+	{
+		name = _s.readString();
+		_s.read(size);
+		accepted = _s.read<uint8_t>() != 0;
+		return _s;
+	}
+
+	baseLib::BinaryStream& SessionStats::write(baseLib::BinaryStream& _s) const
+	{
+		_s.write(cpuLoad);
+		_s.write(processedBlocks);
+		_s.write(deadlineMisses);
+		_s.write(worker);
+		return _s;
+	}
+
+	baseLib::BinaryStream& SessionStats::read(baseLib::BinaryStream& _s)
+	{
+		_s.read(cpuLoad);
+		_s.read(processedBlocks);
+		_s.read(deadlineMisses);
+		_s.read(worker);
+		return _s;
+	}
 }
@@ -2,6 +2,7 @@
 
 #include <cstdint>
 
+#include "audioCodec.h"
 #include "command.h"
 #include "commandStruct.h"
 #include "error.h"
@@ -41,7 +42,12 @@ namespace bridgeLib
 
 		SetUnknownCustomData = cmd("UnkD"),
 
-		SetDspClockPercent = cmd("DspC")
+		SetDspClockPercent = cmd("DspC"),
+
+		SharedAudio = cmd("ShmA"),
+
+		SessionStats = cmd("SeSt"),
+		RequestSessionStats = cmd("RqSS")
 	};
 
 	std::string commandToString(Command _command);
@@ -73,6 +79,7 @@ namespace bridgeLib
 		uint32_t pluginVersion = 0;
 		std::string plugin4CC;
 		SessionId sessionId = 0;
+		AudioCodecType audioCodec = AudioCodecType::Float32;	// requested by the client, lossy codecs are opt-in
 
 		PluginDesc()
 		{
@@ -124,6 +131,7 @@ namespace bridgeLib
 		uint32_t latencyMidiToOut = 0;
 		std::vector<float> preferredSamplerates;
 		std::vector<float> supportedSamplerates;
+		AudioCodecType audioCodec = AudioCodecType::Float32;	// used by the server
 
 		baseLib::BinaryStream& write(baseLib::BinaryStream& _s) const override;
 		baseLib::BinaryStream& read(baseLib::BinaryStream& _s) override;
@@ -171,4 +179,27 @@ namespace bridgeLib
 		baseLib::BinaryStream& write(baseLib::BinaryStream& _s) const override;
 		baseLib::BinaryStream& read(baseLib::BinaryStream& _s) override;
 	};
+
+	// sent by the client to offer audio transport via shared memory, the server replies with accepted set to true
+	// if it was able to open it
+	struct SharedAudioDesc : CommandStruct
+	{
+		std::string name;
+		uint64_t size = 0;
+		bool accepted = false;
+
+		baseLib::BinaryStream& write(baseLib::BinaryStream& _s) const override;
+		baseLib::BinaryStream& read(baseLib::BinaryStream& _s) override;
+	};
+
+	struct SessionStats : CommandStruct
+	{
+		float cpuLoad = 0.0f;			// processing time relative to the duration of the processed audio
+		uint64_t processedBlocks = 0;
+		uint64_t deadlineMisses = 0;	// blocks that took longer to process than their duration
+		uint32_t worker = 0;
+
+		baseLib::BinaryStream& write(baseLib::BinaryStream& _s) const override;
+		baseLib::BinaryStream& read(baseLib::BinaryStream& _s) override;
+	};
 }
@@ -0,0 +1,424 @@
+#include "sharedAudio.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <random>
+#include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define NOSERVICE
+#include <Windows.h>
+#elif defined(__linux__)
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(__APPLE__)
+// the futex equivalent of Darwin. Not part of the public headers but stable since macOS 10.12 and used by libc++
+extern "C" int __ulock_wait(uint32_t _operation, void* _addr, uint64_t _value, uint32_t _timeoutUs);
+extern "C" int __ulock_wake(uint32_t _operation, void* _addr, uint64_t _wakeValue);
+#endif
+
+namespace bridgeLib
+{
+	namespace
+	{
+		constexpr uint32_t g_magic = 0x47534841;	// GSHA
+		constexpr uint32_t g_version = 1;
+
+		// number of polls before a waiting side gives up its time slice. Blocks usually complete within a few
+		// microseconds when both processes are idle otherwise
+		constexpr uint32_t g_spinCount = 4096;
+
+		constexpr int64_t g_maxSleepNs = 10'000'000;
+
+#ifdef __APPLE__
+		constexpr uint32_t g_ulockCompareAndWaitShared = 3;
+		constexpr uint32_t g_ulockWakeAll = 0x100;
+#endif
+
+		constexpr size_t align(const size_t _size)
+		{
+			return (_size + 63) & ~static_cast<size_t>(63);
+		}
+
+		constexpr size_t g_headerSize = align(64);
+		constexpr size_t g_audioInSize = align(sizeof(float) * SharedAudio::MaxSamples * SharedAudio::MaxChannelsIn);
+		constexpr size_t g_audioOutSize = align(sizeof(float) * SharedAudio::MaxSamples * SharedAudio::MaxChannelsOut);
+
+		constexpr size_t g_offsetAudioIn = g_headerSize;
+		constexpr size_t g_offsetAudioOut = g_offsetAudioIn + g_audioInSize;
+		constexpr size_t g_offsetMidiIn = g_offsetAudioOut + g_audioOutSize;
+		constexpr size_t g_offsetMidiOut = g_offsetMidiIn + SharedAudio::MidiBufferSize;
+		constexpr size_t g_totalSize = g_offsetMidiOut + SharedAudio::MidiBufferSize;
+
+		// a, b, c, source, offset, sysex size
+		constexpr size_t g_midiEventHeaderSize = 4 + sizeof(uint32_t) * 2;
+
+		// needs to be short, macOS limits shared memory names to 31 characters
+		std::string createName()
+		{
+			std::random_device rd;
+			std::mt19937_64 rng((static_cast<uint64_t>(rd()) << 32) ^ rd() ^ static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()));
+
+			std::stringstream ss;
+			ss << "gmb" << std::hex << rng();
+			return ss.str();
+		}
+
+#ifdef _WIN32
+		std::string getEventName(const std::string& _name, const char* _suffix)
+		{
+			return "Local\\" + _name + _suffix;
+		}
+#endif
+	}
+
+	SharedAudio::~SharedAudio()
+	{
+		close();
+	}
+
+	bool SharedAudio::create(const uint32_t _firstRequest/* = 0*/)
+	{
+		close();
+
+		if(!m_shm.create(createName(), g_totalSize))
+			return false;
+
+		return init(true, _firstRequest);
+	}
+
+	bool SharedAudio::open(const std::string& _name)
+	{
+		close();
+
+		if(!m_shm.open(_name, g_totalSize))
+			return false;
+
+		return init(false);
+	}
+
+	void SharedAudio::close()
+	{
+		if(m_header)
+		{
+			// let the other side know that it should not wait for us anymore
+			m_header->closed.store(1, std::memory_order_release);
+		}
+
+#ifdef _WIN32
+		for(auto*& e : m_events)
+		{
+			if(e)
+				CloseHandle(e);
+			e = nullptr;
+		}
+#endif
+		m_header = nullptr;
+		m_audioIn = nullptr;
+		m_audioOut = nullptr;
+		m_midiIn = nullptr;
+		m_midiOut = nullptr;
+		m_requestPending = false;
+
+		m_shm.close();
+	}
+
+	size_t SharedAudio::getSize()
+	{
+		return g_totalSize;
+	}
+
+	bool SharedAudio::fitsMidiBuffer(const synthLib::SMidiEvent& _ev)
+	{
+		return getMidiSize(_ev) <= MidiBufferSize;
+	}
+
+	float* SharedAudio::getInput(const uint32_t _channel) const
+	{
+		return m_audioIn + static_cast<size_t>(_channel) * MaxSamples;
+	}
+
+	const float* SharedAudio::getOutput(const uint32_t _channel) const
+	{
+		return m_audioOut + static_cast<size_t>(_channel) * MaxSamples;
+	}
+
+	size_t SharedAudio::sendRequest(const uint32_t _numSamples, const std::vector<synthLib::SMidiEvent>& _midiIn)
+	{
+		assert(!m_requestPending);
+		assert(_numSamples <= MaxSamples);
+
+		const auto count = writeMidi(m_midiIn, m_header->midiInSize, _midiIn);
+
+		m_header->numSamples = _numSamples;
+
+		m_request = m_header->request.load(std::memory_order_relaxed) + 1;
+		m_header->request.store(m_request, std::memory_order_seq_cst);
+		wake(m_header->request);
+
+		m_requestPending = true;
+
+		return count;
+	}
+
+	bool SharedAudio::isReplyReady() const
+	{
+		return m_requestPending && m_header->reply.load(std::memory_order_acquire) == m_request;
+	}
+
+	SharedAudio::WaitResult SharedAudio::waitForReply(const uint32_t _timeoutMs)
+	{
+		assert(m_requestPending);
+
+		const auto res = wait(m_header->reply, m_request - 1, _timeoutMs);
+
+		if(res == WaitResult::Ready)
+			m_requestPending = false;
+
+		return res;
+	}
+
+	void SharedAudio::readMidiOut(std::vector<synthLib::SMidiEvent>& _midiOut) const
+	{
+		readMidi(_midiOut, m_midiOut, m_header->midiOutSize);
+	}
+
+	SharedAudio::WaitResult SharedAudio::waitForRequest(const uint32_t _timeoutMs) const
+	{
+		return wait(m_header->request, m_header->reply.load(std::memory_order_relaxed), _timeoutMs);
+	}
+
+	uint32_t SharedAudio::getRequestSize() const
+	{
+		return std::min(m_header->numSamples, MaxSamples);
+	}
+
+	void SharedAudio::getAudioBuffers(synthLib::TAudioInputs& _inputs, synthLib::TAudioOutputs& _outputs) const
+	{
+		for(uint32_t i=0; i<MaxChannelsIn; ++i)
+			_inputs[i] = m_audioIn + static_cast<size_t>(i) * MaxSamples;
+		for(uint32_t i=0; i<MaxChannelsOut; ++i)
+			_outputs[i] = m_audioOut + static_cast<size_t>(i) * MaxSamples;
+	}
+
+	void SharedAudio::readMidiIn(std::vector<synthLib::SMidiEvent>& _midiIn) const
+	{
+		readMidi(_midiIn, m_midiIn, m_header->midiInSize);
+	}
+
+	size_t SharedAudio::sendReply(const std::vector<synthLib::SMidiEvent>& _midiOut)
+	{
+		const auto count = writeMidi(m_midiOut, m_header->midiOutSize, _midiOut);
+
+		m_header->reply.store(m_header->request.load(std::memory_order_relaxed), std::memory_order_seq_cst);
+		wake(m_header->reply);
+
+		return count;
+	}
+
+	bool SharedAudio::init(const bool _create, const uint32_t _firstRequest/* = 0*/)
+	{
+		static_assert(sizeof(Header) <= g_headerSize, "header too large");
+		static_assert(std::atomic<uint32_t>::is_always_lock_free, "atomics need to be lock free to be shared between processes");
+
+		auto* data = static_cast<uint8_t*>(m_shm.data());
+
+		if(_create)
+		{
+			m_header = new (data) Header();
+			m_header->magic = g_magic;
+			m_header->version = g_version;
+			m_header->request.store(_firstRequest, std::memory_order_relaxed);
+			m_header->reply.store(_firstRequest, std::memory_order_relaxed);
+			m_header->waiters.store(0, std::memory_order_relaxed);
+			m_header->closed.store(0, std::memory_order_release);
+			m_header->numSamples = 0;
+			m_header->midiInSize = 0;
+			m_header->midiOutSize = 0;
+		}
+		else
+		{
+			m_header = reinterpret_cast<Header*>(data);
+
+			if(m_header->magic != g_magic || m_header->version != g_version || m_header->closed.load(std::memory_order_acquire))
+			{
+				m_header = nullptr;
+				m_shm.close();
+				return false;
+			}
+		}
+
+#ifdef _WIN32
+		// there is no futex that works across processes, wait on named events instead. Auto reset, a wakeup may be left
+		// over if the waiter has seen the new value before it went to sleep, which only results in another poll
+		const char* suffixes[] = {"Req", "Rep"};
+
+		for(size_t i=0; i<std::size(m_events); ++i)
+		{
+			const auto name = getEventName(m_shm.getName(), suffixes[i]);
+
+			m_events[i] = _create ? CreateEventA(nullptr, FALSE, FALSE, name.c_str()) : OpenEventA(EVENT_MODIFY_STATE | SYNCHRONIZE, FALSE, name.c_str());
+
+			if(!m_events[i])
+			{
+				close();
+				return false;
+			}
+		}
+#endif
+		m_audioIn = reinterpret_cast<float*>(data + g_offsetAudioIn);
+		m_audioOut = reinterpret_cast<float*>(data + g_offsetAudioOut);
+		m_midiIn = data + g_offsetMidiIn;
+		m_midiOut = data + g_offsetMidiOut;
+
+		m_request = m_header->request.load(std::memory_order_acquire);
+		m_requestPending = false;
+
+		return true;
+	}
+
+	SharedAudio::WaitResult SharedAudio::wait(std::atomic<uint32_t>& _value, const uint32_t _expected, const uint32_t _timeoutMs) const
+	{
+		const auto& closed = m_header->closed;
+
+		for(uint32_t i=0; i<g_spinCount; ++i)
+		{
+			if(_value.load(std::memory_order_acquire) != _expected)
+				return WaitResult::Ready;
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		const auto end = start + std::chrono::milliseconds(_timeoutMs);
+
+		while(true)
+		{
+			if(_value.load(std::memory_order_acquire) != _expected)
+				return WaitResult::Ready;
+
+			if(closed.load(std::memory_order_acquire))
+				return WaitResult::Closed;
+
+			const auto now = std::chrono::steady_clock::now();
+
+			if(now >= end)
+				return WaitResult::Timeout;
+
+			// sleep in short slices to notice if the other side has closed the channel
+			const auto remaining = std::min(std::chrono::duration_cast<std::chrono::nanoseconds>(end - now).count(), static_cast<int64_t>(g_maxSleepNs));
+
+			m_header->waiters.fetch_add(1, std::memory_order_seq_cst);
+
+#if defined(_WIN32)
+			// the value may have changed before the waiter count was incremented, in which case no wakeup is sent
+			if(_value.load(std::memory_order_seq_cst) == _expected)
+				WaitForSingleObject(getEvent(_value), static_cast<DWORD>((remaining + 999'999) / 1'000'000));
+#elif defined(__linux__)
+			// not a private futex, the word is shared between processes
+			timespec ts{};
+			ts.tv_sec = static_cast<time_t>(remaining / 1'000'000'000);
+			ts.tv_nsec = static_cast<long>(remaining % 1'000'000'000);
+
+			syscall(SYS_futex, reinterpret_cast<uint32_t*>(&_value), FUTEX_WAIT, _expected, &ts, nullptr, 0);
+#elif defined(__APPLE__)
+			__ulock_wait(g_ulockCompareAndWaitShared, &_value, _expected, static_cast<uint32_t>((remaining + 999) / 1000));
+#else
+			// no OS primitive available that works across processes
+			std::this_thread::sleep_for(std::chrono::microseconds(50));
+#endif
+			m_header->waiters.fetch_sub(1, std::memory_order_seq_cst);
+		}
+	}
+
+	void SharedAudio::wake(std::atomic<uint32_t>& _value) const
+	{
+		if(m_header->waiters.load(std::memory_order_seq_cst) == 0)
+			return;
+
+#if defined(_WIN32)
+		SetEvent(getEvent(_value));
+#elif defined(__linux__)
+		syscall(SYS_futex, reinterpret_cast<uint32_t*>(&_value), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#elif defined(__APPLE__)
+		__ulock_wake(g_ulockCompareAndWaitShared | g_ulockWakeAll, &_value, 0);
+#else
+		(void)_value;
+#endif
+	}
+
+#ifdef _WIN32
+	void* SharedAudio::getEvent(const std::atomic<uint32_t>& _value) const
+	{
+		return &_value == &m_header->request ? m_events[0] : m_events[1];
+	}
+#endif
+
+	size_t SharedAudio::writeMidi(uint8_t* _dst, uint32_t& _size, const std::vector<synthLib::SMidiEvent>& _events)
+	{
+		size_t pos = 0;
+		size_t count = 0;
+
+		for (const auto& ev : _events)
+		{
+			if(pos + getMidiSize(ev) > MidiBufferSize)
+				break;
+
+			const auto sysexSize = static_cast<uint32_t>(ev.sysex.size());
+
+			_dst[pos++] = ev.a;
+			_dst[pos++] = ev.b;
+			_dst[pos++] = ev.c;
+			_dst[pos++] = static_cast<uint8_t>(ev.source);
+			memcpy(_dst + pos, &ev.offset, sizeof(uint32_t));	pos += sizeof(uint32_t);
+			memcpy(_dst + pos, &sysexSize, sizeof(uint32_t));	pos += sizeof(uint32_t);
+
+			if(sysexSize)
+			{
+				memcpy(_dst + pos, ev.sysex.data(), sysexSize);
+				pos += sysexSize;
+			}
+
+			++count;
+		}
+
+		_size = static_cast<uint32_t>(pos);
+		return count;
+	}
+
+	void SharedAudio::readMidi(std::vector<synthLib::SMidiEvent>& _dst, const uint8_t* _src, const uint32_t _size)
+	{
+		const size_t size = std::min(_size, MidiBufferSize);
+		size_t pos = 0;
+
+		while(pos + g_midiEventHeaderSize <= size)
+		{
+			auto& ev = _dst.emplace_back(static_cast<synthLib::MidiEventSource>(_src[pos + 3]), _src[pos], _src[pos + 1], _src[pos + 2]);
+			pos += 4;
+
+			uint32_t sysexSize;
+			memcpy(&ev.offset, _src + pos, sizeof(uint32_t));	pos += sizeof(uint32_t);
+			memcpy(&sysexSize, _src + pos, sizeof(uint32_t));	pos += sizeof(uint32_t);
+
+			if(sysexSize > size - pos)
+			{
+				_dst.pop_back();
+				return;
+			}
+
+			ev.sysex.assign(_src + pos, _src + pos + sysexSize);
+			pos += sysexSize;
+		}
+	}
+
+	size_t SharedAudio::getMidiSize(const synthLib::SMidiEvent& _ev)
+	{
+		return g_midiEventHeaderSize + _ev.sysex.size();
+	}
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "sharedMemory.h"
+
+#include "synthLib/audioTypes.h"
+#include "synthLib/midiTypes.h"
+
+namespace bridgeLib
+{
+	// Audio and MIDI transport between a client and a server that run on the same machine. Both sides map the same
+	// shared memory. The client writes a block of input audio and MIDI, the server processes it and writes output
+	// audio and MIDI back. No system call is needed unless one side has to wait.
+	// Control commands are still sent via TCP
+	class SharedAudio
+	{
+	public:
+		static constexpr uint32_t MaxSamples = 8192;
+		static constexpr uint32_t MaxChannelsIn = std::tuple_size_v<synthLib::TAudioInputs>;
+		static constexpr uint32_t MaxChannelsOut = std::tuple_size_v<synthLib::TAudioOutputs>;
+		static constexpr uint32_t MidiBufferSize = 64 * 1024;
+
+		enum class WaitResult
+		{
+			Ready,
+			Timeout,
+			Closed
+		};
+
+		SharedAudio() = default;
+		~SharedAudio();
+
+		SharedAudio(const SharedAudio&) = delete;
+		SharedAudio(SharedAudio&&) = delete;
+		SharedAudio& operator = (const SharedAudio&) = delete;
+		SharedAudio& operator = (SharedAudio&&) = delete;
+
+		bool create(uint32_t _firstRequest = 0);	// client. Tests start close to the wraparound of the request counter
+		bool open(const std::string& _name);		// server
+		void close();
+
+		bool isValid() const { return m_header != nullptr; }
+		const std::string& getName() const { return m_shm.getName(); }
+		static size_t getSize();
+
+		// false if an event is too large, it needs to be sent via TCP
+		static bool fitsMidiBuffer(const synthLib::SMidiEvent& _ev);
+
+		// client. Input may only be written if no request is pending
+		float* getInput(uint32_t _channel) const;
+		const float* getOutput(uint32_t _channel) const;
+		size_t sendRequest(uint32_t _numSamples, const std::vector<synthLib::SMidiEvent>& _midiIn);	// returns the number of MIDI events that fit
+		bool isRequestPending() const { return m_requestPending; }
+		bool isReplyReady() const;
+		WaitResult waitForReply(uint32_t _timeoutMs);
+		void readMidiOut(std::vector<synthLib::SMidiEvent>& _midiOut) const;
+
+		// server
+		WaitResult waitForRequest(uint32_t _timeoutMs) const;
+		uint32_t getRequestSize() const;
+		void getAudioBuffers(synthLib::TAudioInputs& _inputs, synthLib::TAudioOutputs& _outputs) const;
+		void readMidiIn(std::vector<synthLib::SMidiEvent>& _midiIn) const;
+		size_t sendReply(const std::vector<synthLib::SMidiEvent>& _midiOut);	// returns the number of MIDI events that fit
+
+	private:
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t version;
+
+			std::atomic<uint32_t> request;		// incremented by the client when a block is ready to be processed
+			std::atomic<uint32_t> reply;		// set to request by the server when the block has been processed
+			std::atomic<uint32_t> closed;
+			std::atomic<uint32_t> waiters;		// number of threads sleeping in the OS, wakeups are skipped if there are none
+
+			uint32_t numSamples;
+			uint32_t midiInSize;
+			uint32_t midiOutSize;
+		};
+
+		bool init(bool _create, uint32_t _firstRequest = 0);
+
+		WaitResult wait(std::atomic<uint32_t>& _value, uint32_t _expected, uint32_t _timeoutMs) const;
+		void wake(std::atomic<uint32_t>& _value) const;
+#ifdef _WIN32
+		void* getEvent(const std::atomic<uint32_t>& _value) const;
+#endif
+
+		static size_t writeMidi(uint8_t* _dst, uint32_t& _size, const std::vector<synthLib::SMidiEvent>& _events);
+		static void readMidi(std::vector<synthLib::SMidiEvent>& _dst, const uint8_t* _src, uint32_t _size);
+		static size_t getMidiSize(const synthLib::SMidiEvent& _ev);
+
+		SharedMemory m_shm;
+		Header* m_header = nullptr;
+		float* m_audioIn = nullptr;
+		float* m_audioOut = nullptr;
+		uint8_t* m_midiIn = nullptr;
+		uint8_t* m_midiOut = nullptr;
+
+		uint32_t m_request = 0;
+		bool m_requestPending = false;
+
+#ifdef _WIN32
+		void* m_events[2] = {nullptr, nullptr};	// request, reply
+#endif
+	};
+}
@@ -0,0 +1,144 @@
+#include "sharedMemory.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#define NOSERVICE
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "networkLib/logging.h"
+
+namespace bridgeLib
+{
+	SharedMemory::~SharedMemory()
+	{
+		close();
+	}
+
+	bool SharedMemory::create(const std::string& _name, const size_t _size)
+	{
+		return map(_name, _size, true);
+	}
+
+	bool SharedMemory::open(const std::string& _name, const size_t _size)
+	{
+		return map(_name, _size, false);
+	}
+
+	void SharedMemory::close()
+	{
+#ifdef _WIN32
+		if(m_data)
+			UnmapViewOfFile(m_data);
+		if(m_handle)
+			CloseHandle(m_handle);
+		m_handle = nullptr;
+#else
+		if(m_data)
+			munmap(m_data, m_size);
+		if(m_owner)
+			shm_unlink(('/' + m_name).c_str());
+#endif
+		m_data = nullptr;
+		m_size = 0;
+		m_owner = false;
+		m_name.clear();
+	}
+
+	bool SharedMemory::map(const std::string& _name, const size_t _size, const bool _create)
+	{
+		close();
+
+#ifdef _WIN32
+		const auto name = "Local\\" + _name;
+
+		HANDLE handle;
+
+		if(_create)
+		{
+			handle = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+				static_cast<DWORD>(static_cast<uint64_t>(_size) >> 32), static_cast<DWORD>(_size & 0xffffffff), name.c_str());
+
+			if(handle && GetLastError() == ERROR_ALREADY_EXISTS)
+			{
+				CloseHandle(handle);
+				handle = nullptr;
+			}
+		}
+		else
+		{
+			handle = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+		}
+
+		if(!handle)
+		{
+			LOGNET(networkLib::LogLevel::Warning, "Failed to " << (_create ? "create" : "open") << " shared memory " << _name << ", error " << GetLastError());
+			return false;
+		}
+
+		void* data = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, _size);
+
+		if(!data)
+		{
+			LOGNET(networkLib::LogLevel::Warning, "Failed to map shared memory " << _name << ", error " << GetLastError());
+			CloseHandle(handle);
+			return false;
+		}
+
+		m_handle = handle;
+#else
+		const auto name = '/' + _name;
+
+		const int fd = _create ? shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR) : shm_open(name.c_str(), O_RDWR, 0);
+
+		if(fd < 0)
+		{
+			LOGNET(networkLib::LogLevel::Warning, "Failed to " << (_create ? "create" : "open") << " shared memory " << _name);
+			return false;
+		}
+
+		if(_create && ftruncate(fd, static_cast<off_t>(_size)) != 0)
+		{
+			LOGNET(networkLib::LogLevel::Warning, "Failed to resize shared memory " << _name);
+			::close(fd);
+			shm_unlink(name.c_str());
+			return false;
+		}
+
+		if(!_create)
+		{
+			struct stat st{};
+
+			if(fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < _size)
+			{
+				LOGNET(networkLib::LogLevel::Warning, "Shared memory " << _name << " is smaller than expected");
+				::close(fd);
+				return false;
+			}
+		}
+
+		void* data = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+		// the mapping stays valid after the descriptor has been closed
+		::close(fd);
+
+		if(data == MAP_FAILED)
+		{
+			LOGNET(networkLib::LogLevel::Warning, "Failed to map shared memory " << _name);
+			if(_create)
+				shm_unlink(name.c_str());
+			return false;
+		}
+#endif
+		m_data = data;
+		m_size = _size;
+		m_owner = _create;
+		m_name = _name;
+		return true;
+	}
+}
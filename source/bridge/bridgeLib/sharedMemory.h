@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace bridgeLib
+{
+	// Named memory region that can be mapped by multiple processes on the same machine
+	class SharedMemory
+	{
+	public:
+		SharedMemory() = default;
+		~SharedMemory();
+
+		SharedMemory(const SharedMemory&) = delete;
+		SharedMemory(SharedMemory&&) = delete;
+		SharedMemory& operator = (const SharedMemory&) = delete;
+		SharedMemory& operator = (SharedMemory&&) = delete;
+
+		bool create(const std::string& _name, size_t _size);
+		bool open(const std::string& _name, size_t _size);
+		void close();
+
+		bool isValid() const { return m_data != nullptr; }
+		void* data() const { return m_data; }
+		size_t size() const { return m_size; }
+		const std::string& getName() const { return m_name; }
+
+	private:
+		bool map(const std::string& _name, size_t _size, bool _create);
+
+		std::string m_name;
+		void* m_data = nullptr;
+		size_t m_size = 0;
+		bool m_owner = false;
+
+#ifdef _WIN32
+		void* m_handle = nullptr;
+#endif
+	};
+}
@@ -40,6 +40,9 @@ namespace bridgeLib
 		case Command::SetSamplerate:		handleStruct<SetSamplerate>(_in); break;
 		case Command::SetDspClockPercent:	handleStruct<SetDspClockPercent>(_in); break;
 		case Command::SetUnknownCustomData:	handleStruct<SetUnknownCustomData>(_in); break;
+		case Command::SharedAudio:			handleStruct<SharedAudioDesc>(_in); break;
+		case Command::SessionStats:			handleStruct<SessionStats>(_in); break;
+		case Command::RequestSessionStats:	handleRequestSessionStats(); break;
 		}
 	}
 
@@ -92,19 +95,10 @@ namespace bridgeLib
 		s.write(static_cast<uint8_t>(_numChannels));
 		s.write(_numSamplesPerChannel);
 
+		// channels are encoded straight from the device buffers into the command stream
 		for(uint32_t i=0; i<_numChannels; ++i)
-		{
-			// if a channel has data, write it. If not, write 0 for the length
-			if(const float* channelData = _data[i])
-			{
-				s.write(_numSamplesPerChannel);
-				s.write(channelData, _numSamplesPerChannel);
-			}
-			else
-			{
-				s.write(0);
-			}
-		}
+			m_audioCodec.write(s, _data[i], _numSamplesPerChannel);
+
 		send();
 	}
 
@@ -120,8 +114,7 @@ namespace bridgeLib
 		for(uint32_t i=0; i<_numChannels; ++i)
 		{
 			_buffers.readInput(i, m_audioTransferBuffer, _numSamplesPerChannel);
-			s.write(_numSamplesPerChannel);
-			s.write(m_audioTransferBuffer.data(), _numSamplesPerChannel);
+			m_audioCodec.write(s, m_audioTransferBuffer.data(), _numSamplesPerChannel);
 		}
 
 		_buffers.onInputRead(_numSamplesPerChannel);
@@ -135,14 +128,8 @@ namespace bridgeLib
 		const uint32_t numSamplesMax = _in.read<uint32_t>();
 
 		for(uint32_t i=0; i<numChannels; ++i)
-		{
-			const auto numSamples = _in.read<uint32_t>();
-			if(numSamples)
-			{
-				assert(_output[i]);
-				_in.read(_output[i], numSamples);
-			}
-		}
+			m_audioCodec.read(_in, _output[i], numSamplesMax);
+
 		return numSamplesMax;
 	}
 
@@ -151,17 +138,15 @@ namespace bridgeLib
 		const uint32_t numChannels = _in.read<uint8_t>();
 		const uint32_t numSamplesMax = _in.read<uint32_t>();
 
+		if(m_audioTransferBuffer.size() < numSamplesMax)
+			m_audioTransferBuffer.resize(numSamplesMax);
+
 		for(uint32_t i=0; i<numChannels; ++i)
 		{
-			const auto numSamples = _in.read<uint32_t>();
+			const auto numSamples = m_audioCodec.read(_in, m_audioTransferBuffer.data(), numSamplesMax);
 
 			if(numSamples)
-			{
-				if(m_audioTransferBuffer.size() < numSamples)
-					m_audioTransferBuffer.resize(numSamples);
-				_in.read(m_audioTransferBuffer.data(), numSamples);
 				_buffers.writeOutput(i, m_audioTransferBuffer, numSamples);
-			}
 		}
 		_buffers.onOutputWritten(numSamplesMax);
 	}
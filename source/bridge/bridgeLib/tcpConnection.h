@@ -1,5 +1,6 @@
 #pragma once
 
+#include "audioCodec.h"
 #include "commandReader.h"
 #include "commandWriter.h"
 
@@ -52,6 +53,8 @@ namespace bridgeLib
 		virtual void handleData(const SetDspClockPercent& _params) {}
 		virtual void handleData(const SetUnknownCustomData& _params) {}
 		virtual void handleData(const Error& _error) {}
+		virtual void handleData(const SharedAudioDesc& _desc) {}
+		virtual void handleData(const SessionStats& _stats) {}
 
 		virtual void handleDeviceInfo(baseLib::BinaryStream& _in);
 
@@ -63,10 +66,13 @@ namespace bridgeLib
 		// AUDIO
 		void sendAudio(const float* const* _data, uint32_t _numChannels, uint32_t _numSamplesPerChannel);
 		void sendAudio(AudioBuffers& _buffers, uint32_t _numChannels, uint32_t _numSamplesPerChannel);
-		static uint32_t handleAudio(float* const* _output, baseLib::BinaryStream& _in);
+		uint32_t handleAudio(float* const* _output, baseLib::BinaryStream& _in);
 		void handleAudio(AudioBuffers& _buffers, baseLib::BinaryStream& _in);
 		virtual void handleAudio(baseLib::BinaryStream& _in);
 
+		// SESSION STATS
+		virtual void handleRequestSessionStats() {}
+
 		// DEVICE STATE
 		virtual void handleRequestDeviceState(baseLib::BinaryStream& _in);
 		virtual void handleRequestDeviceState(bridgeLib::RequestDeviceState& _requestDeviceState) {}
@@ -75,6 +81,8 @@ namespace bridgeLib
 		const auto& getDeviceState() const { return m_deviceState; }
 		auto& getDeviceState() { return m_deviceState; }
 
+		auto& getAudioCodec() { return m_audioCodec; }
+
 	protected:
 		template<typename T>
 		void handleStruct(baseLib::BinaryStream& _in)
@@ -101,6 +109,7 @@ namespace bridgeLib
 		synthLib::SMidiEvent m_midiEvent;	// preallocated for receiver
 
 		std::vector<float> m_audioTransferBuffer;
+		AudioCodec m_audioCodec;
 
 		DeviceState m_deviceState;
 	};
@@ -9,7 +9,7 @@ namespace bridgeLib
 	static constexpr uint32_t g_udpServerPort   = 56303;
 	static constexpr uint32_t g_tcpServerPort   = 56362;
 
-	static constexpr uint32_t g_protocolVersion = 1'00'03;
+	static constexpr uint32_t g_protocolVersion = 1'00'06;
 
 	using SessionId = uint64_t;
 
@@ -0,0 +1,396 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "bridgeLib/audioCodec.h"
+#include "bridgeLib/sharedAudio.h"
+
+#include "baseLib/binarystream.h"
+
+using namespace bridgeLib;
+
+// Custom assertion that works in both Debug and Release builds
+#define TEST_ASSERT(condition) \
+	do { \
+		if (!(condition)) { \
+			std::ostringstream oss; \
+			oss << "Test assertion failed: " << #condition \
+			    << " at " << __FILE__ << ":" << __LINE__; \
+			throw std::runtime_error(oss.str()); \
+		} \
+	} while (0)
+
+namespace
+{
+	constexpr uint32_t g_channelCount = 12;
+	constexpr uint32_t g_blockSize = 64;
+
+	const char* getCodecName(const AudioCodecType _type)
+	{
+		switch (_type)
+		{
+		case AudioCodecType::Float32:		return "Float32";
+		case AudioCodecType::Int24:			return "Int24";
+		case AudioCodecType::Int24Delta:	return "Int24Delta";
+		default:							return "?";
+		}
+	}
+
+	// DSP output is 24 bit, a few channels are silent as they are for most presets
+	std::vector<std::vector<float>> createInput(const uint32_t _sampleCount)
+	{
+		std::vector<std::vector<float>> channels(g_channelCount, std::vector<float>(_sampleCount, 0.0f));
+
+		for(uint32_t c=0; c<g_channelCount; c += 2)
+		{
+			for(uint32_t i=0; i<_sampleCount; ++i)
+			{
+				const auto v = 0.5f * std::sin(static_cast<float>(i) * 0.01f * static_cast<float>(c + 1));
+				channels[c][i] = std::round(v * 8388608.0f) / 8388608.0f;
+			}
+		}
+		return channels;
+	}
+
+	// encodes one block of all channels like TcpConnection::sendAudio and returns the serialized data
+	void encode(std::vector<uint8_t>& _dst, AudioCodec& _codec, const std::vector<std::vector<float>>& _channels, const uint32_t _offset)
+	{
+		baseLib::BinaryStream s;
+		for (const auto& c : _channels)
+			_codec.write(s, c.data() + _offset, g_blockSize);
+		s.toVector(_dst);
+	}
+
+	void decode(std::vector<std::vector<float>>& _channels, AudioCodec& _codec, const std::vector<uint8_t>& _data, const uint32_t _offset)
+	{
+		baseLib::BinaryStream s(_data);
+		for (auto& c : _channels)
+			TEST_ASSERT(_codec.read(s, c.data() + _offset, g_blockSize) == g_blockSize);
+	}
+
+	// long enough for the other side to stop polling and sleep in the OS
+	constexpr auto g_sharedAudioSleep = std::chrono::milliseconds(5);
+
+	// server side of the loopback: every output channel is an input channel plus the channel index, MIDI is echoed
+	void runSharedAudioServer(SharedAudio& _server, const std::atomic<bool>& _delayReply)
+	{
+		synthLib::TAudioInputs inputs;
+		synthLib::TAudioOutputs outputs;
+		std::vector<synthLib::SMidiEvent> midi;
+
+		while (_server.waitForRequest(1000) == SharedAudio::WaitResult::Ready)
+		{
+			_server.getAudioBuffers(inputs, outputs);
+
+			const auto numSamples = _server.getRequestSize();
+
+			for(uint32_t c=0; c<SharedAudio::MaxChannelsOut; ++c)
+			{
+				for(uint32_t i=0; i<numSamples; ++i)
+					outputs[c][i] = inputs[c % SharedAudio::MaxChannelsIn][i] + static_cast<float>(c);
+			}
+
+			midi.clear();
+			_server.readMidiIn(midi);
+
+			if (_delayReply)
+				std::this_thread::sleep_for(g_sharedAudioSleep);
+
+			_server.sendReply(midi);
+		}
+	}
+
+	// sends one block and returns the time until the reply has arrived
+	std::chrono::duration<double> sendSharedAudioBlock(SharedAudio& _client, const uint32_t _numSamples, const std::vector<synthLib::SMidiEvent>& _midiIn)
+	{
+		const auto start = std::chrono::steady_clock::now();
+
+		TEST_ASSERT(_client.sendRequest(_numSamples, _midiIn) == _midiIn.size());
+		TEST_ASSERT(_client.waitForReply(1000) == SharedAudio::WaitResult::Ready);
+
+		return std::chrono::steady_clock::now() - start;
+	}
+
+	double getMedian(std::vector<double>& _values)
+	{
+		std::sort(_values.begin(), _values.end());
+		return _values[_values.size() >> 1];
+	}
+}
+
+void testAudioCodecRoundtrip()
+{
+	std::cout << "Testing AudioCodec roundtrip..." << std::endl;
+
+	const auto input = createInput(g_blockSize * 16);
+
+	for(uint32_t t=0; t<static_cast<uint32_t>(AudioCodecType::Count); ++t)
+	{
+		AudioCodec encoder;
+		AudioCodec decoder;
+		encoder.setType(static_cast<AudioCodecType>(t));
+
+		auto output = input;
+		for (auto& c : output)
+			std::fill(c.begin(), c.end(), 1.0f);
+
+		std::vector<uint8_t> data;
+
+		for(uint32_t offset=0; offset<input[0].size(); offset += g_blockSize)
+		{
+			encode(data, encoder, input, offset);
+			decode(output, decoder, data, offset);
+		}
+
+		// all codecs are lossless for 24 bit data
+		TEST_ASSERT(output == input);
+	}
+
+	// Float32 is lossless for any data
+	{
+		std::vector<std::vector<float>> input2(g_channelCount, std::vector<float>(g_blockSize, 0.1234567f));
+		auto output = input2;
+
+		AudioCodec codec;
+		TEST_ASSERT(codec.getType() == AudioCodecType::Float32);
+
+		std::vector<uint8_t> data;
+		encode(data, codec, input2, 0);
+		decode(output, codec, data, 0);
+		TEST_ASSERT(output == input2);
+	}
+
+	std::cout << "  AudioCodec roundtrip tests passed!" << std::endl;
+}
+
+void testAudioCodecInvalidData()
+{
+	std::cout << "Testing AudioCodec with invalid data..." << std::endl;
+
+	// a delta encoded channel that claims to have far more data than the samples can ever need
+	baseLib::BinaryStream s;
+	s.write(static_cast<uint8_t>(4));	// Format::Int24Delta
+	s.write(g_blockSize);
+	s.write(static_cast<uint32_t>(0xffffffff));
+
+	std::vector<uint8_t> data;
+	s.toVector(data);
+
+	std::vector<float> output(g_blockSize);
+
+	AudioCodec codec;
+	baseLib::BinaryStream in(data);
+
+	bool thrown = false;
+	try
+	{
+		codec.read(in, output.data(), g_blockSize);
+	}
+	catch(std::range_error&)
+	{
+		thrown = true;
+	}
+	TEST_ASSERT(thrown);
+
+	std::cout << "  AudioCodec invalid data tests passed!" << std::endl;
+}
+
+void benchmarkAudioCodecLoopback()
+{
+	std::cout << "Benchmarking AudioCodec loopback, " << g_channelCount << " channels, " << g_blockSize << " samples per block..." << std::endl;
+
+	constexpr uint32_t blockCount = 20000;
+
+	const auto input = createInput(g_blockSize * blockCount);
+	auto output = input;
+
+	for(uint32_t t=0; t<static_cast<uint32_t>(AudioCodecType::Count); ++t)
+	{
+		const auto type = static_cast<AudioCodecType>(t);
+
+		AudioCodec encoder;
+		AudioCodec decoder;
+		encoder.setType(type);
+
+		std::vector<uint8_t> data;
+		size_t totalBytes = 0;
+
+		const auto start = std::chrono::steady_clock::now();
+
+		for(uint32_t b=0; b<blockCount; ++b)
+		{
+			encode(data, encoder, input, b * g_blockSize);
+			decode(output, decoder, data, b * g_blockSize);
+			totalBytes += data.size();
+		}
+
+		const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+
+		TEST_ASSERT(output == input);
+
+		std::cout << "  " << getCodecName(type) << ": " << (static_cast<double>(totalBytes) / blockCount) << " bytes per block, "
+			<< (duration.count() * 1e6 / blockCount) << " us per block" << std::endl;
+	}
+}
+
+void testSharedAudioLoopback()
+{
+	std::cout << "Testing SharedAudio loopback..." << std::endl;
+
+	constexpr uint32_t blockCount = 300;
+	constexpr uint32_t blockSizes[] = {1, 64, 333, SharedAudio::MaxSamples};
+
+	SharedAudio client;
+	SharedAudio server;
+
+	// the request counter wraps around after a third of the blocks
+	TEST_ASSERT(client.create(std::numeric_limits<uint32_t>::max() - blockCount / 3));
+	TEST_ASSERT(server.open(client.getName()));
+
+	std::atomic<bool> delayReply = false;
+
+	std::thread serverThread([&]
+	{
+		runSharedAudioServer(server, delayReply);
+	});
+
+	std::vector<synthLib::SMidiEvent> midiIn;
+	std::vector<synthLib::SMidiEvent> midiOut;
+
+	std::vector<double> clientWakeups;
+	std::vector<double> serverWakeups;
+
+	for(uint32_t b=0; b<blockCount; ++b)
+	{
+		const auto numSamples = blockSizes[b % std::size(blockSizes)];
+
+		for(uint32_t c=0; c<SharedAudio::MaxChannelsIn; ++c)
+		{
+			auto* in = client.getInput(c);
+			for(uint32_t i=0; i<numSamples; ++i)
+				in[i] = static_cast<float>(b * 16 + c * 100000 + i);
+		}
+
+		midiIn.clear();
+		auto& ev = midiIn.emplace_back(synthLib::MidiEventSource::Host, synthLib::M_NOTEON, static_cast<uint8_t>(b & 0x7f), 100);
+		ev.offset = b;
+		if ((b % 10) == 0)
+		{
+			auto& sysex = midiIn.emplace_back(synthLib::MidiEventSource::Host).sysex;
+			sysex.assign(b + 2, static_cast<uint8_t>(b & 0x7f));
+			sysex.front() = synthLib::M_STARTOFSYSEX;
+			sysex.back() = synthLib::M_ENDOFSYSEX;
+		}
+
+		// the client has to be woken up by the server
+		if ((b % 10) == 5)
+		{
+			delayReply = true;
+			const auto time = sendSharedAudioBlock(client, numSamples, midiIn);
+			delayReply = false;
+			clientWakeups.push_back(std::chrono::duration<double>(time - g_sharedAudioSleep).count());
+		}
+		// the server has to be woken up by the client
+		else if ((b % 10) == 7)
+		{
+			std::this_thread::sleep_for(g_sharedAudioSleep);
+			serverWakeups.push_back(sendSharedAudioBlock(client, numSamples, midiIn).count());
+		}
+		else
+		{
+			sendSharedAudioBlock(client, numSamples, midiIn);
+		}
+
+		for(uint32_t c=0; c<SharedAudio::MaxChannelsOut; ++c)
+		{
+			const auto* in = client.getInput(c % SharedAudio::MaxChannelsIn);
+			const auto* out = client.getOutput(c);
+			for(uint32_t i=0; i<numSamples; ++i)
+				TEST_ASSERT(out[i] == in[i] + static_cast<float>(c));
+		}
+
+		midiOut.clear();
+		client.readMidiOut(midiOut);
+
+		TEST_ASSERT(midiOut.size() == midiIn.size());
+		for(size_t i=0; i<midiIn.size(); ++i)
+		{
+			TEST_ASSERT(midiOut[i].a == midiIn[i].a && midiOut[i].b == midiIn[i].b && midiOut[i].c == midiIn[i].c);
+			TEST_ASSERT(midiOut[i].offset == midiIn[i].offset && midiOut[i].source == midiIn[i].source);
+			TEST_ASSERT(midiOut[i].sysex == midiIn[i].sysex);
+		}
+	}
+
+	client.close();
+	serverThread.join();
+
+	// a missing wakeup is only noticed when the sleeping side polls again after 10 ms
+	const auto clientWakeup = getMedian(clientWakeups);
+	const auto serverWakeup = getMedian(serverWakeups);
+
+	std::cout << "  Wakeup latency: client " << clientWakeup * 1e6 << " us, server " << serverWakeup * 1e6 << " us" << std::endl;
+
+	TEST_ASSERT(clientWakeup < 0.002);
+	TEST_ASSERT(serverWakeup < 0.002);
+
+	std::cout << "  SharedAudio loopback tests passed!" << std::endl;
+}
+
+void benchmarkSharedAudioLoopback()
+{
+	std::cout << "Benchmarking SharedAudio loopback, " << g_blockSize << " samples per block..." << std::endl;
+
+	constexpr uint32_t blockCount = 20000;
+
+	SharedAudio client;
+	SharedAudio server;
+
+	TEST_ASSERT(client.create());
+	TEST_ASSERT(server.open(client.getName()));
+
+	const std::atomic<bool> delayReply = false;
+
+	std::thread serverThread([&]
+	{
+		runSharedAudioServer(server, delayReply);
+	});
+
+	const std::vector<synthLib::SMidiEvent> midiIn;
+	std::vector<double> times;
+	times.reserve(blockCount);
+
+	for(uint32_t b=0; b<blockCount; ++b)
+		times.push_back(sendSharedAudioBlock(client, g_blockSize, midiIn).count());
+
+	client.close();
+	serverThread.join();
+
+	std::cout << "  Round trip: median " << getMedian(times) * 1e6 << " us, 99th percentile " << times[times.size() * 99 / 100] * 1e6 << " us" << std::endl;
+}
+
+int main()
+{
+	try
+	{
+		testAudioCodecRoundtrip();
+		testAudioCodecInvalidData();
+		benchmarkAudioCodecLoopback();
+		testSharedAudioLoopback();
+		benchmarkSharedAudioLoopback();
+
+		std::cout << "All tests passed!" << std::endl;
+		return 0;
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "Test failed: " << e.what() << std::endl;
+		return 1;
+	}
+}
@@ -31,6 +31,11 @@ namespace bridgeClient
 		case bridgeLib::Command::RequestRom:
 			sendDeviceCreateParams(true);
 			break;
+		case bridgeLib::Command::SharedAudio:
+		case bridgeLib::Command::SessionStats:
+			TcpConnection::handleCommand(_command, _in);
+			m_handleReplyFunc(_command, _in);
+			break;
 		default:
 			TcpConnection::handleCommand(_command, _in);
 			break;
@@ -40,9 +45,15 @@ namespace bridgeClient
 	void DeviceConnection::handleData(const bridgeLib::DeviceDesc& _desc)
 	{
 		m_deviceDesc = _desc;
+		getAudioCodec().setType(bridgeLib::AudioCodec::sanitize(_desc.audioCodec));
 		m_device.onBootFinished(_desc);
 	}
 
+	void DeviceConnection::handleData(const bridgeLib::SharedAudioDesc& _desc)
+	{
+		m_sharedAudioAccepted = _desc.accepted && _desc.name == m_sharedAudio.getName();
+	}
+
 	void DeviceConnection::handleDeviceInfo(baseLib::BinaryStream& _in)
 	{
 		TcpConnection::handleDeviceInfo(_in);
@@ -65,6 +76,9 @@ namespace bridgeClient
 
 	bool DeviceConnection::processAudio(const synthLib::TAudioInputs& _inputs, const synthLib::TAudioOutputs& _outputs, const uint32_t _size, const uint32_t _latency)
 	{
+		if(m_sharedAudio.isValid())
+			return processAudioShared(_inputs, _outputs, _size, _latency);
+
 		m_audioBuffers.writeInput(_inputs, _size);
 
 		std::unique_lock lock(m_cvWaitMutex);
@@ -115,13 +129,135 @@ namespace bridgeClient
 		m_cvWait.notify_one();
 	}
 
+	bool DeviceConnection::openSharedAudio()
+	{
+		if(!m_sharedAudio.create())
+			return false;
+
+		m_sharedAudioAccepted = false;
+
+		sendAwaitReply([this]
+		{
+			bridgeLib::SharedAudioDesc desc;
+			desc.name = m_sharedAudio.getName();
+			desc.size = bridgeLib::SharedAudio::getSize();
+			send(bridgeLib::Command::SharedAudio, desc);
+		}, [](baseLib::BinaryStream&)
+		{
+		}, bridgeLib::Command::SharedAudio);
+
+		if(m_sharedAudioAccepted)
+		{
+			LOG("Using shared memory for audio transfer");
+			return true;
+		}
+
+		m_sharedAudio.close();
+		return false;
+	}
+
+	bool DeviceConnection::processAudioShared(const synthLib::TAudioInputs& _inputs, const synthLib::TAudioOutputs& _outputs, const uint32_t _size, const uint32_t _latency)
+	{
+		m_audioBuffers.writeInput(_inputs, _size);
+
+		m_audioBuffers.setLatency(_latency, m_audioBuffers.getOutputSize() >= _size ? 0 : _size);
+
+		// Only one block can be in flight. Collect the previous one if it is done already or if its output is needed
+		// now, otherwise the input keeps accumulating and is sent with the next request
+		if(m_sharedAudio.isRequestPending() && (m_sharedAudio.isReplyReady() || m_audioBuffers.getOutputSize() < _size))
+		{
+			if(!receiveAudioShared())
+				return false;
+		}
+
+		if(!m_sharedAudio.isRequestPending() && m_audioBuffers.getInputSize() > 0)
+		{
+			sendAudioShared();
+
+			if(m_audioBuffers.getOutputSize() < _size && !receiveAudioShared())
+				return false;
+		}
+
+		m_audioBuffers.readOutput(_outputs, _size);
+		return true;
+	}
+
+	void DeviceConnection::sendAudioShared()
+	{
+		const auto numSamples = std::min(m_audioBuffers.getInputSize(), bridgeLib::SharedAudio::MaxSamples);
+		const auto numChannels = std::min(m_device.getChannelCountIn(), bridgeLib::SharedAudio::MaxChannelsIn);
+
+		for(uint32_t i=0; i<numChannels; ++i)
+			m_audioBuffers.readInput(i, m_sharedAudio.getInput(i), numSamples);
+
+		m_audioBuffers.onInputRead(numSamples);
+
+		const auto count = m_sharedAudio.sendRequest(numSamples, m_sharedMidiIn);
+		m_sharedMidiIn.erase(m_sharedMidiIn.begin(), m_sharedMidiIn.begin() + static_cast<ptrdiff_t>(count));
+
+		m_sharedAudioSize = numSamples;
+		m_sharedMidiViaTcp = false;
+	}
+
+	bool DeviceConnection::receiveAudioShared()
+	{
+		const auto res = m_sharedAudio.waitForReply(g_replyTimeoutSecs * 1000);
+
+		if(res != bridgeLib::SharedAudio::WaitResult::Ready)
+		{
+			LOG("Shared audio " << (res == bridgeLib::SharedAudio::WaitResult::Closed ? "closed by server" : "receive timeout") << ", closing connection");
+			m_sharedAudio.close();
+			close();
+			return false;
+		}
+
+		const auto numChannels = std::min(m_device.getChannelCountOut(), bridgeLib::SharedAudio::MaxChannelsOut);
+
+		for(uint32_t i=0; i<numChannels; ++i)
+			m_audioBuffers.writeOutput(i, m_sharedAudio.getOutput(i), m_sharedAudioSize);
+
+		m_audioBuffers.onOutputWritten(m_sharedAudioSize);
+
+		std::scoped_lock lock(m_mutexMidiOut);
+		m_sharedAudio.readMidiOut(m_midiOut);
+		return true;
+	}
+
+	bool DeviceConnection::sendMidi(const synthLib::SMidiEvent& _ev)
+	{
+		if(!m_sharedAudio.isValid())
+			return send(_ev);
+
+		// MIDI is sent with the audio block to keep it in sync. If an event is too large, it goes via TCP and so does
+		// everything else of the current block to preserve the order
+		if(!m_sharedMidiViaTcp && bridgeLib::SharedAudio::fitsMidiBuffer(_ev))
+		{
+			m_sharedMidiIn.push_back(_ev);
+			return true;
+		}
+
+		m_sharedMidiViaTcp = true;
+
+		for (const auto& ev : m_sharedMidiIn)
+		{
+			if(!send(ev))
+				return false;
+		}
+
+		m_sharedMidiIn.clear();
+
+		return send(_ev);
+	}
+
 	void DeviceConnection::handleMidi(const synthLib::SMidiEvent& _e)
 	{
+		std::scoped_lock lock(m_mutexMidiOut);
 		m_midiOut.push_back(_e);
 	}
 
 	void DeviceConnection::readMidiOut(std::vector<synthLib::SMidiEvent>& _midiOut)
 	{
+		std::scoped_lock lock(m_mutexMidiOut);
 		_midiOut.insert(_midiOut.end(), m_midiOut.begin(), m_midiOut.end());
 		m_midiOut.clear();
 	}
@@ -200,6 +336,22 @@ namespace bridgeClient
 		}, bridgeLib::Command::DeviceInfo);
 	}
 
+	bool DeviceConnection::getSessionStats(bridgeLib::SessionStats& _stats)
+	{
+		return sendAwaitReply([this]
+		{
+			send(bridgeLib::Command::RequestSessionStats);
+		}, [&](baseLib::BinaryStream&)
+		{
+			_stats = m_sessionStats;
+		}, bridgeLib::Command::SessionStats);
+	}
+
+	void DeviceConnection::handleData(const bridgeLib::SessionStats& _stats)
+	{
+		m_sessionStats = _stats;
+	}
+
 	bool DeviceConnection::sendAwaitReply(const std::function<void()>& _send, const std::function<void(baseLib::BinaryStream&)>& _reply, const bridgeLib::Command _replyCommand)
 	{
 		bool receiveDone = false;
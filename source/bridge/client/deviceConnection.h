@@ -4,6 +4,7 @@
 #include <condition_variable>
 
 #include "bridgeLib/audioBuffers.h"
+#include "bridgeLib/sharedAudio.h"
 #include "bridgeLib/tcpConnection.h"
 
 #include "synthLib/audioTypes.h"
@@ -22,6 +23,7 @@ namespace bridgeClient
 		void handleCommand(bridgeLib::Command _command, baseLib::BinaryStream& _in) override;
 
 		void handleData(const bridgeLib::DeviceDesc& _desc) override;
+		void handleData(const bridgeLib::SharedAudioDesc& _desc) override;
 		void handleDeviceInfo(baseLib::BinaryStream& _in) override;
 
 		void handleException(const networkLib::NetException& _e) override;
@@ -33,7 +35,11 @@ namespace bridgeClient
 		bool processAudio(const synthLib::TAudioInputs& _inputs, const synthLib::TAudioOutputs& _outputs, uint32_t _size, uint32_t _latency);
 		void handleAudio(baseLib::BinaryStream& _in) override;
 
+		// tries to transfer audio via shared memory, succeeds if the server runs on the same machine
+		bool openSharedAudio();
+
 		// MIDI
+		bool sendMidi(const synthLib::SMidiEvent& _ev);
 		void handleMidi(const synthLib::SMidiEvent& _e) override;
 		void readMidiOut(std::vector<synthLib::SMidiEvent>& _midiOut);
 
@@ -46,19 +52,36 @@ namespace bridgeClient
 		void setStateFromUnknownCustomData(const std::vector<uint8_t>& _state);
 		void setDspClockPercent(uint32_t _percent);
 
+		// SESSION STATS
+		bool getSessionStats(bridgeLib::SessionStats& _stats);
+		void handleData(const bridgeLib::SessionStats& _stats) override;
+
 	private:
+		bool processAudioShared(const synthLib::TAudioInputs& _inputs, const synthLib::TAudioOutputs& _outputs, uint32_t _size, uint32_t _latency);
+		void sendAudioShared();
+		bool receiveAudioShared();
+
 		bool sendAwaitReply(const std::function<void()>& _send, const std::function<void(baseLib::BinaryStream&)>& _reply, bridgeLib::Command _replyCommand);
 
 		RemoteDevice& m_device;
 		bridgeLib::DeviceDesc m_deviceDesc;
+		bridgeLib::SessionStats m_sessionStats;
 
 		std::function<void(bridgeLib::Command, baseLib::BinaryStream&)> m_handleReplyFunc;
 
 		std::mutex m_cvWaitMutex;
 		std::condition_variable m_cvWait;
 
+		// written by the network thread and the audio thread if shared memory is used
+		std::mutex m_mutexMidiOut;
 		std::vector<synthLib::SMidiEvent> m_midiOut;
 
 		bridgeLib::AudioBuffers m_audioBuffers;
+
+		bridgeLib::SharedAudio m_sharedAudio;
+		bool m_sharedAudioAccepted = false;
+		uint32_t m_sharedAudioSize = 0;
+		std::vector<synthLib::SMidiEvent> m_sharedMidiIn;
+		bool m_sharedMidiViaTcp = false;
 	};
 }
@@ -27,7 +27,7 @@ namespace bridgeClient
 
 	RemoteDevice::RemoteDevice(const synthLib::DeviceCreateParams& _params, bridgeLib::PluginDesc&& _desc, const std::string& _host/* = {}*/, uint32_t _port/* = 0*/) : Device(_params), m_pluginDesc(std::move(_desc))
 	{
-		getDeviceCreateParams().romHash = baseLib::MD5(getDeviceCreateParams().romData);
+		getDeviceCreateParams().romHash = getDeviceCreateParams().romData.getHash();
 		getDeviceCreateParams().romName = baseLib::filesystem::getFilenameWithoutPath(getDeviceCreateParams().romName);
 
 		m_pluginDesc.protocolVersion = bridgeLib::g_protocolVersion;
@@ -138,6 +138,14 @@ namespace bridgeClient
 		});
 	} 
 
+	bool RemoteDevice::getSessionStats(bridgeLib::SessionStats& _stats)
+	{
+		return safeCall([&]
+		{
+			return m_connection->getSessionStats(_stats);
+		});
+	}
+
 	void RemoteDevice::onBootFinished(const bridgeLib::DeviceDesc& _desc)
 	{
 		{
@@ -177,7 +185,7 @@ namespace bridgeClient
 	{
 		return safeCall([&]
 		{
-			return m_connection->send(_ev);
+			return m_connection->sendMidi(_ev);
 		});
 	}
 
@@ -284,5 +292,7 @@ namespace bridgeClient
 		m_valid = true;
 
 		LOG("Connection established successfully");
+
+		m_connection->openSharedAudio();
 	}
 }
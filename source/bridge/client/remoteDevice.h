@@ -48,6 +48,9 @@ namespace bridgeClient
 
 		bool setStateFromUnknownCustomData(const std::vector<uint8_t>& _state) override;
 
+		// processing load and deadline misses of this device on the server
+		bool getSessionStats(bridgeLib::SessionStats& _stats);
+
 		void onBootFinished(const bridgeLib::DeviceDesc& _desc);
 		void onDisconnect();
 
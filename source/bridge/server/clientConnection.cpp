@@ -39,6 +39,12 @@ namespace bridgeServer
 		destroyDevice();
 	}
 
+	void ClientConnection::handleCommand(const bridgeLib::Command _command, baseLib::BinaryStream& _in)
+	{
+		std::scoped_lock lock(m_mutexDevice);
+		TcpConnection::handleCommand(_command, _in);
+	}
+
 	void ClientConnection::handleMidi(const synthLib::SMidiEvent& _e)
 	{
 		m_midiIn.push_back(_e);
@@ -47,6 +53,7 @@ namespace bridgeServer
 	void ClientConnection::handleData(const bridgeLib::PluginDesc& _desc)
 	{
 		m_pluginDesc = _desc;
+		getAudioCodec().setType(bridgeLib::AudioCodec::sanitize(_desc.audioCodec));
 		LOGNET(networkLib::LogLevel::Info, "Client " << m_name << " identified as plugin " << _desc.pluginName << ", version " << _desc.pluginVersion);
 		m_name = m_pluginDesc.pluginName + '-' + m_name;
 		createDevice();
@@ -89,7 +96,7 @@ namespace bridgeServer
 		else
 		{
 			// client sent the rom. Validate transmission by comparing hashes
-			const baseLib::MD5 calculatedHash(p.romData);
+			const auto& calculatedHash = p.romData.getHash();
 			if(calculatedHash != p.romHash)
 			{
 				LOGNET(networkLib::LogLevel::Error, "Calculated hash " << calculatedHash.toString() << " of ROM " << p.romName << " does not match sent hash " <<  p.romHash.toString() << ", transfer error");
@@ -107,6 +114,8 @@ namespace bridgeServer
 
 	void ClientConnection::handleAudio(baseLib::BinaryStream& _in)
 	{
+		const auto arrival = Scheduler::Clock::now();
+
 		if(!m_device)
 		{
 			errorClose(bridgeLib::ErrorCode::UnexpectedCommand, "Audio data without valid device");
@@ -115,7 +124,7 @@ namespace bridgeServer
 
 		const auto numSamples = TcpConnection::handleAudio(const_cast<float* const*>(m_audioInputs.data()), _in);
 
-		m_device->process(m_audioInputs, m_audioOutputs, numSamples, m_midiIn, m_midiOut);
+		processAudio(arrival, m_audioInputs, m_audioOutputs, numSamples);
 
 		for (const auto& midiOut : m_midiOut)
 			send(midiOut);
@@ -213,6 +222,146 @@ namespace bridgeServer
 		sendDeviceInfo();
 	}
 
+	void ClientConnection::handleData(const bridgeLib::SharedAudioDesc& _desc)
+	{
+		bridgeLib::SharedAudioDesc reply = _desc;
+		reply.accepted = false;
+
+		// opening fails if the client runs on a different machine, audio is transferred via TCP then
+		if(m_device && !m_sharedAudioThread.joinable() && _desc.size == bridgeLib::SharedAudio::getSize() && m_sharedAudio.open(_desc.name))
+		{
+			LOGNET(networkLib::LogLevel::Info, m_name << ": Using shared memory for audio transfer");
+
+			m_sharedAudioExit = false;
+			m_sharedAudioThread = std::thread([this]
+			{
+				sharedAudioThreadFunc();
+			});
+			m_midiOverflowThread = std::thread([this]
+			{
+				midiOverflowThreadFunc();
+			});
+
+			reply.accepted = true;
+		}
+
+		send(bridgeLib::Command::SharedAudio, reply);
+	}
+
+	void ClientConnection::sharedAudioThreadFunc()
+	{
+		synthLib::TAudioInputs inputs;
+		synthLib::TAudioOutputs outputs;
+		m_sharedAudio.getAudioBuffers(inputs, outputs);
+
+		while(!m_sharedAudioExit)
+		{
+			const auto res = m_sharedAudio.waitForRequest(100);
+
+			if(res == bridgeLib::SharedAudio::WaitResult::Closed)
+				break;
+			if(res == bridgeLib::SharedAudio::WaitResult::Timeout)
+				continue;
+
+			const auto arrival = Scheduler::Clock::now();
+
+			std::scoped_lock lock(m_mutexDevice);
+
+			if(!m_device)
+				break;
+
+			m_sharedAudio.readMidiIn(m_midiIn);
+
+			processAudio(arrival, inputs, outputs, m_sharedAudio.getRequestSize());
+
+			const auto count = m_sharedAudio.sendReply(m_midiOut);
+
+			// events that did not fit into shared memory, for example large sysex, are sent via TCP. Not from this
+			// thread, writing to the socket may block
+			if(count < m_midiOut.size())
+			{
+				{
+					std::scoped_lock lockOverflow(m_mutexMidiOverflow);
+					for(size_t i=count; i<m_midiOut.size(); ++i)
+						m_midiOverflow.push_back(std::move(m_midiOut[i]));
+				}
+				m_cvMidiOverflow.notify_one();
+			}
+
+			m_midiIn.clear();
+
+			m_device->release(m_midiOut);
+		}
+	}
+
+	void ClientConnection::midiOverflowThreadFunc()
+	{
+		std::vector<synthLib::SMidiEvent> events;
+
+		while(true)
+		{
+			{
+				std::unique_lock lock(m_mutexMidiOverflow);
+
+				m_cvMidiOverflow.wait(lock, [this]
+				{
+					return m_sharedAudioExit || !m_midiOverflow.empty();
+				});
+
+				if(m_midiOverflow.empty())
+					return;
+
+				std::swap(events, m_midiOverflow);
+			}
+
+			// the socket is written by TCP command handlers too, they hold the device lock
+			std::scoped_lock lock(m_mutexDevice);
+
+			for (const auto& ev : events)
+				send(ev);
+
+			events.clear();
+		}
+	}
+
+	void ClientConnection::processAudio(const Scheduler::Clock::time_point _arrival, const synthLib::TAudioInputs& _inputs, const synthLib::TAudioOutputs& _outputs, const uint32_t _numSamples)
+	{
+		const auto sr = m_device->getSamplerate();
+		const auto duration = std::chrono::microseconds(sr > 0 ? static_cast<int64_t>(static_cast<double>(_numSamples) * 1'000'000.0 / sr) : 0);
+
+		m_server.getScheduler().process(*m_session, _arrival, duration, [&]
+		{
+			m_device->process(_inputs, _outputs, _numSamples, m_midiIn, m_midiOut);
+		});
+	}
+
+	void ClientConnection::handleRequestSessionStats()
+	{
+		bridgeLib::SessionStats stats;
+
+		if(m_session)
+			m_server.getScheduler().getSessionStats(*m_session, stats);
+
+		send(bridgeLib::Command::SessionStats, stats);
+	}
+
+	void ClientConnection::stopSharedAudio()
+	{
+		if(!m_sharedAudioThread.joinable())
+			return;
+
+		{
+			std::scoped_lock lock(m_mutexMidiOverflow);
+			m_sharedAudioExit = true;
+		}
+		m_cvMidiOverflow.notify_one();
+
+		m_sharedAudioThread.join();
+		m_midiOverflowThread.join();
+
+		m_sharedAudio.close();
+	}
+
 	void ClientConnection::sendDeviceInfo()
 	{
 		bridgeLib::DeviceDesc deviceDesc;
@@ -224,6 +373,7 @@ namespace bridgeServer
 		deviceDesc.dspClockHz = m_device->getDspClockHz();
 		deviceDesc.latencyInToOut = m_device->getInternalLatencyInputToOutput();
 		deviceDesc.latencyMidiToOut = m_device->getInternalLatencyMidiToOutput();
+		deviceDesc.audioCodec = getAudioCodec().getType();
 
 		deviceDesc.preferredSamplerates.reserve(64);
 		deviceDesc.supportedSamplerates.reserve(64);
@@ -239,7 +389,7 @@ namespace bridgeServer
 		if(m_pluginDesc.pluginVersion == 0 || m_deviceCreateParams.romData.empty())
 			return;
 
-		m_device = m_server.getPlugins().createDevice(m_deviceCreateParams, m_pluginDesc);
+		m_device = m_server.getDevicePool().createDevice(m_deviceCreateParams, m_pluginDesc);
 
 		if(!m_device)
 		{
@@ -250,6 +400,11 @@ namespace bridgeServer
 		const auto& d = m_pluginDesc;
 		LOGNET(networkLib::LogLevel::Info, "Created new device for plugin '" << d.pluginName << "', version " << d.pluginVersion << ", id " << d.plugin4CC);
 
+		if(m_session)
+			m_server.getScheduler().destroySession(m_session);
+
+		m_session = m_server.getScheduler().createSession(m_name);
+
 		// recover a previously lost connection if possible
 		const auto cachedDeviceState = m_server.getCachedDeviceState(d.sessionId);
 
@@ -265,14 +420,19 @@ namespace bridgeServer
 
 	void ClientConnection::destroyDevice()
 	{
+		stopSharedAudio();
+
 		if(!m_device)
 			return;
 
 		if(isValid())
 		sendDeviceState(synthLib::StateTypeGlobal);
 
-		m_server.getPlugins().destroyDevice(m_pluginDesc, m_device);
+		m_server.getDevicePool().destroyDevice(m_pluginDesc, m_device);
 		m_device = nullptr;
+
+		m_server.getScheduler().destroySession(m_session);
+		m_session.reset();
 	}
 
 	void ClientConnection::errorClose(const bridgeLib::ErrorCode _code, const std::string& _err)
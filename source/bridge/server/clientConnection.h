@@ -1,6 +1,12 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <mutex>
+#include <thread>
+
+#include "bridgeLib/sharedAudio.h"
+#include "scheduler.h"
 
 #include "bridgeLib/tcpConnection.h"
 #include "networkLib/networkThread.h"
@@ -17,12 +23,16 @@ namespace bridgeServer
 		ClientConnection(Server& _server, std::unique_ptr<networkLib::TcpStream>&& _stream, std::string _name);
 		~ClientConnection() override;
 
+		void handleCommand(bridgeLib::Command _command, baseLib::BinaryStream& _in) override;
+
 		void handleMidi(const synthLib::SMidiEvent& _e) override;
 		void handleData(const bridgeLib::PluginDesc& _desc) override;
 		void handleData(const bridgeLib::DeviceCreateParams& _params) override;
 		void handleData(const bridgeLib::SetSamplerate& _params) override;
 		void handleData(const bridgeLib::SetDspClockPercent& _params) override;
 		void handleData(const bridgeLib::SetUnknownCustomData& _params) override;
+		void handleData(const bridgeLib::SharedAudioDesc& _desc) override;
+		void handleRequestSessionStats() override;
 
 		void handleAudio(baseLib::BinaryStream& _in) override;
 		void sendDeviceState(synthLib::StateType _type);
@@ -38,6 +48,12 @@ namespace bridgeServer
 		void createDevice();
 		void destroyDevice();
 
+		void processAudio(Scheduler::Clock::time_point _arrival, const synthLib::TAudioInputs& _inputs, const synthLib::TAudioOutputs& _outputs, uint32_t _numSamples);
+
+		void sharedAudioThreadFunc();
+		void midiOverflowThreadFunc();
+		void stopSharedAudio();
+
 		void errorClose(bridgeLib::ErrorCode _code, const std::string& _err);
 
 		Server& m_server;
@@ -47,6 +63,7 @@ namespace bridgeServer
 		synthLib::DeviceCreateParams m_deviceCreateParams;
 
 		synthLib::Device* m_device = nullptr;
+		std::shared_ptr<Scheduler::Session> m_session;
 
 		synthLib::TAudioInputs m_audioInputs;
 		synthLib::TAudioOutputs m_audioOutputs;
@@ -59,5 +76,19 @@ namespace bridgeServer
 		bool m_romRequested = false;
 
 		std::mutex m_mutexDeviceState;
+
+		// the device is processed by the shared audio thread if the client uses shared memory, all commands that
+		// are received via TCP are handled while holding this lock
+		std::mutex m_mutexDevice;
+
+		bridgeLib::SharedAudio m_sharedAudio;
+		std::thread m_sharedAudioThread;
+		std::atomic<bool> m_sharedAudioExit{false};
+
+		// MIDI output that does not fit into shared memory, sent via TCP by a separate thread
+		std::thread m_midiOverflowThread;
+		std::mutex m_mutexMidiOverflow;
+		std::condition_variable m_cvMidiOverflow;
+		std::vector<synthLib::SMidiEvent> m_midiOverflow;
 	};
 }
@@ -12,6 +12,10 @@ namespace bridgeServer
 		: portTcp(bridgeLib::g_tcpServerPort)
 		, portUdp(bridgeLib::g_udpServerPort)
 		, deviceStateRefreshMinutes(3)
+		, schedulerWorkers(0)
+		, schedulerPinThreads(true)
+		, schedulerSlotsPerWorker(0)
+		, devicePoolSize(1)
 		, pluginsPath(getDefaultDataPath() + "plugins/")
 		, romsPath(getDefaultDataPath() + "roms/")
 	{
@@ -29,6 +33,10 @@ namespace bridgeServer
 		portTcp = config.getInt("tcpPort", static_cast<int>(portTcp));
 		portUdp = config.getInt("tcpPort", static_cast<int>(portUdp));
 		deviceStateRefreshMinutes = config.getInt("deviceStateRefreshMinutes", static_cast<int>(deviceStateRefreshMinutes));
+		schedulerWorkers = config.getInt("schedulerWorkers", static_cast<int>(schedulerWorkers));
+		schedulerPinThreads = config.getInt("schedulerPinThreads", schedulerPinThreads ? 1 : 0) != 0;
+		schedulerSlotsPerWorker = config.getInt("schedulerSlotsPerWorker", static_cast<int>(schedulerSlotsPerWorker));
+		devicePoolSize = config.getInt("devicePoolSize", static_cast<int>(devicePoolSize));
 		pluginsPath = config.get("pluginsPath", pluginsPath);
 		romsPath = config.get("romsPath", romsPath);
 
@@ -12,6 +12,10 @@ namespace bridgeServer
 		uint32_t portTcp;
 		uint32_t portUdp;
 		uint32_t deviceStateRefreshMinutes;
+		uint32_t schedulerWorkers;		// 0 = half the number of cores
+		bool schedulerPinThreads;
+		uint32_t schedulerSlotsPerWorker;	// blocks that a worker processes at the same time, 0 = number of cores per worker
+		uint32_t devicePoolSize;		// number of booted devices kept ready per plugin and ROM that has been used recently, 0 = disabled
 		std::string pluginsPath;
 		std::string romsPath;
 
@@ -0,0 +1,238 @@
+#include "devicePool.h"
+
+#include <tuple>
+
+#include "config.h"
+#include "import.h"
+
+#include "networkLib/logging.h"
+
+namespace bridgeServer
+{
+	namespace
+	{
+		// pooled devices of a combination that has not been requested for this long are destroyed
+		constexpr auto g_unusedTimeout = std::chrono::minutes(30);
+	}
+
+	bool DevicePool::Key::operator < (const Key& _k) const
+	{
+		if(plugin < _k.plugin)	return true;
+		if(_k.plugin < plugin)	return false;
+
+		return std::tie(romHash, preferredSamplerate, hostSamplerate, customData) < std::tie(_k.romHash, _k.preferredSamplerate, _k.hostSamplerate, _k.customData);
+	}
+
+	DevicePool::DevicePool(const Config& _config, Import& _plugins) : m_config(_config), m_plugins(_plugins)
+	{
+		if(m_config.devicePoolSize)
+		{
+			m_thread = std::thread([this]
+			{
+				threadFunc();
+			});
+		}
+	}
+
+	DevicePool::~DevicePool()
+	{
+		{
+			std::scoped_lock lock(m_mutex);
+			m_exit = true;
+		}
+
+		m_cv.notify_one();
+
+		if(m_thread.joinable())
+			m_thread.join();
+
+		for (auto& it : m_entries)
+		{
+			for (auto* device : it.second.devices)
+				m_plugins.destroyDevice(it.first.plugin, device);
+		}
+		m_entries.clear();
+	}
+
+	synthLib::Device* DevicePool::createDevice(const synthLib::DeviceCreateParams& _params, const bridgeLib::PluginDesc& _desc)
+	{
+		if(!m_config.devicePoolSize)
+			return m_plugins.createDevice(_params, _desc);
+
+		const auto key = createKey(_params, _desc);
+
+		{
+			std::scoped_lock lock(m_mutex);
+
+			auto& entry = m_entries[key];
+
+			if(entry.params.romData.empty())
+				entry.params = _params;
+
+			entry.lastUsed = Clock::now();
+
+			if(!entry.devices.empty())
+			{
+				auto* device = entry.devices.front();
+				entry.devices.pop_front();
+
+				LOGNET(networkLib::LogLevel::Info, "Using pooled device for plugin '" << _desc.pluginName << "', ROM " << _params.romHash.toString() << ", " << entry.devices.size() << " devices left");
+
+				m_cv.notify_one();
+				return device;
+			}
+
+			// the pool thread does not start to refill while a client is waiting for its device
+			++m_pendingClients;
+		}
+
+		// nothing pooled yet, create the device directly and let the pool thread prepare one for the next client
+		auto* device = m_plugins.createDevice(_params, _desc);
+
+		{
+			std::scoped_lock lock(m_mutex);
+			--m_pendingClients;
+		}
+
+		m_cv.notify_one();
+
+		return device;
+	}
+
+	void DevicePool::destroyDevice(const bridgeLib::PluginDesc& _desc, synthLib::Device* _device) const
+	{
+		// a device that has been in use is never returned to the pool, its state belongs to a client
+		m_plugins.destroyDevice(_desc, _device);
+	}
+
+	DevicePool::Key DevicePool::createKey(const synthLib::DeviceCreateParams& _params, const bridgeLib::PluginDesc& _desc)
+	{
+		Key key{_desc, _params.romHash, _params.preferredSamplerate, _params.hostSamplerate, _params.customData};
+
+		// the session id and the audio codec are not related to the device
+		key.plugin.sessionId = 0;
+		key.plugin.audioCodec = bridgeLib::AudioCodecType::Best;
+
+		return key;
+	}
+
+	void DevicePool::threadFunc()
+	{
+		while(true)
+		{
+			{
+				std::unique_lock lock(m_mutex);
+
+				if(m_exit)
+					return;
+			}
+
+			removeUnused();
+
+			if(fillOne())
+				continue;
+
+			std::unique_lock lock(m_mutex);
+
+			m_cv.wait_for(lock, std::chrono::minutes(1), [this]
+			{
+				if(m_exit)
+					return true;
+
+				if(m_pendingClients)
+					return false;
+
+				for (const auto& it : m_entries)
+				{
+					if(it.second.devices.size() < m_config.devicePoolSize)
+						return true;
+				}
+				return false;
+			});
+		}
+	}
+
+	bool DevicePool::fillOne()
+	{
+		Key key;
+		synthLib::DeviceCreateParams params;
+
+		{
+			std::scoped_lock lock(m_mutex);
+
+			if(m_pendingClients)
+				return false;
+
+			auto it = m_entries.begin();
+
+			for(; it != m_entries.end(); ++it)
+			{
+				if(it->second.devices.size() < m_config.devicePoolSize)
+					break;
+			}
+
+			if(it == m_entries.end())
+				return false;
+
+			key = it->first;
+			params = it->second.params;
+		}
+
+		// booting takes a while, do not block clients that pick up pooled devices in the meantime
+		auto* device = m_plugins.createDevice(params, key.plugin);
+
+		std::scoped_lock lock(m_mutex);
+
+		const auto it = m_entries.find(key);
+
+		if(!device)
+		{
+			// do not retry endlessly, the entry is created again when a client asks for it
+			if(it != m_entries.end() && it->second.devices.empty())
+				m_entries.erase(it);
+			return true;
+		}
+
+		if(it == m_entries.end() || m_exit)
+		{
+			m_plugins.destroyDevice(key.plugin, device);
+			return true;
+		}
+
+		it->second.devices.push_back(device);
+
+		LOGNET(networkLib::LogLevel::Info, "Added device for plugin '" << key.plugin.pluginName << "', ROM " << key.romHash.toString() << " to pool, " << it->second.devices.size() << " available");
+
+		return true;
+	}
+
+	void DevicePool::removeUnused()
+	{
+		std::list<std::pair<bridgeLib::PluginDesc, synthLib::Device*>> devices;
+
+		{
+			std::scoped_lock lock(m_mutex);
+
+			const auto now = Clock::now();
+
+			for(auto it = m_entries.begin(); it != m_entries.end();)
+			{
+				if(now - it->second.lastUsed < g_unusedTimeout)
+				{
+					++it;
+					continue;
+				}
+
+				LOGNET(networkLib::LogLevel::Info, "Removing unused pooled devices for plugin '" << it->first.plugin.pluginName << "', ROM " << it->first.romHash.toString());
+
+				for (auto* device : it->second.devices)
+					devices.emplace_back(it->first.plugin, device);
+
+				it = m_entries.erase(it);
+			}
+		}
+
+		for (const auto& [desc, device] : devices)
+			m_plugins.destroyDevice(desc, device);
+	}
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include "bridgeLib/commands.h"
+
+#include "synthLib/device.h"
+
+namespace bridgeServer
+{
+	struct Config;
+	class Import;
+
+	// Keeps a number of booted devices per plugin, ROM and samplerate around so that a connecting client does not have
+	// to wait for the device to boot. The pool is filled by a background thread for every combination that has been
+	// requested by a client before. Refilling pauses while a client waits for a device that is created directly
+	class DevicePool
+	{
+	public:
+		DevicePool(const Config& _config, Import& _plugins);
+		~DevicePool();
+
+		DevicePool(const DevicePool&) = delete;
+		DevicePool(DevicePool&&) = delete;
+		DevicePool& operator = (const DevicePool&) = delete;
+		DevicePool& operator = (DevicePool&&) = delete;
+
+		// returns a pooled device if available or creates a new one otherwise
+		synthLib::Device* createDevice(const synthLib::DeviceCreateParams& _params, const bridgeLib::PluginDesc& _desc);
+		void destroyDevice(const bridgeLib::PluginDesc& _desc, synthLib::Device* _device) const;
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		struct Key
+		{
+			bridgeLib::PluginDesc plugin;
+			baseLib::MD5 romHash;
+			float preferredSamplerate;
+			float hostSamplerate;
+			uint32_t customData;
+
+			bool operator < (const Key& _k) const;
+		};
+
+		struct Entry
+		{
+			synthLib::DeviceCreateParams params;
+			std::list<synthLib::Device*> devices;
+			Clock::time_point lastUsed;
+		};
+
+		static Key createKey(const synthLib::DeviceCreateParams& _params, const bridgeLib::PluginDesc& _desc);
+
+		void threadFunc();
+		bool fillOne();
+		void removeUnused();
+
+		const Config& m_config;
+		Import& m_plugins;
+
+		std::mutex m_mutex;
+		std::condition_variable m_cv;
+		std::map<Key, Entry> m_entries;
+		uint32_t m_pendingClients = 0;	// clients that are waiting for a device that has not been pooled
+		bool m_exit = false;
+
+		std::thread m_thread;
+	};
+}
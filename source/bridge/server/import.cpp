@@ -45,23 +45,35 @@ namespace bridgeServer
 
 	synthLib::Device* Import::createDevice(const synthLib::DeviceCreateParams& _params, const bridgeLib::PluginDesc& _desc)
 	{
-		std::scoped_lock lock(m_mutex);
+		FuncBridgeDeviceCreate funcCreate;
+		std::shared_ptr<std::mutex> mutexDevices;
 
-		auto it = m_loadedPlugins.find(_desc);
+		{
+			std::scoped_lock lock(m_mutex);
 
-		if(it == m_loadedPlugins.end())
-			findPlugins();	// try to load additional plugins if not found
+			auto it = m_loadedPlugins.find(_desc);
 
-		it = m_loadedPlugins.find(_desc);
-		if(it == m_loadedPlugins.end())
-		{
-			LOGNET(networkLib::LogLevel::Warning, "Failed to create device for plugin '" << _desc.pluginName << "', version " << _desc.pluginVersion << ", id " << _desc.plugin4CC << ", no matching plugin available");
-			return nullptr;	// still not found
+			if(it == m_loadedPlugins.end())
+				findPlugins();	// try to load additional plugins if not found
+
+			it = m_loadedPlugins.find(_desc);
+			if(it == m_loadedPlugins.end())
+			{
+				LOGNET(networkLib::LogLevel::Warning, "Failed to create device for plugin '" << _desc.pluginName << "', version " << _desc.pluginVersion << ", id " << _desc.plugin4CC << ", no matching plugin available");
+				return nullptr;	// still not found
+			}
+
+			funcCreate = it->second.funcCreate;
+			mutexDevices = it->second.mutexDevices;
 		}
 
+		// plugins are never unloaded while the server is running. Boot devices outside of the lookup lock so that a
+		// booting device does not block other plugins. Devices of one plugin are not guaranteed to be constructed safely
+		// in parallel, creation and destruction are serialized per plugin
 		try
 		{
-			return it->second.funcCreate(_params);
+			std::scoped_lock lock(*mutexDevices);
+			return funcCreate(_params);
 		}
 		catch(synthLib::DeviceException& e)
 		{
@@ -76,15 +88,24 @@ namespace bridgeServer
 		if(!_device)
 			return true;
 
-		std::scoped_lock lock(m_mutex);
+		FuncBridgeDeviceDestroy funcDestroy;
+		std::shared_ptr<std::mutex> mutexDevices;
 
-		const auto it = m_loadedPlugins.find(_desc);
-		if(it == m_loadedPlugins.end())
 		{
-			assert(false && "plugin unloaded before device destroyed");
-			return false;
+			std::scoped_lock lock(m_mutex);
+
+			const auto it = m_loadedPlugins.find(_desc);
+			if(it == m_loadedPlugins.end())
+			{
+				assert(false && "plugin unloaded before device destroyed");
+				return false;
+			}
+			funcDestroy = it->second.funcDestroy;
+			mutexDevices = it->second.mutexDevices;
 		}
-		it->second.funcDestroy(_device);
+
+		std::scoped_lock lock(*mutexDevices);
+		funcDestroy(_device);
 		return true;
 	}
 
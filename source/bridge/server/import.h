@@ -1,6 +1,7 @@
 #pragma once
 
 #include <map>
+#include <memory>
 #include <mutex>
 #include <set>
 
@@ -30,6 +31,7 @@ namespace bridgeServer
 			FuncBridgeDeviceCreate funcCreate = nullptr;
 			FuncBridgeDeviceDestroy funcDestroy = nullptr;
 			FuncBridgeDeviceGetDesc funcGetDesc = nullptr;
+			std::shared_ptr<std::mutex> mutexDevices = std::make_shared<std::mutex>();	// serializes device creation and destruction of this plugin
 		};
 
 		Import(const Config& _config);
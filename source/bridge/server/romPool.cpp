@@ -32,11 +32,11 @@ namespace bridgeServer
 	{
 		std::scoped_lock lock(m_mutex);
 
-		const auto hash = baseLib::MD5(_data);
+		const auto& hash = _data.getHash();
 		if(m_roms.find(hash) != m_roms.end())
 			return;
 
-		if(baseLib::filesystem::writeFile(getRootPath() + _name + '_' + hash.toString() + ".bin", _data))
+		if(baseLib::filesystem::writeFile(getRootPath() + _name + '_' + hash.toString() + ".bin", _data.get()))
 			m_roms.insert({hash, _data});
 	}
 
@@ -52,20 +52,20 @@ namespace bridgeServer
 
 		for (const auto& file : files)
 		{
-			std::vector<uint8_t> romData;
+			RomData romData;
 
-			if(!baseLib::filesystem::readFile(romData, file))
+			if(!romData.loadFromFile(file))
 			{
 				LOGNET(networkLib::LogLevel::Error, "Failed to load file " << file);
 				continue;
 			}
 
-			const auto hash = baseLib::MD5(romData);
+			const auto& hash = romData.getHash();
 
 			if(m_roms.find(hash) != m_roms.end())
 				continue;
 
-			m_roms.insert({hash, std::move(romData)});
+			m_roms.insert({hash, romData});
 			LOGNET(networkLib::LogLevel::Info, "Loaded ROM " << baseLib::filesystem::getFilenameWithoutPath(file));
 		}
 	}
@@ -6,15 +6,12 @@
 #include <vector>
 #include <string>
 
-namespace baseLib
-{
-	class MD5;
-}
+#include "synthLib/romData.h"
 
 namespace bridgeServer
 {
 	struct Config;
-	using RomData = std::vector<uint8_t>;
+	using RomData = synthLib::RomData;
 
 	class RomPool
 	{
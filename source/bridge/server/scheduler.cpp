@@ -0,0 +1,345 @@
+#include "scheduler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "config.h"
+
+#include "baseLib/os.h"
+
+#include "networkLib/logging.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#define NOSERVICE
+#include <Windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace bridgeServer
+{
+	namespace
+	{
+		// weight of a new measurement in the moving average of the load
+		constexpr float g_loadSmoothing = 0.05f;
+
+		// minimum load difference between two workers to move a session
+		constexpr float g_rebalanceThreshold = 0.2f;
+
+		// cores that this process may run on
+		std::vector<uint32_t> getAvailableCores()
+		{
+			std::vector<uint32_t> cores;
+#ifdef _WIN32
+			DWORD_PTR processMask, systemMask;
+			if(GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask))
+			{
+				for(uint32_t i=0; i<sizeof(DWORD_PTR) * 8; ++i)
+				{
+					if(processMask & (static_cast<DWORD_PTR>(1) << i))
+						cores.push_back(i);
+				}
+			}
+#elif defined(__linux__)
+			cpu_set_t set;
+			CPU_ZERO(&set);
+			if(sched_getaffinity(0, sizeof(set), &set) == 0)
+			{
+				for(uint32_t i=0; i<CPU_SETSIZE; ++i)
+				{
+					if(CPU_ISSET(i, &set))
+						cores.push_back(i);
+				}
+			}
+#endif
+			return cores;
+		}
+
+		bool bindCurrentThreadToCores(const std::vector<uint32_t>& _cores)
+		{
+			if(_cores.empty())
+				return false;
+#ifdef _WIN32
+			DWORD_PTR mask = 0;
+			for (const auto c : _cores)
+				mask |= static_cast<DWORD_PTR>(1) << c;
+			return SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#elif defined(__linux__)
+			cpu_set_t set;
+			CPU_ZERO(&set);
+			for (const auto c : _cores)
+				CPU_SET(c, &set);
+			return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+			// macOS does not support binding threads to cores
+			return false;
+#endif
+		}
+	}
+
+	void Scheduler::Session::getStats(bridgeLib::SessionStats& _stats) const
+	{
+		_stats.cpuLoad = m_load.load(std::memory_order_relaxed);
+		_stats.processedBlocks = m_blocks.load(std::memory_order_relaxed);
+		_stats.deadlineMisses = m_deadlineMisses.load(std::memory_order_relaxed);
+	}
+
+	Scheduler::Scheduler(const Config& _config) : m_config(_config)
+	{
+		const auto cores = m_config.schedulerPinThreads ? getAvailableCores() : std::vector<uint32_t>();
+
+		auto numWorkers = m_config.schedulerWorkers;
+
+		if(!numWorkers)
+			numWorkers = std::max(1u, (cores.empty() ? std::thread::hardware_concurrency() : static_cast<uint32_t>(cores.size())) / 2);
+
+		m_workers.resize(numWorkers);
+
+		// only the cores this process is allowed to use, distributed round robin. A worker may get several cores or
+		// share one with other workers, the OS still decides which of them a thread runs on
+		if(!cores.empty())
+		{
+			for(size_t i=0; i<std::max<size_t>(cores.size(), numWorkers); ++i)
+				m_workers[i % numWorkers].cores.push_back(cores[i % cores.size()]);
+		}
+
+		// by default, a worker processes as many blocks at a time as it has cores
+		const auto coreCount = cores.empty() ? std::max(1u, std::thread::hardware_concurrency()) : static_cast<uint32_t>(cores.size());
+
+		for (auto& w : m_workers)
+			w.slots = m_config.schedulerSlotsPerWorker ? m_config.schedulerSlotsPerWorker : std::max(1u, coreCount / numWorkers);
+
+		LOGNET(networkLib::LogLevel::Info, "Scheduler started with " << numWorkers << " workers with " << m_workers.front().slots << " slots each on " << cores.size() << " cores");
+	}
+
+	std::shared_ptr<Scheduler::Session> Scheduler::createSession(const std::string& _name)
+	{
+		auto session = std::make_shared<Session>(_name);
+
+		std::scoped_lock lock(m_mutex);
+
+		session->m_worker = getLeastLoadedWorker();
+		m_sessions.push_back(session);
+
+		LOGNET(networkLib::LogLevel::Debug, "Session " << _name << " assigned to worker " << session->m_worker);
+
+		return session;
+	}
+
+	void Scheduler::destroySession(const std::shared_ptr<Session>& _session)
+	{
+		std::scoped_lock lock(m_mutex);
+		m_sessions.remove(_session);
+	}
+
+	void Scheduler::process(Session& _session, const Clock::time_point _arrival, const std::chrono::microseconds _duration, const std::function<void()>& _func)
+	{
+		uint32_t workerIndex;
+
+		{
+			std::scoped_lock lock(m_mutex);
+			workerIndex = _session.m_worker;
+		}
+
+		const auto deadline = _arrival + _duration;
+
+		admit(workerIndex, deadline);
+
+		bindCurrentThread(_session, workerIndex);
+
+		const auto start = Clock::now();
+
+		_func();
+
+		const auto end = Clock::now();
+
+		release(workerIndex);
+
+		if(_duration.count() > 0)
+		{
+			const auto load = static_cast<float>(std::chrono::duration<double>(end - start).count() / std::chrono::duration<double>(_duration).count());
+			const auto prev = _session.m_load.load(std::memory_order_relaxed);
+			_session.m_load.store(prev + (load - prev) * g_loadSmoothing, std::memory_order_relaxed);
+		}
+
+		_session.m_blocks.fetch_add(1, std::memory_order_relaxed);
+
+		// time spent waiting for admission counts too
+		if(end > deadline)
+			_session.m_deadlineMisses.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void Scheduler::admit(const uint32_t _worker, const Clock::time_point _deadline)
+	{
+		std::unique_lock lock(m_mutex);
+
+		auto& w = m_workers[_worker];
+
+		// equal deadlines are inserted after the existing ones and are admitted in arrival order
+		const auto it = w.waiting.insert(_deadline);
+
+		m_cvAdmission.wait(lock, [&]
+		{
+			return w.active < w.slots && w.waiting.begin() == it;
+		});
+
+		w.waiting.erase(it);
+		++w.active;
+
+		// another slot may still be free for the next block in line
+		if(w.active < w.slots && !w.waiting.empty())
+			m_cvAdmission.notify_all();
+	}
+
+	void Scheduler::release(const uint32_t _worker)
+	{
+		{
+			std::scoped_lock lock(m_mutex);
+			--m_workers[_worker].active;
+		}
+		m_cvAdmission.notify_all();
+	}
+
+	void Scheduler::rebalance()
+	{
+		std::scoped_lock lock(m_mutex);
+
+		if(m_workers.size() < 2)
+			return;
+
+		uint32_t maxWorker = 0;
+		uint32_t minWorker = 0;
+
+		for(uint32_t i=1; i<m_workers.size(); ++i)
+		{
+			if(getWorkerLoad(i) > getWorkerLoad(maxWorker))
+				maxWorker = i;
+			if(getWorkerLoad(i) < getWorkerLoad(minWorker))
+				minWorker = i;
+		}
+
+		const auto diff = getWorkerLoad(maxWorker) - getWorkerLoad(minWorker);
+
+		if(diff < g_rebalanceThreshold)
+			return;
+
+		// move the session that brings both workers closest to each other. Its thread is bound to the new cores when it
+		// processes the next block
+		Session* best = nullptr;
+		float bestDiff = diff;
+
+		for (const auto& s : m_sessions)
+		{
+			if(s->m_worker != maxWorker)
+				continue;
+
+			const auto load = s->m_load.load(std::memory_order_relaxed);
+			const auto newDiff = std::abs(diff - 2.0f * load);
+
+			if(newDiff < bestDiff)
+			{
+				bestDiff = newDiff;
+				best = s.get();
+			}
+		}
+
+		if(!best)
+			return;
+
+		LOGNET(networkLib::LogLevel::Debug, "Moving session " << best->getName() << " from worker " << maxWorker << " to worker " << minWorker);
+		best->m_worker = minWorker;
+	}
+
+	void Scheduler::getSessionStats(const Session& _session, bridgeLib::SessionStats& _stats) const
+	{
+		_session.getStats(_stats);
+
+		std::scoped_lock lock(m_mutex);
+		_stats.worker = _session.m_worker;
+	}
+
+	void Scheduler::logStats() const
+	{
+		std::scoped_lock lock(m_mutex);
+
+		if(m_sessions.empty())
+			return;
+
+		for(uint32_t i=0; i<m_workers.size(); ++i)
+		{
+			LOGNET(networkLib::LogLevel::Debug, "Worker " << i << ": load " << getWorkerLoad(i));
+
+			for (const auto& s : m_sessions)
+			{
+				if(s->m_worker != i)
+					continue;
+
+				bridgeLib::SessionStats stats;
+				s->getStats(stats);
+
+				LOGNET(networkLib::LogLevel::Debug, "  Session " << s->getName() << ": load " << stats.cpuLoad << ", blocks " << stats.processedBlocks << ", deadline misses " << stats.deadlineMisses);
+			}
+		}
+	}
+
+	void Scheduler::bindCurrentThread(Session& _session, const uint32_t _worker) const
+	{
+		const auto thread = std::this_thread::get_id();
+
+		if(_session.m_boundWorker == _worker && _session.m_boundThread == thread)
+			return;
+
+		if(_session.m_boundThread != thread)
+			baseLib::setFlushDenormalsToZero();
+
+		_session.m_boundWorker = _worker;
+		_session.m_boundThread = thread;
+
+		const auto& cores = m_workers[_worker].cores;
+
+		if(!cores.empty() && !bindCurrentThreadToCores(cores))
+			LOGNET(networkLib::LogLevel::Warning, "Failed to bind thread of session " << _session.getName() << " to the cores of worker " << _worker);
+	}
+
+	float Scheduler::getWorkerLoad(const uint32_t _worker) const
+	{
+		float load = 0.0f;
+
+		for (const auto& s : m_sessions)
+		{
+			if(s->m_worker == _worker)
+				load += s->m_load.load(std::memory_order_relaxed);
+		}
+
+		return load;
+	}
+
+	uint32_t Scheduler::getLeastLoadedWorker() const
+	{
+		uint32_t best = 0;
+		float bestLoad = std::numeric_limits<float>::max();
+
+		for(uint32_t i=0; i<m_workers.size(); ++i)
+		{
+			// a new session has no measured load yet, count sessions too to spread them if loads are equal
+			float load = getWorkerLoad(i);
+
+			for (const auto& s : m_sessions)
+			{
+				if(s->m_worker == i)
+					load += 0.001f;
+			}
+
+			if(load < bestLoad)
+			{
+				bestLoad = load;
+				best = i;
+			}
+		}
+
+		return best;
+	}
+}
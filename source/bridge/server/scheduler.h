@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bridgeLib/commands.h"
+
+namespace bridgeServer
+{
+	struct Config;
+
+	// Distributes the audio processing of all sessions across groups of cores. Each session is assigned to one worker,
+	// new sessions go to the worker with the lowest measured load and sessions are moved between workers if the load
+	// gets unbalanced. A worker processes a bounded number of blocks at a time, waiting blocks are admitted in the order
+	// of their deadlines. Processing runs on the thread of the session, which is bound to the cores of its worker, as
+	// device processing blocks while waiting for the emulator threads
+	class Scheduler
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		class Session
+		{
+		public:
+			explicit Session(std::string _name) : m_name(std::move(_name)) {}
+
+			const std::string& getName() const { return m_name; }
+
+			void getStats(bridgeLib::SessionStats& _stats) const;
+
+		private:
+			friend class Scheduler;
+
+			const std::string m_name;
+
+			uint32_t m_worker = 0;		// guarded by the scheduler mutex
+
+			// worker whose cores the processing thread has been bound to, only accessed by the processing thread
+			uint32_t m_boundWorker = ~0u;
+			std::thread::id m_boundThread;
+
+			// load is the ratio of processing time to the duration of the processed audio
+			std::atomic<float> m_load{0.0f};
+			std::atomic<uint64_t> m_blocks{0};
+			std::atomic<uint64_t> m_deadlineMisses{0};
+		};
+
+		explicit Scheduler(const Config& _config);
+		~Scheduler() = default;
+
+		Scheduler(const Scheduler&) = delete;
+		Scheduler(Scheduler&&) = delete;
+		Scheduler& operator = (const Scheduler&) = delete;
+		Scheduler& operator = (Scheduler&&) = delete;
+
+		std::shared_ptr<Session> createSession(const std::string& _name);
+		void destroySession(const std::shared_ptr<Session>& _session);
+
+		// Waits until the worker of the session admits the block, then executes _func on the calling thread and
+		// measures its load. _arrival is the time the block has been received and _duration the length of the audio that
+		// is processed, the block misses its deadline if it has not been processed at _arrival + _duration
+		void process(Session& _session, Clock::time_point _arrival, std::chrono::microseconds _duration, const std::function<void()>& _func);
+
+		// moves sessions from the most to the least loaded worker if that improves the balance
+		void rebalance();
+
+		void getSessionStats(const Session& _session, bridgeLib::SessionStats& _stats) const;
+
+		void logStats() const;
+
+	private:
+		struct Worker
+		{
+			std::vector<uint32_t> cores;	// empty if threads are not bound
+			uint32_t slots = 1;				// number of blocks that may be processed at the same time
+
+			// guarded by the scheduler mutex
+			uint32_t active = 0;
+			std::multiset<Clock::time_point> waiting;	// deadlines of the blocks that wait for admission
+		};
+
+		void admit(uint32_t _worker, Clock::time_point _deadline);
+		void release(uint32_t _worker);
+
+		void bindCurrentThread(Session& _session, uint32_t _worker) const;
+		float getWorkerLoad(uint32_t _worker) const;
+		uint32_t getLeastLoadedWorker() const;
+
+		const Config& m_config;
+
+		std::vector<Worker> m_workers;
+
+		mutable std::mutex m_mutex;
+		std::condition_variable m_cvAdmission;
+		std::list<std::shared_ptr<Session>> m_sessions;
+	};
+}
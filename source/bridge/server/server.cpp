@@ -11,6 +11,8 @@ namespace bridgeServer
 		: m_config(_argc, _argv)
 		, m_plugins(m_config)
 		, m_romPool(m_config)
+		, m_scheduler(m_config)
+		, m_devicePool(m_config, m_plugins)
 		, m_tcpServer([this](std::unique_ptr<networkLib::TcpStream> _stream){onClientConnected(std::move(_stream));}
 		, bridgeLib::g_tcpServerPort)
 		, m_lastDeviceStateUpdate(std::chrono::system_clock::now())
@@ -33,6 +35,9 @@ namespace bridgeServer
 
 			cleanupClients();
 			doPeriodicDeviceStateUpdate();
+
+			m_scheduler.rebalance();
+			m_scheduler.logStats();
 		}
 	}
 
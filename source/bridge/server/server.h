@@ -7,8 +7,10 @@
 
 #include "clientConnection.h"
 #include "config.h"
+#include "devicePool.h"
 #include "import.h"
 #include "romPool.h"
+#include "scheduler.h"
 #include "udpServer.h"
 #include "networkLib/tcpServer.h"
 
@@ -29,6 +31,8 @@ namespace bridgeServer
 
 		auto& getPlugins() { return m_plugins; }
 		auto& getRomPool() { return m_romPool; }
+		auto& getScheduler() { return m_scheduler; }
+		auto& getDevicePool() { return m_devicePool; }
 
 		bridgeLib::DeviceState getCachedDeviceState(const bridgeLib::SessionId& _id);
 
@@ -40,6 +44,8 @@ namespace bridgeServer
 
 		Import m_plugins;
 		RomPool m_romPool;
+		Scheduler m_scheduler;
+		DevicePool m_devicePool;
 
 		UdpServer m_udpServer;
 		networkLib::TcpServer m_tcpServer;
@@ -31,6 +31,23 @@ namespace hwLib
 		{
 			m_cgRamChangeCallback = _callback;
 		}
+
+		// display state without callbacks, used for machine snapshots
+		template<typename TStream> void saveState(TStream& _s) const
+		{
+			_s.write(m_lastWriteCounter); _s.write(m_cursorPos); _s.write(m_dramAddr); _s.write(m_cgramAddr);
+			_s.write(m_cursorShift); _s.write(m_displayShift); _s.write(m_fontTable); _s.write(m_dataLength); _s.write(m_addressMode);
+			_s.write(m_displayOn); _s.write(m_cursorOn); _s.write(m_cursorBlinking); _s.write(m_addrIncrement);
+			_s.write(m_cgramData); _s.write(m_dramData); _s.write(m_lastOpState);
+		}
+
+		template<typename TStream> void loadState(TStream& _s)
+		{
+			_s.read(m_lastWriteCounter); _s.read(m_cursorPos); _s.read(m_dramAddr); _s.read(m_cgramAddr);
+			_s.read(m_cursorShift); _s.read(m_displayShift); _s.read(m_fontTable); _s.read(m_dataLength); _s.read(m_addressMode);
+			_s.read(m_displayOn); _s.read(m_cursorOn); _s.read(m_cursorBlinking); _s.read(m_addrIncrement);
+			_s.read(m_cgramData); _s.read(m_dramData); _s.read(m_lastOpState);
+		}
 	private:
 		enum class CursorShiftMode
 		{
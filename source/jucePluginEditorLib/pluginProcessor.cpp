@@ -60,6 +60,11 @@ namespace jucePluginEditorLib
 
 		if (m_config.getBoolValue("enableMcpServer", false))
 			startMcpServer();
+
+		// the 24 bit audio codecs of the bridge are lossy for float data, they are only used if enabled explicitly
+		const auto audioCodec = m_config.getIntValue("bridgeAudioCodec", static_cast<int>(bridgeLib::AudioCodecType::Float32));
+		if (audioCodec > 0 && audioCodec < static_cast<int>(bridgeLib::AudioCodecType::Count))
+			setRemoteAudioCodec(static_cast<bridgeLib::AudioCodecType>(audioCodec));
 	}
 
 	Processor::~Processor()
@@ -1,5 +1,6 @@
 #include "controller.h"
 
+#include <algorithm>
 #include <cassert>
 #include <fstream>
 
@@ -14,6 +15,13 @@
 
 namespace pluginLib
 {
+	namespace
+	{
+		constexpr uint8_t g_invalidPageSlot = 0xff;
+
+		const std::vector<Parameter*> g_emptyParameterList;
+	}
+
 	uint8_t getParameterValue(const Parameter* _p)
 	{
 		return static_cast<uint8_t>(_p->getUnnormalizedValue());
@@ -194,6 +202,8 @@ namespace pluginLib
 				m_softKnobs.insert({sk->getParameter(), std::unique_ptr<SoftKnob>(sk)});
 			}
 		}
+
+		createSynthParamTable();
     }
 
 	void Controller::sendSysEx(const pluginLib::SysEx& _msg) const
@@ -279,9 +289,17 @@ namespace pluginLib
 
 	void Controller::applyPatchParameters(const MidiPacket::ParamValues& _params, const uint8_t _part) const
 	{
+		if(_part >= m_paramsByParamType.size())
+			return;
+
+		const auto& params = m_paramsByParamType[_part];
+
 		for (const auto& it : _params)
 		{
-			auto* p = getParameter(it.first.second, _part);
+			if(it.first.second >= params.size())
+				continue;
+
+			auto* p = params[it.first.second];
 			p->setValueFromSynth(it.second, pluginLib::Parameter::Origin::PresetChange);
 
 			for (const auto& derivedParam : p->getDerivedParameters())
@@ -320,6 +338,24 @@ namespace pluginLib
 	}
 
 	const Controller::ParameterList& Controller::findSynthParam(const ParamIndex& _paramIndex) const
+    {
+		if(m_synthParamTable.empty())
+			return findSynthParamInMaps(_paramIndex);
+
+		if(_paramIndex.partNum >= m_synthParamTablePartCount)
+			return g_emptyParameterList;
+
+		const auto slot = m_pageToSlot[_paramIndex.page];
+
+		if(slot == g_invalidPageSlot)
+			return g_emptyParameterList;
+
+		const auto* list = m_synthParamTable[((_paramIndex.partNum * m_pageSlotCount + slot) << 8) + _paramIndex.paramNum];
+
+		return list ? *list : g_emptyParameterList;
+    }
+
+	const Controller::ParameterList& Controller::findSynthParamInMaps(const ParamIndex& _paramIndex) const
     {
 		const auto it = m_synthParams.find(_paramIndex);
     	const auto iti = m_synthInternalParams.find(_paramIndex);
@@ -331,10 +367,7 @@ namespace pluginLib
 			return iti->second;
 
 		if (it == m_synthParams.end() && iti == m_synthInternalParams.end())
-		{
-			static ParameterList empty;
-			return empty;
-		}
+			return g_emptyParameterList;
 
 		m_tempReturnParameterList.clear();
 		m_tempReturnParameterList.assign(it->second.begin(), it->second.end());
@@ -343,6 +376,57 @@ namespace pluginLib
 		return m_tempReturnParameterList;
     }
 
+	void Controller::createSynthParamTable()
+	{
+		m_pageToSlot.fill(g_invalidPageSlot);
+		m_pageSlotCount = 0;
+		m_synthParamTablePartCount = 0;
+		m_synthParamTable.clear();
+		m_mergedSynthParams.clear();
+
+		auto addIndex = [&](const ParamIndex& _idx)
+		{
+			auto& slot = m_pageToSlot[_idx.page];
+			if(slot == g_invalidPageSlot)
+				slot = static_cast<uint8_t>(m_pageSlotCount++);
+			m_synthParamTablePartCount = std::max(m_synthParamTablePartCount, static_cast<uint32_t>(_idx.partNum) + 1);
+		};
+
+		for (const auto& it : m_synthParams)
+			addIndex(it.first);
+		for (const auto& it : m_synthInternalParams)
+			addIndex(it.first);
+
+		if(!m_pageSlotCount)
+			return;
+
+		m_synthParamTable.resize((m_synthParamTablePartCount * m_pageSlotCount) << 8, nullptr);
+
+		auto& table = m_synthParamTable;
+
+		auto addList = [&](const ParamIndex& _idx, const ParameterList& _list)
+		{
+			auto& entry = table[((_idx.partNum * m_pageSlotCount + m_pageToSlot[_idx.page]) << 8) + _idx.paramNum];
+
+			if(!entry)
+			{
+				entry = &_list;
+				return;
+			}
+
+			// exposed and internal parameters share the index, keep a combined list
+			auto& merged = m_mergedSynthParams.emplace_back(*entry);
+			merged.insert(merged.end(), _list.begin(), _list.end());
+			entry = &merged;
+		};
+
+		// maps stay unchanged once all parameters are registered, pointers to the lists remain valid
+		for (const auto& it : m_synthParams)
+			addList(it.first, it.second);
+		for (const auto& it : m_synthInternalParams)
+			addList(it.first, it.second);
+	}
+
 	void Controller::sendLockedParameters(const uint8_t _part, const Parameter::Origin _origin/* = Parameter::Origin::PresetChange*/)
 	{
         const auto lockedParameters = m_locking.getLockedParameters(_part);
@@ -466,12 +550,35 @@ namespace pluginLib
 
 	bool Controller::createMidiDataFromPacket(SysEx& _sysex, const std::string& _packetName, const std::map<MidiDataType, uint8_t>& _data, uint8_t _part) const
 	{
-		MidiPacket::NamedParamValues paramValues;
-
-		if(!createNamedParamValues(paramValues, _packetName, _part))
+		const auto* m = getMidiPacket(_packetName);
+		assert(m && "midi packet not found");
+		if(!m)
 			return false;
 
-		return createMidiDataFromPacket(_sysex, _packetName, _data, paramValues);
+		const auto res = m->create(_sysex, _data, [&](const MidiPacket::ParamIndex& _index, ParamValue& _value)
+		{
+			const auto* p = getParameter(_index.second, _part);
+			if(!p)
+				return false;
+			const auto* largestP = p;
+			// we might have more than 1 parameter per index, use the one with the largest range
+			const auto& derived = p->getDerivedParameters();
+			for (const auto& parameter : derived)
+			{
+				if(parameter->getDescription().range.getLength() > p->getDescription().range.getLength())
+					largestP = parameter;
+			}
+			_value = getParameterValue(largestP);
+			return true;
+		});
+
+		if(!res)
+		{
+			assert(false && "failed to create midi packet");
+			_sysex.clear();
+			return false;
+		}
+		return true;
 	}
 
 	bool Controller::createMidiDataFromPacket(SysEx& _sysex, const std::string& _packetName, const std::map<MidiDataType, uint8_t>& _data, const MidiPacket::NamedParamValues& _values) const
@@ -489,10 +596,18 @@ namespace pluginLib
 
 	bool Controller::createMidiDataFromPacket(SysEx& _sysex, const std::string& _packetName, const std::map<MidiDataType, uint8_t>& _data, const MidiPacket::AnyPartParamValues& _values) const
 	{
-		MidiPacket::NamedParamValues namedParams;
-		if(!createNamedParamValues(namedParams, _values))
+		const auto* m = getMidiPacket(_packetName);
+		assert(m && "midi packet not found");
+		if(!m)
 			return false;
-		return createMidiDataFromPacket(_sysex, _packetName, _data, namedParams);
+
+		if(!m->create(_sysex, _data, _values))
+		{
+			assert(false && "failed to create midi packet");
+			_sysex.clear();
+			return false;
+		}
+		return true;
 	}
 
 	bool Controller::parseMidiPacket(const MidiPacket& _packet, MidiPacket::Data& _data, MidiPacket::ParamValues& _parameterValues, const SysEx& _src) const
@@ -7,7 +7,9 @@
 
 #include "synthLib/midiTypes.h"
 
+#include <list>
 #include <string>
+#include <unordered_map>
 
 #include "parameterlinks.h"
 
@@ -168,13 +170,18 @@ namespace pluginLib
 		std::mutex m_midiMessagesLock;
         std::vector<synthLib::SMidiEvent> m_midiMessages;
 
-		std::map<const Parameter*, std::unique_ptr<SoftKnob>> m_softKnobs;
+		std::unordered_map<const Parameter*, std::unique_ptr<SoftKnob>> m_softKnobs;
 
 	protected:
 		// tries to find synth param in both internal and host
 		const ParameterList& findSynthParam(uint8_t _part, uint8_t _page, uint8_t _paramIndex) const;
 		const ParameterList& findSynthParam(const ParamIndex& _paramIndex) const;
 
+	private:
+		const ParameterList& findSynthParamInMaps(const ParamIndex& _paramIndex) const;
+		void createSynthParamTable();
+
+	protected:
     	std::map<ParamIndex, ParameterList> m_synthInternalParams;
 		std::map<ParamIndex, ParameterList> m_synthParams; // exposed and managed by audio processor
 		std::array<ParameterList, 16> m_paramsByParamType;
@@ -182,5 +189,14 @@ namespace pluginLib
 		ParameterLocking m_locking;
 		ParameterLinks m_parameterLinks;
 		mutable ParameterList m_tempReturnParameterList;
+
+	private:
+		// dense lookup table for findSynthParam, indexed by [part][page slot][param index]. Built once all parameters
+		// are registered, the maps are only used during registration
+		std::array<uint8_t, 256> m_pageToSlot{};
+		uint32_t m_pageSlotCount = 0;
+		uint32_t m_synthParamTablePartCount = 0;
+		std::vector<const ParameterList*> m_synthParamTable;
+		std::list<ParameterList> m_mergedSynthParams;	// indices that have exposed and internal parameters
 	};
 }
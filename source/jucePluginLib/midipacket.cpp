@@ -1,5 +1,6 @@
 #include "midipacket.h"
 
+#include <algorithm>
 #include <cassert>
 
 #include "parameterdescriptions.h"
@@ -14,6 +15,7 @@ namespace pluginLib
 		uint32_t byteIndex = 0;
 
 		m_byteToDefinitionIndex.reserve(m_definitions.size());
+		m_compiled.reserve(m_definitions.size());
 
 		std::set<uint32_t> usedParts;
 
@@ -53,6 +55,16 @@ namespace pluginLib
 
 			m_byteToDefinitionIndex[byteIndex].push_back(i);
 
+			auto& c = m_compiled.emplace_back();
+			c.type = d.type;
+			c.byte = d.byte;
+			c.paramMask = d.paramMask;
+			c.paramShiftRight = d.paramShiftRight;
+			c.paramShiftLeft = d.paramShiftLeft;
+			c.paramPart = d.paramPart;
+			c.byteIndex = byteIndex;
+			c.definitionIndex = i;
+
 			usedMask |= masked;
 		}
 
@@ -61,75 +73,85 @@ namespace pluginLib
 		m_numDifferentPartsUsedInParameters = static_cast<uint32_t>(usedParts.size());
 	}
 
-	bool MidiPacket::create(synthLib::SysexBuffer& _dst, const Data& _data, const NamedParamValues& _paramValues) const
+	bool MidiPacket::resolveParameterIndices(const ParameterDescriptions& _parameters)
 	{
-		_dst.assign(size(), 0);
+		m_maxParamIndex = 0;
 
-		std::map<uint32_t, uint32_t> pendingChecksums;	// byte index => description index
+		bool res = true;
 
-		for(size_t i=0; i<size(); ++i)
+		for (auto& d : m_compiled)
 		{
-			if(i >= m_byteToDefinitionIndex.size())
+			if(d.type != MidiDataType::Parameter)
 				continue;
 
-			const auto& range = m_byteToDefinitionIndex[i];
+			const auto& name = m_definitions[d.definitionIndex].paramName;
 
-			for(auto itRange = range.begin(); itRange != range.end(); ++itRange)
+			if(!_parameters.getIndexByName(d.paramIndex, name))
 			{
-				const auto& d = m_definitions[*itRange];
+				LOG("Failed to retrieve index for parameter " << name << ", midi packet " << m_name);
+				d.paramIndex = InvalidIndex;
+				res = false;
+				continue;
+			}
 
-				switch (d.type)
-				{
-				case MidiDataType::Null:
-					_dst[i] = 0;
-					break;
-				case MidiDataType::Byte:
-					_dst[i] = d.byte;
-					break;
-				case MidiDataType::Parameter:
-					{
-						const auto it = _paramValues.find(std::make_pair(d.paramPart, d.paramName));
-						if(it == _paramValues.end())
-						{
-							LOG("Failed to find value for parameter " << d.paramName << ", part " << d.paramPart);
-							return false;
-						}
-						_dst[i] |= d.packValue(it->second);
-					}
-					break;
-				case MidiDataType::Checksum:
-					pendingChecksums.insert(std::make_pair(static_cast<uint32_t>(i), *itRange));
-					break;
-				default:
-					{
-						const auto it = _data.find(d.type);
+			m_maxParamIndex = std::max(m_maxParamIndex, d.paramIndex);
+		}
 
-						if(it == _data.end())
-						{
-							LOG("Failed to find data of type " << static_cast<int>(d.type) << " to fill byte " << i << " of midi packet");
-							return false;
-						}
+		return res;
+	}
 
-						_dst[i] = it->second;
-					}
-				}
+	bool MidiPacket::create(synthLib::SysexBuffer& _dst, const Data& _data, const NamedParamValues& _paramValues) const
+	{
+		return createImpl(_dst, _data, [&](const CompiledDefinition& _d, ParamValue& _value)
+		{
+			const auto& name = m_definitions[_d.definitionIndex].paramName;
+
+			const auto it = _paramValues.find(std::make_pair(_d.paramPart, name));
+			if(it == _paramValues.end())
+			{
+				LOG("Failed to find value for parameter " << name << ", part " << _d.paramPart);
+				return false;
 			}
-		}
+			_value = it->second;
+			return true;
+		});
+	}
 
-		for (const auto& pendingChecksum : pendingChecksums)
+	bool MidiPacket::create(Sysex& _dst, const Data& _data, const AnyPartParamValues& _paramValues) const
+	{
+		return createImpl(_dst, _data, [&](const CompiledDefinition& _d, ParamValue& _value)
 		{
-			const auto byteIndex = pendingChecksum.first;
-			const auto descIndex = pendingChecksum.second;
+			uint32_t idx;
 
-			_dst[byteIndex] = calcChecksum(m_definitions[descIndex], _dst);
-		}
+			if(_d.paramPart != AnyPart || !getParameterIndex(idx, _d, nullptr) || idx >= _paramValues.size() || !_paramValues[idx])
+			{
+				LOG("Failed to find value for parameter " << m_definitions[_d.definitionIndex].paramName << ", part " << _d.paramPart);
+				return false;
+			}
 
-		return true;
+			_value = *_paramValues[idx];
+			return true;
+		});
+	}
+
+	bool MidiPacket::create(Sysex& _dst, const Data& _data, const std::function<bool(ParamIndex, ParamValue&)>& _getParamValueCallback) const
+	{
+		return createImpl(_dst, _data, [&](const CompiledDefinition& _d, ParamValue& _value)
+		{
+			uint32_t idx;
+
+			if(!getParameterIndex(idx, _d, nullptr) || !_getParamValueCallback(std::make_pair(_d.paramPart, idx), _value))
+			{
+				LOG("Failed to find value for parameter " << m_definitions[_d.definitionIndex].paramName << ", part " << _d.paramPart);
+				return false;
+			}
+			return true;
+		});
 	}
 
 	bool MidiPacket::create(synthLib::SysexBuffer& _dst, const Data& _data) const
 	{
-		return create(_dst, _data, {});
+		return create(_dst, _data, NamedParamValues{});
 	}
 
 	bool MidiPacket::parse(Data& _data, AnyPartParamValues& _parameterValues, const ParameterDescriptions& _parameters, const Sysex& _src, bool _ignoreChecksumErrors) const
@@ -140,9 +162,10 @@ namespace pluginLib
 			return false;
 		}
 
-		_parameterValues.reserve(_src.size());
+		if(m_hasParameters && _parameterValues.size() <= m_maxParamIndex)
+			_parameterValues.resize(m_maxParamIndex + 1);
 
-		return parse(_data, [&](ParamIndex _paramIndex, uint8_t _value)
+		return parseImpl(_data, [&](ParamIndex _paramIndex, uint8_t _value)
 		{
 			const auto idx = _paramIndex.second;
 			if(_parameterValues.size() <= idx)
@@ -155,7 +178,7 @@ namespace pluginLib
 	{
 		_parameterValues.reserve(_src.size() << 1);
 
-		return parse(_data, [&](ParamIndex _paramIndex, uint8_t _value)
+		return parseImpl(_data, [&](ParamIndex _paramIndex, uint8_t _value)
 		{
 			const auto itExisting = _parameterValues.find(_paramIndex);
 			if(itExisting != _parameterValues.end())
@@ -167,86 +190,151 @@ namespace pluginLib
 	
 	bool MidiPacket::parse(Data& _data, const std::function<void(ParamIndex, ParamValue)>& _addParamValueCallback, const ParameterDescriptions& _parameters, const Sysex& _src, bool _ignoreChecksumErrors) const
 	{
-		if(_src.size() != size())
-			return false;
+		return parseImpl(_data, _addParamValueCallback, _parameters, _src, _ignoreChecksumErrors);
+	}
 
-		for(size_t i=0; i<_src.size(); ++i)
-		{
-			const auto s = _src[i];
+	template<typename TGetParamValue>
+	bool MidiPacket::createImpl(Sysex& _dst, const Data& _data, const TGetParamValue& _getParamValue) const
+	{
+		_dst.assign(size(), 0);
 
-			if(i >= m_byteToDefinitionIndex.size())
-				continue;
+		bool hasChecksums = false;
 
-			const auto& range = m_byteToDefinitionIndex[i];
+		for (const auto& d : m_compiled)
+		{
+			const auto i = d.byteIndex;
 
-			for(auto it = range.begin(); it != range.end(); ++it)
+			switch (d.type)
 			{
-				const auto& d = m_definitions[*it];
-
-				switch (d.type)
+			case MidiDataType::Null:
+				_dst[i] = 0;
+				break;
+			case MidiDataType::Byte:
+				_dst[i] = d.byte;
+				break;
+			case MidiDataType::Parameter:
 				{
-				case MidiDataType::Null: 
-					continue;
-				case MidiDataType::Byte:
-					if(d.byte != s)
+					ParamValue v;
+					if(!_getParamValue(d, v))
 						return false;
-					break;
-				case MidiDataType::Checksum:
+					_dst[i] |= d.packValue(v);
+				}
+				break;
+			case MidiDataType::Checksum:
+				hasChecksums = true;
+				break;
+			default:
+				{
+					const auto it = _data.find(d.type);
+
+					if(it == _data.end())
 					{
-						const uint8_t checksum = calcChecksum(d, _src);
-
-						if(checksum != s)
-						{
-							LOG("Packet checksum error, calculated " << std::hex << static_cast<int>(checksum) << " but data contains " << static_cast<int>(s) << ", packet type " << m_name);
-							if(!_ignoreChecksumErrors)
-								return false;
-						}
+						LOG("Failed to find data of type " << static_cast<int>(d.type) << " to fill byte " << i << " of midi packet");
+						return false;
 					}
-					continue;
-				case MidiDataType::DeviceId:
-				case MidiDataType::Bank:
-				case MidiDataType::Program:
-				case MidiDataType::ParameterIndex:
-				case MidiDataType::ParameterValue:
-				case MidiDataType::Page:
-				case MidiDataType::Part:
-					_data.insert(std::make_pair(d.type, s));
-					break;
-				case MidiDataType::Parameter:
+
+					_dst[i] = it->second;
+				}
+			}
+		}
+
+		// checksums are calculated once all other bytes are known
+		if(hasChecksums)
+		{
+			for (const auto& d : m_compiled)
+			{
+				if(d.type == MidiDataType::Checksum)
+					_dst[d.byteIndex] = calcChecksum(m_definitions[d.definitionIndex], _dst);
+			}
+		}
+
+		return true;
+	}
+
+	template<typename TAddParamValue>
+	bool MidiPacket::parseImpl(Data& _data, const TAddParamValue& _addParamValue, const ParameterDescriptions& _parameters, const Sysex& _src, bool _ignoreChecksumErrors) const
+	{
+		if(_src.size() != size())
+			return false;
+
+		for (const auto& d : m_compiled)
+		{
+			const auto s = _src[d.byteIndex];
+
+			switch (d.type)
+			{
+			case MidiDataType::Null: 
+				continue;
+			case MidiDataType::Byte:
+				if(d.byte != s)
+					return false;
+				break;
+			case MidiDataType::Checksum:
+				{
+					const uint8_t checksum = calcChecksum(m_definitions[d.definitionIndex], _src);
+
+					if(checksum != s)
 					{
-						uint32_t idx;
-						if(!_parameters.getIndexByName(idx, d.paramName))
-						{
-							LOG("Failed to find named parameter " << d.paramName << " while parsing midi packet, midi byte " << i);
+						LOG("Packet checksum error, calculated " << std::hex << static_cast<int>(checksum) << " but data contains " << static_cast<int>(s) << ", packet type " << m_name);
+						if(!_ignoreChecksumErrors)
 							return false;
-						}
-						const auto sUnpacked = d.unpackValue(s);
-						_addParamValueCallback(std::make_pair(d.paramPart, idx), sUnpacked);
 					}
-					break;
-				default:
-					assert(false && "unknown data type");
-					return false;
 				}
+				continue;
+			case MidiDataType::DeviceId:
+			case MidiDataType::Bank:
+			case MidiDataType::Program:
+			case MidiDataType::ParameterIndex:
+			case MidiDataType::ParameterValue:
+			case MidiDataType::Page:
+			case MidiDataType::Part:
+				_data.insert(std::make_pair(d.type, s));
+				break;
+			case MidiDataType::Parameter:
+				{
+					uint32_t idx;
+					if(!getParameterIndex(idx, d, &_parameters))
+					{
+						LOG("Failed to find named parameter " << m_definitions[d.definitionIndex].paramName << " while parsing midi packet, midi byte " << d.byteIndex);
+						return false;
+					}
+					_addParamValue(std::make_pair(d.paramPart, idx), d.unpackValue(s));
+				}
+				break;
+			default:
+				assert(false && "unknown data type");
+				return false;
 			}
 		}
 		return true;
 	}
 
+	bool MidiPacket::getParameterIndex(uint32_t& _index, const CompiledDefinition& _d, const ParameterDescriptions* _parameters) const
+	{
+		if(_d.paramIndex != InvalidIndex)
+		{
+			_index = _d.paramIndex;
+			return true;
+		}
+
+		// packet has not been resolved, fall back to a lookup by name
+		return _parameters && _parameters->getIndexByName(_index, m_definitions[_d.definitionIndex].paramName);
+	}
+
 	bool MidiPacket::getParameterIndices(ParamIndices& _indices, const ParameterDescriptions& _parameters) const
 	{
 		if(!m_hasParameters)
 			return true;
 
-		for (const auto & d : m_definitions)
+		for (const auto & d : m_compiled)
 		{
 			if(d.type != MidiDataType::Parameter)
 				continue;
 
 			uint32_t index;
-			if(!_parameters.getIndexByName(index, d.paramName))
+			if(!getParameterIndex(index, d, &_parameters))
 			{
-				LOG("Failed to retrieve index for parameter " << d.paramName);
+				LOG("Failed to retrieve index for parameter " << m_definitions[d.definitionIndex].paramName);
 				return false;
 			}
 
@@ -279,13 +367,13 @@ namespace pluginLib
 
 		for (const auto idx : defs)
 		{
-			const auto &d = m_definitions[idx];
+			const auto &d = m_compiled[idx];
 
 			uint32_t paramIdx;
 
-			if(!_parameters.getIndexByName(paramIdx, d.paramName))
+			if(!getParameterIndex(paramIdx, d, &_parameters))
 			{
-				LOG("Failed to retrieve index for parameter " << d.paramName);
+				LOG("Failed to retrieve index for parameter " << m_definitions[idx].paramName);
 				return false;
 			}
 
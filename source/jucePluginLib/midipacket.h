@@ -94,7 +94,12 @@ namespace pluginLib
 		const std::vector<MidiDataDefinition>& definitions() { return m_definitions; }
 		uint32_t size() const { return m_byteSize; }
 
+		// looks up the indices of all parameters once so that parsing and creating does not need to search by name
+		bool resolveParameterIndices(const ParameterDescriptions& _parameters);
+
 		bool create(Sysex& _dst, const Data& _data, const NamedParamValues& _paramValues) const;
+		bool create(Sysex& _dst, const Data& _data, const AnyPartParamValues& _paramValues) const;
+		bool create(Sysex& _dst, const Data& _data, const std::function<bool(ParamIndex, ParamValue&)>& _getParamValueCallback) const;
 		bool create(Sysex& _dst, const Data& _data) const;
 		bool parse(Data& _data, AnyPartParamValues& _parameterValues, const ParameterDescriptions& _parameters, const Sysex& _src, bool _ignoreChecksumErrors = true) const;
 		bool parse(Data& _data, ParamValues& _parameterValues, const ParameterDescriptions& _parameters, const Sysex& _src, bool _ignoreChecksumErrors = true) const;
@@ -115,11 +120,41 @@ namespace pluginLib
 		bool hasPartDependentParameters() const { return m_numDifferentPartsUsedInParameters; }
 
 	private:
+		// flat copy of a definition, sorted by byte index, with the parameter index resolved
+		struct CompiledDefinition
+		{
+			MidiDataType type = MidiDataType::Null;
+			uint8_t byte = 0;
+			uint8_t paramMask = 0xff;
+			uint8_t paramShiftRight = 0;
+			uint8_t paramShiftLeft = 0;
+			uint8_t paramPart = AnyPart;
+			uint32_t byteIndex = 0;
+			uint32_t definitionIndex = 0;
+			uint32_t paramIndex = InvalidIndex;
+
+			uint8_t packValue(const ParamValue _unmasked) const
+			{
+				 return static_cast<uint8_t>(((_unmasked & paramMask) << paramShiftRight) >> paramShiftLeft);
+			}
+
+			ParamValue unpackValue(const uint8_t _masked) const
+			{
+				return ((_masked << paramShiftLeft) >> paramShiftRight) & paramMask;
+			}
+		};
+
+		template<typename TGetParamValue> bool createImpl(Sysex& _dst, const Data& _data, const TGetParamValue& _getParamValue) const;
+		template<typename TAddParamValue> bool parseImpl(Data& _data, const TAddParamValue& _addParamValue, const ParameterDescriptions& _parameters, const Sysex& _src, bool _ignoreChecksumErrors) const;
+
+		bool getParameterIndex(uint32_t& _index, const CompiledDefinition& _d, const ParameterDescriptions* _parameters) const;
 
 		static uint8_t calcChecksum(const MidiDataDefinition& _d, const Sysex& _src);
 
 		const std::string m_name;
 		std::vector<MidiDataDefinition> m_definitions;
+		std::vector<CompiledDefinition> m_compiled;
+		uint32_t m_maxParamIndex = 0;
 		std::map<uint32_t, uint32_t> m_definitionToByteIndex;
 		std::vector<std::vector<uint32_t>> m_byteToDefinitionIndex;
 		uint32_t m_byteSize = 0;
@@ -656,8 +656,12 @@ namespace pluginLib
 			}
 		}
 
-		if(!hasErrors)
-			m_midiPackets.insert(std::make_pair(_key, packet));
+		if(hasErrors)
+			return;
+
+		packet.resolveParameterIndices(*this);
+
+		m_midiPackets.insert(std::make_pair(_key, std::move(packet)));
 	}
 
 	void ParameterDescriptions::parseParameterRegions(std::stringstream& _errors, const juce::Array<juce::var>* _regions)
@@ -576,6 +576,7 @@ namespace pluginLib
 		_desc.pluginName = getProperties().name;
 		_desc.pluginVersion = Version::getVersionNumber();
 		_desc.sessionId = m_remoteSessionId;
+		_desc.audioCodec = m_remoteAudioCodec;
 	}
 
 	void Processor::setDeviceType(const DeviceType _type, const bool _forceChange/* = false*/)
@@ -10,6 +10,7 @@
 #include "midiports.h"
 #include "programChangeRouter.h"
 
+#include "bridgeLib/audioCodec.h"
 #include "bridgeLib/types.h"
 
 #include "synthLib/midiRoutingMatrix.h"
@@ -160,6 +161,9 @@ namespace pluginLib
 
 		void getPluginDesc(bridgeLib::PluginDesc& _desc) const;
 
+		// audio codec requested from a remote server, see bridgeLib::AudioCodecType
+		void setRemoteAudioCodec(const bridgeLib::AudioCodecType _type) { m_remoteAudioCodec = _type; }
+
 		void setDeviceType(DeviceType _type, bool _forceChange = false);
 		void setRemoteDevice(const std::string& _host, uint32_t _port);
 		const auto& getRemoteDeviceHost() const { return m_remoteHost; }
@@ -240,6 +244,7 @@ namespace pluginLib
 		std::string m_remoteHost;
 		uint32_t m_remotePort = 0;
 		bridgeLib::SessionId m_remoteSessionId;
+		bridgeLib::AudioCodecType m_remoteAudioCodec = bridgeLib::AudioCodecType::Float32;
 		synthLib::MidiRoutingMatrix m_midiRoutingMatrix;
 		std::string m_programName;
 		std::unique_ptr<MidiLearnTranslator> m_midiLearnTranslator;
@@ -0,0 +1,185 @@
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include "jucePluginLib/midipacket.h"
+#include "jucePluginLib/parameterdescriptions.h"
+
+#include "baseLib/filesystem.h"
+
+using namespace pluginLib;
+
+// Custom assertion that works in both Debug and Release builds
+#define TEST_ASSERT(condition) \
+	do { \
+		if (!(condition)) { \
+			std::ostringstream oss; \
+			oss << "Test assertion failed: " << #condition \
+			    << " at " << __FILE__ << ":" << __LINE__; \
+			throw std::runtime_error(oss.str()); \
+		} \
+	} while (0)
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	constexpr uint32_t g_iterations = 1000;
+
+	const char* const g_descriptionFiles[] =
+	{
+		"osirusJucePlugin/parameterDescriptions_C.json",
+		"osTIrusJucePlugin/parameterDescriptions_TI.json",
+		"mqJucePlugin/parameterDescriptions_mq.json",
+		"xtJucePlugin/parameterDescriptions_xt.json",
+		"nord/n2x/n2xJucePlugin/parameterDescriptions_n2x.json",
+		"ronaldo/je8086/jeJucePlugin/parameterDescriptions_je.json"
+	};
+
+	struct Timings
+	{
+		std::chrono::duration<double> parseByName{0};
+		std::chrono::duration<double> parseByIndex{0};
+		std::chrono::duration<double> createByName{0};
+		std::chrono::duration<double> createByIndex{0};
+	};
+
+	MidiPacket::Data createData()
+	{
+		MidiPacket::Data data;
+
+		for (const auto t : {MidiDataType::DeviceId, MidiDataType::Bank, MidiDataType::Program, MidiDataType::ParameterIndex, MidiDataType::ParameterValue, MidiDataType::Page, MidiDataType::Part})
+			data.insert({t, static_cast<uint8_t>(0)});
+
+		return data;
+	}
+
+	// what the controller used to do before creating a packet, build a map of parameter names to values
+	void createNamedParamValues(MidiPacket::NamedParamValues& _dst, const ParameterDescriptions& _descs, const MidiPacket::AnyPartParamValues& _values)
+	{
+		const auto& descs = _descs.getDescriptions();
+
+		for(size_t i=0; i<_values.size() && i<descs.size(); ++i)
+		{
+			if(_values[i])
+				_dst.insert({{MidiPacket::AnyPart, descs[i].name}, *_values[i]});
+		}
+	}
+
+	// compares a packet that has been resolved at load time against an unresolved copy that looks up parameters by name
+	void testPacket(Timings& _timings, const ParameterDescriptions& _descs, const std::string& _name, const MidiPacket& _resolved)
+	{
+		auto copy = _resolved;
+		const MidiPacket unresolved(_name, std::vector(copy.definitions()));
+
+		const auto data = createData();
+
+		MidiPacket::AnyPartParamValues values(_descs.getDescriptions().size());
+
+		for(size_t i=0; i<values.size(); ++i)
+			values[i] = static_cast<ParamValue>((i * 37) & 0x7f);
+
+		MidiPacket::Sysex sysex;
+
+		if(_resolved.hasPartDependentParameters())
+		{
+			// not supported by the part-agnostic create, use a callback
+			const auto res = _resolved.create(sysex, data, [&](const MidiPacket::ParamIndex& _index, ParamValue& _value)
+			{
+				if(_index.second >= values.size())
+					return false;
+				_value = *values[_index.second];
+				return true;
+			});
+			TEST_ASSERT(res);
+		}
+		else
+		{
+			MidiPacket::Sysex sysexByName;
+			MidiPacket::NamedParamValues named;
+
+			TEST_ASSERT(_resolved.create(sysex, data, values));
+
+			const auto t0 = Clock::now();
+			for(uint32_t i=0; i<g_iterations; ++i)
+			{
+				named.clear();
+				createNamedParamValues(named, _descs, values);
+				unresolved.create(sysexByName, data, named);
+			}
+			const auto t1 = Clock::now();
+			for(uint32_t i=0; i<g_iterations; ++i)
+				_resolved.create(sysex, data, values);
+			const auto t2 = Clock::now();
+
+			TEST_ASSERT(sysex == sysexByName);
+
+			_timings.createByName += t1 - t0;
+			_timings.createByIndex += t2 - t1;
+		}
+
+		MidiPacket::Data dataByName, dataByIndex;
+		MidiPacket::ParamValues paramsByName, paramsByIndex;
+
+		const auto t0 = Clock::now();
+		for(uint32_t i=0; i<g_iterations; ++i)
+		{
+			dataByName.clear();
+			paramsByName.clear();
+			TEST_ASSERT(unresolved.parse(dataByName, paramsByName, _descs, sysex));
+		}
+		const auto t1 = Clock::now();
+		for(uint32_t i=0; i<g_iterations; ++i)
+		{
+			dataByIndex.clear();
+			paramsByIndex.clear();
+			TEST_ASSERT(_resolved.parse(dataByIndex, paramsByIndex, _descs, sysex));
+		}
+		const auto t2 = Clock::now();
+
+		TEST_ASSERT(dataByName == dataByIndex);
+		TEST_ASSERT(paramsByName == paramsByIndex);
+
+		_timings.parseByName += t1 - t0;
+		_timings.parseByIndex += t2 - t1;
+	}
+}
+
+void testMidiPackets(const std::string& _file)
+{
+	std::cout << "Testing midi packets of " << _file << "..." << std::endl;
+
+	std::string json;
+	TEST_ASSERT(baseLib::filesystem::readFile(json, std::string(MIDIPACKETTEST_SOURCE_DIR) + _file));
+
+	const ParameterDescriptions descs(json);
+	TEST_ASSERT(descs.isValid());
+
+	Timings timings;
+
+	for (const auto& [name, packet] : descs.getMidiPackets())
+		testPacket(timings, descs, name, packet);
+
+	std::cout << "  " << descs.getMidiPackets().size() << " packets, " << g_iterations << " iterations each" << std::endl;
+	std::cout << "  parse:  by name " << timings.parseByName.count() << "s, by index " << timings.parseByIndex.count() << "s" << std::endl;
+	std::cout << "  create: by name " << timings.createByName.count() << "s, by index " << timings.createByIndex.count() << "s" << std::endl;
+	std::cout << "  Midi packet tests passed!" << std::endl;
+}
+
+int main()
+{
+	try
+	{
+		for (const auto* file : g_descriptionFiles)
+			testMidiPackets(file);
+
+		std::cout << "All tests passed!" << std::endl;
+		return 0;
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "Test failed: " << e.what() << std::endl;
+		return 1;
+	}
+}
@@ -12,7 +12,7 @@
 
 namespace mqLib
 {
-	ROM initRom(const std::vector<uint8_t>& _romData, const std::string& _romName)
+	ROM initRom(const synthLib::RomData& _romData, const std::string& _romName)
 	{
 		if(_romData.empty())
 			return RomLoader::findROM();
@@ -22,7 +22,7 @@ namespace mqLib
 		return RomLoader::findROM();
 	}
 
-	MicroQ::MicroQ(BootMode _bootMode/* = BootMode::Default*/, const std::vector<uint8_t>& _romData, const std::string& _romName, const bool _voiceExpansion/* = false*/)
+	MicroQ::MicroQ(BootMode _bootMode/* = BootMode::Default*/, const synthLib::RomData& _romData, const std::string& _romName, const bool _voiceExpansion/* = false*/)
 	{
 		const ROM romFile = initRom(_romData, _romName);
 
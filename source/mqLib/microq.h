@@ -11,6 +11,8 @@
 #include "leds.h"
 #include "mqtypes.h"
 
+#include "synthLib/romData.h"
+
 namespace synthLib
 {
 	struct SMidiEvent;
@@ -23,7 +25,7 @@ namespace mqLib
 	class MicroQ
 	{
 	public:
-		MicroQ(BootMode _bootMode = BootMode::Default, const std::vector<uint8_t>& _romData = {}, const std::string& _romName = {}, bool _voiceExpansion = false);
+		MicroQ(BootMode _bootMode = BootMode::Default, const synthLib::RomData& _romData = {}, const std::string& _romName = {}, bool _voiceExpansion = false);
 		~MicroQ();
 
 		// returns true if the instance is valid, false if the initialization failed
@@ -487,20 +487,7 @@ namespace mqLib
 
 				const auto requiredSize = processCount > 8 ? processCount - 8 : 0;
 
-				if(esai.getAudioOutputs().size() < requiredSize)
-				{
-					// reduce thread contention by waiting for output buffer to be full enough to let us grab the data without entering the read mutex too often
-
-					std::unique_lock uLock(m_requestedFramesAvailableMutex);
-					m_requestedFrames = requiredSize;
-					m_requestedFramesAvailableCv.wait(uLock, [&]()
-					{
-						if(esai.getAudioOutputs().size() < requiredSize)
-							return false;
-						m_requestedFrames = 0;
-						return true;
-					});
-				}
+				waitForAudioOutputs(esai, requiredSize);
 
 				esai.processAudioOutputInterleaved(outputs, processCount);
 			}
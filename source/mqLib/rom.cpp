@@ -9,7 +9,7 @@ namespace mqLib
 		verifyRom();
 	}
 
-	ROM::ROM(const std::vector<uint8_t>& _data, const std::string& _name) : wLib::ROM(_name, g_romSize, _data)
+	ROM::ROM(synthLib::RomData _data, const std::string& _name) : wLib::ROM(_name, g_romSize, std::move(_data))
 	{
 		verifyRom();
 	}
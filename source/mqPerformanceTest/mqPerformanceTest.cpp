@@ -15,11 +15,58 @@
 #ifdef _WIN32
 #include <crtdbg.h>
 #include <csignal>
+#else
+#include <sys/resource.h>
 #endif
 
 using ButtonType = mqLib::Buttons::ButtonType;
 using EncoderType = mqLib::Buttons::Encoders;
 
+namespace
+{
+	// voluntary context switches of the whole process, each one is a thread that blocked in a system call
+	uint64_t getVoluntaryContextSwitches()
+	{
+#ifdef _WIN32
+		return 0;
+#else
+		rusage usage{};
+		getrusage(RUSAGE_SELF, &usage);
+		return static_cast<uint64_t>(usage.ru_nvcsw);
+#endif
+	}
+
+	struct SyncSnapshot
+	{
+		wLib::Hardware::SyncStats stats;
+		uint64_t contextSwitches = 0;
+
+		static SyncSnapshot create(mqLib::MicroQ& _mq)
+		{
+			return {_mq.getHardware()->getSyncStats(), getVoluntaryContextSwitches()};
+		}
+	};
+
+	void printSyncStats(const char* _name, const SyncSnapshot& _begin, const SyncSnapshot& _end)
+	{
+		const auto frames = _end.stats.esaiFrames - _begin.stats.esaiFrames;
+
+		if(!frames)
+			return;
+
+		const auto perSecond = [&](const uint64_t _first, const uint64_t _last)
+		{
+			return static_cast<double>(_last - _first) * 44100.0 / static_cast<double>(frames);
+		};
+
+		std::cout << _name << ": " << frames << " ESAI frames, per second of audio: "
+			<< perSecond(_begin.stats.ucWaits, _end.stats.ucWaits) << " uc waits, "
+			<< perSecond(_begin.stats.ucWakeups, _end.stats.ucWakeups) << " uc wakeups, "
+			<< perSecond(_begin.stats.dspHalts, _end.stats.dspHalts) << " DSP halts, "
+			<< perSecond(_begin.contextSwitches, _end.contextSwitches) << " voluntary context switches" << std::endl;
+	}
+}
+
 int main(int _argc, char* _argv[])
 {
 #ifdef _WIN32
@@ -105,6 +152,10 @@ int main(int _argc, char* _argv[])
 	bool demoStarted = false;
 	int playRetryCounter = 0;
 
+	// the uc syncs to the DSP in larger chunks while nothing is going on. Idle is the time between the init sound
+	// showing up and the first button press, active is the demo playback
+	SyncSnapshot syncIdleStart, syncIdleEnd, syncActiveStart;
+
 	while(true)
 	{
 
@@ -127,6 +178,7 @@ int main(int _argc, char* _argv[])
 				std::cout << "Init Sound detected, starting demo sequence" << std::endl;
 				waitingForInitSound = false;
 				counter = 80000 / blockSize;
+				syncIdleStart = SyncSnapshot::create(mq);
 			}
 		}
 
@@ -135,6 +187,7 @@ int main(int _argc, char* _argv[])
 			--counter;
 			if(counter == 50000 / blockSize)
 			{
+				syncIdleEnd = SyncSnapshot::create(mq);
 				mq.setButton(ButtonType::Multimode, true);
 				std::cout << "Pressing Multimode + Peek" << std::endl;
 			}
@@ -154,6 +207,7 @@ int main(int _argc, char* _argv[])
 			}
 			else if(counter == 0)
 			{
+				syncActiveStart = SyncSnapshot::create(mq);
 				mq.setButton(ButtonType::Play, false);
 
 				mq.getHardware()->getDspThread(0).setLogToStdout(true);
@@ -230,6 +284,9 @@ int main(int _argc, char* _argv[])
 		}
 	}
 
+	printSyncStats("uc/DSP sync idle", syncIdleStart, syncIdleEnd);
+	printSyncStats("uc/DSP sync active", syncActiveStart, SyncSnapshot::create(mq));
+
 	std::cout << '\a';
 	std::cin.ignore();
 
@@ -66,7 +66,7 @@ namespace n2xJucePlugin
 
 		if(rom.isValid())
 		{
-			_params.romData.assign(rom.data().begin(), rom.data().end());
+			_params.romData = rom.data();
 			_params.romName = rom.getFilename();
 		}
 	}
@@ -150,6 +150,8 @@ namespace n2x
 	{
 		if(_needMoreData)
 		{
+			m_hardware.notifyUcActivity();
+
 			dsp56k::ScopedResumeDSP rA(m_hardware.getDSPA().getHaltDSP());
 			dsp56k::ScopedResumeDSP rB(m_hardware.getDSPB().getHaltDSP());
 
@@ -185,6 +187,8 @@ namespace n2x
 		}
 		else
 		{
+			m_hardware.notifyUcActivity();
+
 			dsp().injectExternalInterrupt(_irq);
 			dsp().injectExternalInterrupt(m_irqInterruptDone);
 
@@ -1,5 +1,7 @@
 #include "n2xhardware.h"
 
+#include <algorithm>
+
 #include "n2xromloader.h"
 #include "dsp56kBase/threadtools.h"
 #include "synthLib/deviceException.h"
@@ -9,10 +11,16 @@ namespace n2x
 	constexpr uint32_t g_syncEsaiFrameRate = 16;
 	constexpr uint32_t g_syncHaltDspEsaiThreshold = 32;
 
+	// if nothing is going on, the uc is synced to the DSPs in chunks of this many frames only. Once MIDI input or
+	// DSP communication is in flight, it syncs every g_syncEsaiFrameRate frames for at least g_syncLockstepHoldFrames
+	constexpr uint32_t g_syncEsaiFramesIdle = 32;
+	constexpr uint32_t g_syncLockstepHoldFrames = 4096;
+
 	static_assert((g_syncEsaiFrameRate & (g_syncEsaiFrameRate - 1)) == 0, "esai frame sync rate must be power of two");
 	static_assert(g_syncHaltDspEsaiThreshold >= g_syncEsaiFrameRate * 2, "esai DSP halt threshold must be greater than two times the sync rate");
+	static_assert(g_syncEsaiFramesIdle >= g_syncEsaiFrameRate, "idle sync must not be more fine grained than the active sync");
 
-	Rom initRom(const std::vector<uint8_t>& _romData, const std::string& _romName)
+	Rom initRom(const synthLib::RomData& _romData, const std::string& _romName)
 	{
 		if(_romData.empty())
 			return RomLoader::findROM();
@@ -22,7 +30,7 @@ namespace n2x
 		return RomLoader::findROM();
 	}
 
-	Hardware::Hardware(const std::vector<uint8_t>& _romData, const std::string& _romName)
+	Hardware::Hardware(const synthLib::RomData& _romData, const std::string& _romName)
 		: m_rom(initRom(_romData, _romName))
 		, m_uc(*this, m_rom)
 		, m_dspA(*this, m_uc.getHdi08A(), 0)
@@ -206,10 +214,12 @@ namespace n2x
 		m_semDspAtoB.wait();
 	}
 
-	void Hardware::processMidiInput()
+	bool Hardware::processMidiInput()
 	{
 		++m_midiOffsetCounter;
 
+		bool written = false;
+
 		while(!m_midiIn.empty())
 		{
 			const auto& e = m_midiIn.front();
@@ -219,19 +229,37 @@ namespace n2x
 
 			getMidi().write(e);
 			m_midiIn.pop_front();
+			written = true;
 		}
+
+		if(written)
+			notifyUcActivity();
+
+		return written;
 	}
 
 	void Hardware::onEsaiCallbackB()
 	{
 		m_semDspAtoB.notify();
 
-		++m_esaiFrameIndex;
+		const auto esaiFrameIndex = m_esaiFrameIndex.load(std::memory_order_relaxed) + 1;
+		m_esaiFrameIndex.store(esaiFrameIndex, std::memory_order_relaxed);
+
+		const auto midiWritten = processMidiInput();
 
-		processMidiInput();
+		// either the uc sees the new frame index or we see the frame index it waits for, see waitForEsaiFrame
+		std::atomic_thread_fence(std::memory_order_seq_cst);
 
-		if((m_esaiFrameIndex & (g_syncEsaiFrameRate-1)) == 0)
+		auto ucWaitFrameIndex = m_ucWaitFrameIndex.load(std::memory_order_relaxed);
+
+		// wake the uc early if it waits for a large chunk of frames but MIDI has arrived
+		if(ucWaitFrameIndex && (esaiFrameIndex >= ucWaitFrameIndex || midiWritten) && m_ucWaitFrameIndex.compare_exchange_strong(ucWaitFrameIndex, 0))
+		{
+			{
+				std::lock_guard uLock(m_esaiFrameAddedMutex);
+			}
 			m_esaiFrameAddedCv.notify_one();
+		}
 
 		m_requestedFramesAvailableMutex.lock();
 
@@ -256,14 +284,18 @@ namespace n2x
 		if(m_esaiFrameIndex <= 0)
 			return;
 
-		if(m_esaiFrameIndex == m_lastEsaiFrameIndex)
+		if(m_ucActivity.exchange(false, std::memory_order_relaxed) || !m_midiIn.empty())
+			m_syncLockstepEnd = m_lastEsaiFrameIndex + g_syncLockstepHoldFrames;
+
+		const uint32_t syncFrames = static_cast<int32_t>(m_syncLockstepEnd - m_lastEsaiFrameIndex) > 0 ? g_syncEsaiFrameRate : g_syncEsaiFramesIdle;
+
+		if(m_esaiFrameIndex - m_lastEsaiFrameIndex < syncFrames)
 		{
 			resumeDSPs();
-			std::unique_lock uLock(m_esaiFrameAddedMutex);
-			m_esaiFrameAddedCv.wait(uLock, [this]{return m_esaiFrameIndex > m_lastEsaiFrameIndex;});
+			waitForEsaiFrame(m_lastEsaiFrameIndex + syncFrames);
 		}
 
-		const auto esaiFrameIndex = m_esaiFrameIndex;
+		const auto esaiFrameIndex = m_esaiFrameIndex.load(std::memory_order_acquire);
 		const auto esaiDelta = esaiFrameIndex - m_lastEsaiFrameIndex;
 
 		const auto ucClock = m_uc.getSim().getSystemClockHz();
@@ -281,12 +313,34 @@ namespace n2x
 		// and consume them
 		m_remainingUcCyclesD -= static_cast<double>(m_remainingUcCycles);
 
-		if(esaiDelta > g_syncHaltDspEsaiThreshold)
+		// the uc is expected to lag behind by up to one sync chunk
+		if(esaiDelta > std::max(g_syncHaltDspEsaiThreshold, syncFrames * 2))
 			haltDSPs();
 
 		m_lastEsaiFrameIndex = esaiFrameIndex;
 	}
 
+	void Hardware::waitForEsaiFrame(const uint32_t _frameIndex)
+	{
+		std::unique_lock uLock(m_esaiFrameAddedMutex);
+
+		m_ucWaitFrameIndex.store(_frameIndex, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		// the DSP thread resets the frame index we are waiting for if it wakes us up
+		m_esaiFrameAddedCv.wait(uLock, [&]
+		{
+			return m_ucWaitFrameIndex.load(std::memory_order_relaxed) == 0 || m_esaiFrameIndex.load(std::memory_order_acquire) >= _frameIndex;
+		});
+
+		m_ucWaitFrameIndex.store(0, std::memory_order_relaxed);
+	}
+
+	void Hardware::notifyUcActivity()
+	{
+		m_ucActivity.store(true, std::memory_order_relaxed);
+	}
+
 	void Hardware::ucThreadFunc()
 	{
 		dsp56k::ThreadTools::setCurrentThreadName("MC68331");
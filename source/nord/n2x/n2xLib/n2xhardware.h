@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+
 #include "n2xdsp.h"
 #include "n2xmc.h"
 #include "n2xrom.h"
@@ -13,7 +15,7 @@ namespace n2x
 	{
 	public:
 		using AudioOutputs = std::array<std::vector<dsp56k::TWord>, 4>;
-		Hardware(const std::vector<uint8_t>& _romData = {}, const std::string& _romName = {});
+		Hardware(const synthLib::RomData& _romData = {}, const std::string& _romName = {});
 		~Hardware();
 
 		bool isValid() const;
@@ -35,6 +37,9 @@ namespace n2x
 		void resumeDSPs();
 		bool requestingHaltDSPs() const { return m_dspHalted; }
 
+		// lets the uc sync to the DSPs every frame for a while, call when communication between uc and DSP happens
+		void notifyUcActivity();
+
 		bool getButtonState(ButtonType _type) const;
 		void setButtonState(ButtonType _type, bool _pressed);
 
@@ -50,9 +55,10 @@ namespace n2x
 	private:
 		void ensureBufferSize(uint32_t _frames);
 		void onEsaiCallbackA();
-		void processMidiInput();
+		bool processMidiInput();
 		void onEsaiCallbackB();
 		void syncUCtoDSP();
+		void waitForEsaiFrame(uint32_t _frameIndex);
 		void ucThreadFunc();
 		void advanceSamples(uint32_t _samples, uint32_t _latency);
 
@@ -69,12 +75,15 @@ namespace n2x
 
 		// timing
 		const double m_samplerateInv;
-		uint32_t m_esaiFrameIndex = 0;
+		std::atomic<uint32_t> m_esaiFrameIndex{0};
 		uint32_t m_lastEsaiFrameIndex = 0;
 		int64_t m_remainingUcCycles = 0;
 		double m_remainingUcCyclesD = 0;
+		uint32_t m_syncLockstepEnd = 0;
+		std::atomic<bool> m_ucActivity{true};
 		std::mutex m_esaiFrameAddedMutex;
 		dsp56k::ConditionVariable m_esaiFrameAddedCv;
+		std::atomic<uint32_t> m_ucWaitFrameIndex{0};		// frame index the uc waits for, 0 = not waiting
 		std::mutex m_requestedFramesAvailableMutex;
 		dsp56k::ConditionVariable m_requestedFramesAvailableCv;
 		size_t m_requestedFrames = 0;
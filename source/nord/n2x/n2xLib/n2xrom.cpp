@@ -16,7 +16,7 @@ namespace n2x
 			invalidate();
 	}
 
-	Rom::Rom(const std::vector<uint8_t>& _data, const std::string& _filename) : RomData(_data, _filename)
+	Rom::Rom(synthLib::RomData _data, const std::string& _filename) : RomData(std::move(_data), _filename)
 	{
 		if(!isValidRom(data()))
 			invalidate();
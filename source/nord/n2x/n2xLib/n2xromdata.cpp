@@ -16,24 +16,24 @@ namespace n2x
 	{
 		if(_filename.empty())
 			return;
-		if(!baseLib::filesystem::readFile(m_data, _filename))
+		if(!m_data.loadFromFile(_filename))
 			return;
 		if(m_data.size() != MySize)
 			return;
 		m_filename = _filename;
 	}
 
-	template <uint32_t Size> RomData<Size>::RomData(const std::vector<uint8_t>& _data, const std::string& _filename)
+	template <uint32_t Size> RomData<Size>::RomData(synthLib::RomData _data, const std::string& _filename)
 	{
 		if(_data.size() != MySize)
 			return;
-		m_data = _data;
+		m_data = std::move(_data);
 		m_filename = _filename;
 	}
 
 	template <uint32_t Size> void RomData<Size>::saveAs(const std::string& _filename) const
 	{
-		baseLib::filesystem::writeFile(_filename, m_data);
+		baseLib::filesystem::writeFile(_filename, m_data.get());
 	}
 
 	template class RomData<g_flashSize>;
@@ -1,21 +1,43 @@
 #include "storage.h"
 
+#include <algorithm>
 #include <cassert>
-#include <cstddef>
+#include <cstring>
 
 namespace rLib
 {
-	bool Storage::write(const Address4& _addr, const std::vector<uint8_t>& _data)
+	Storage::Page::Page()
 	{
-		if (_data.empty())
+		data.fill(InvalidData);
+	}
+
+	bool Storage::write(const Address4& _addr, const uint8_t* _data, const size_t _count)
+	{
+		if (!_count)
 			return false;
 
-		const auto linearAddr = toLinearAddress(_addr);
+		auto linearAddr = toLinearAddress(_addr);
 
-		for (size_t i=0; i<_data.size(); ++i)
+		if (linearAddr + _count > AddressSpaceSize)
+			return false;
+
+		for (size_t i=0; i<_count;)
 		{
-			if (!write(fromLinearAddress(linearAddr + static_cast<uint32_t>(i)), _data[i]))
-				return false;
+			auto& page = getPage(linearAddr);
+
+			const auto offset = linearAddr & PageMask;
+			const auto num = static_cast<uint32_t>(std::min<size_t>(_count - i, PageSize - offset));
+
+			for (uint32_t j=0; j<num; ++j)
+				assert(_data[i + j] < 0x80); // Only 7 bits are valid
+
+			::memcpy(&page.data[offset], _data + i, num);
+
+			for (auto b = offset >> BlockShift; b <= (offset + num - 1) >> BlockShift; ++b)
+				page.dirty.set(b);
+
+			i += num;
+			linearAddr += num;
 		}
 
 		return true;
@@ -23,41 +45,68 @@ namespace rLib
 
 	bool Storage::write(const Address4& _addr, const uint8_t _data)
 	{
-		assert(_data < 0x80); // Only 7 bits are valid
+		return write(_addr, &_data, 1);
+	}
 
-		const auto block = toBlockAddress(_addr);
-		const auto offset = _addr.back();
+	uint8_t Storage::read(const Address4& _addr) const
+	{
+		const auto linearAddr = toLinearAddress(_addr);
+		const auto* page = findPage(linearAddr);
+		if (!page)
+			return InvalidData;
+		return page->data[linearAddr & PageMask];
+	}
+
+	uint32_t Storage::read(uint8_t* _data, const Address4& _addr, const uint32_t _count) const
+	{
+		auto linearAddr = toLinearAddress(_addr);
 
-		auto it = m_storage.find(block);
-		if (it == m_storage.end())
+		uint32_t i = 0;
+
+		while (i < _count && linearAddr < AddressSpaceSize)
 		{
-			it = m_storage.emplace(block, Block{}).first;
-			it->second.fill(InvalidData);
+			const auto* page = findPage(linearAddr);
+			if (!page)
+				break;
+
+			const auto offset = linearAddr & PageMask;
+			const auto num = std::min(_count - i, PageSize - offset);
+
+			const auto* src = &page->data[offset];
+			const auto valid = static_cast<uint32_t>(std::find(src, src + num, InvalidData) - src);
+
+			::memcpy(_data + i, src, valid);
+			i += valid;
+
+			if (valid != num)
+				break;
+
+			linearAddr += num;
 		}
-		it->second[offset] = _data;
-		return true;
+		return i;
 	}
 
-	uint8_t Storage::read(const Address4& _addr) const
+	bool Storage::isDirty(const Address4& _addr, const uint32_t _count) const
 	{
-		const auto it = m_storage.find(toBlockAddress(_addr));
-		if (it == m_storage.end())
-			return InvalidData;
-		return it->second[_addr.back()];
+		return !forEachPageBlocks(toLinearAddress(_addr), _count, [](const Page& _page, const uint32_t _first, const uint32_t _last)
+		{
+			for (auto b = _first; b <= _last; ++b)
+			{
+				if (_page.dirty.test(b))
+					return false;
+			}
+			return true;
+		});
 	}
 
-	uint32_t Storage::read(std::vector<uint8_t>& _data, const Address4& _addr, const uint32_t _count) const
+	void Storage::clearDirty(const Address4& _addr, const uint32_t _count) const
 	{
-		_data.reserve(_data.size() + _count);
-		const auto linearAddr = toLinearAddress(_addr);
-		for (uint32_t i = 0; i < _count; ++i)
+		forEachPageBlocks(toLinearAddress(_addr), _count, [](const Page& _page, const uint32_t _first, const uint32_t _last)
 		{
-			auto b = read(fromLinearAddress(linearAddr + i));
-			if (b == InvalidData)
-				return i;
-			_data.push_back(b);
-		}
-		return _count;
+			for (auto b = _first; b <= _last; ++b)
+				_page.dirty.reset(b);
+			return true;
+		});
 	}
 
 	uint32_t Storage::toLinearAddress(const Address4 _addr)
@@ -78,4 +127,49 @@ namespace rLib
 			static_cast<uint8_t>(_addr & 0x7f)
 		};
 	}
+
+	const Storage::Page* Storage::findPage(const uint32_t _linearAddr) const
+	{
+		const auto index = _linearAddr >> PageShift;
+		if (index >= m_pages.size())
+			return nullptr;
+		return m_pages[index].get();
+	}
+
+	Storage::Page& Storage::getPage(const uint32_t _linearAddr)
+	{
+		const auto index = _linearAddr >> PageShift;
+
+		if (index >= m_pages.size())
+			m_pages.resize(index + 1);
+
+		auto& page = m_pages[index];
+		if (!page)
+			page.reset(new Page());
+		return *page;
+	}
+
+	template<typename TFunc> bool Storage::forEachPageBlocks(uint32_t _linearAddr, const uint32_t _count, TFunc _func) const
+	{
+		if (!_count)
+			return true;
+
+		const auto end = std::min(_linearAddr + _count, AddressSpaceSize);
+
+		while (_linearAddr < end)
+		{
+			const auto offset = _linearAddr & PageMask;
+			const auto num = std::min(end - _linearAddr, PageSize - offset);
+
+			// pages that have not been allocated yet do not contain any dirty blocks
+			if (const auto* page = findPage(_linearAddr))
+			{
+				if (!_func(*page, offset >> BlockShift, (offset + num - 1) >> BlockShift))
+					return false;
+			}
+
+			_linearAddr += num;
+		}
+		return true;
+	}
 }
@@ -1,14 +1,16 @@
 #pragma once
 
 #include <array>
+#include <bitset>
+#include <cstddef>
 #include <cstdint>
-#include <map>
+#include <memory>
 #include <vector>
 
 namespace rLib
 {
 	/* Ronaldo uses a generic address scheme of XXYYZZWW and each byte is only 7 bits. This class abstracts that storage
-	 * by allocating blocks of 128 bytes
+	 * by mapping the resulting 28 bit linear address space to pages of 128 blocks of 128 bytes each, pages are allocated on first write
 	 */
 	class Storage
 	{
@@ -20,24 +22,42 @@ namespace rLib
 		static constexpr uint8_t InvalidData = 0xff;
 		static constexpr uint32_t BlockShift = 7;
 		static constexpr uint32_t BlockSize = 1 << BlockShift;
+		static constexpr uint32_t PageShift = BlockShift + 7;
+		static constexpr uint32_t PageSize = 1 << PageShift;
+		static constexpr uint32_t PageMask = PageSize - 1;
+		static constexpr uint32_t BlocksPerPage = PageSize / BlockSize;
+		static constexpr uint32_t AddressSpaceSize = 1 << 28;
 
 		using Block = std::array<uint8_t, BlockSize>;
 
-		bool write(const Address4& _addr, const std::vector<uint8_t>& _data);
+		bool write(const Address4& _addr, const std::vector<uint8_t>& _data)
+		{
+			return write(_addr, _data.data(), _data.size());
+		}
+		bool write(const Address4& _addr, const uint8_t* _data, size_t _count);
 		bool write(const Address4& _addr, uint8_t _data);
 
 		uint8_t read(const Address4& _addr) const;
-		uint32_t read(std::vector<uint8_t>& _data, const Address4& _addr, uint32_t _count) const;
-		
+
+		// reads until either _count bytes have been read or unwritten data is encountered, returns the number of bytes read
+		uint32_t read(uint8_t* _data, const Address4& _addr, uint32_t _count) const;
+
+		// appends to a vector-like container
 		template<typename T>
 		uint32_t read(T& _data, const Address4& _addr, const uint32_t _count) const
 		{
-			std::vector<uint8_t> temp;
-			auto result = read(temp, _addr, _count);
-			_data.insert(_data.end(), temp.begin(), temp.end());
+			const auto oldSize = _data.size();
+			_data.resize(oldSize + _count);
+			const auto result = read(_data.data() + oldSize, _addr, _count);
+			_data.resize(oldSize + result);
 			return result;
 		}
 
+		// blocks are marked dirty when written. Dirty state is bookkeeping for users that cache data derived from the
+		// storage and can therefore be cleared on a const object
+		bool isDirty(const Address4& _addr, uint32_t _count) const;
+		void clearDirty(const Address4& _addr, uint32_t _count) const;
+
 		static uint32_t toLinearAddress(Address4 _addr);
 		static Address4 fromLinearAddress(uint32_t _addr);
 
@@ -52,6 +72,19 @@ namespace rLib
 		}
 
 	private:
-		std::map<Address3, Block> m_storage;
+		struct Page
+		{
+			Page();
+
+			std::array<uint8_t, PageSize> data;
+			mutable std::bitset<BlocksPerPage> dirty;
+		};
+
+		const Page* findPage(uint32_t _linearAddr) const;
+		Page& getPage(uint32_t _linearAddr);
+
+		template<typename TFunc> bool forEachPageBlocks(uint32_t _linearAddr, uint32_t _count, TFunc _func) const;
+
+		std::vector<std::unique_ptr<Page>> m_pages;
 	};
 }
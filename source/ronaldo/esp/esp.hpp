@@ -32,6 +32,9 @@ public:
 	inline int32_t getPipelineRawFull() const { return hist[head]; }
 	
 	inline void storePipeline() { hist[head++] = acc; if (head == delay) head = 0; }
+
+	template<typename TStream> void saveState(TStream& _s) const { _s.write(acc); _s.write(hist); _s.write(head); }
+	template<typename TStream> void loadState(TStream& _s) { _s.read(acc); _s.read(hist); _s.read(head); }
 protected:
 	static constexpr int delay {3}; // delay
 	int32_t acc {0}, hist[delay] = {}, head {0};
@@ -98,6 +101,24 @@ public:
 		}
 	}
 
+	template<typename TStream> void saveState(TStream& _s) const
+	{
+		_s.write(eram);
+		_s.write(eramReadLatch); _s.write(eramWriteLatch); _s.write(eramVarOffset);
+		_s.write(eramPos); _s.write(eramEffectiveAddr); _s.write(eramImmOffsetAccNext); _s.write(eramHighOffset); _s.write(eramWriteLatchNext);
+		_s.write(eramPCCommit); _s.write(eramPCStartNext); _s.write(eramModeCurrent); _s.write(eramModeNext);
+		_s.write(eramActiveCurrent); _s.write(eramActiveNext);
+	}
+
+	template<typename TStream> void loadState(TStream& _s)
+	{
+		_s.read(eram);
+		_s.read(eramReadLatch); _s.read(eramWriteLatch); _s.read(eramVarOffset);
+		_s.read(eramPos); _s.read(eramEffectiveAddr); _s.read(eramImmOffsetAccNext); _s.read(eramHighOffset); _s.read(eramWriteLatchNext);
+		_s.read(eramPCCommit); _s.read(eramPCStartNext); _s.read(eramModeCurrent); _s.read(eramModeNext);
+		_s.read(eramActiveCurrent); _s.read(eramActiveNext);
+	}
+
 	int32_t eramReadLatch = 0, eramWriteLatch = 0, eramVarOffset = 0;
 protected:
 	static constexpr int64_t ERAM_COMMIT_STAGE = 10, ERAM_MASK_FULL = (1 << 19) - 1;
@@ -132,6 +153,9 @@ struct SharedState {
 		memset(mulcoeffs, 0, sizeof(mulcoeffs));
 		eram.reset();
 	}
+
+	template<typename TStream> void saveState(TStream& _s) const { _s.write(gram); _s.write(readback_regs); _s.write(mulcoeffs); eram.saveState(_s); }
+	template<typename TStream> void loadState(TStream& _s) { _s.read(gram); _s.read(readback_regs); _s.read(mulcoeffs); eram.loadState(_s); }
 };
 
 template<int lg2eram_size>
@@ -142,6 +166,21 @@ public:
 
 	void reset() { memset(iram, 0, sizeof(iram)); pc = iramPos = 0; accA.reset(); accB.reset(); }
 
+	// PRAM and shared state belong to the ESP and are serialized there
+	template<typename TStream> void saveState(TStream& _s) const
+	{
+		_s.write(iram); _s.write(last_mulInputA_24); _s.write(last_mulInputB_24); _s.write(skipfield); _s.write(lastMul30);
+		_s.write(pc); _s.write(iramPos); _s.write(pcjumpat); _s.write(pcjumpto);
+		accA.saveState(_s); accB.saveState(_s);
+	}
+
+	template<typename TStream> void loadState(TStream& _s)
+	{
+		_s.read(iram); _s.read(last_mulInputA_24); _s.read(last_mulInputB_24); _s.read(skipfield); _s.read(lastMul30);
+		_s.read(pc); _s.read(iramPos); _s.read(pcjumpat); _s.read(pcjumpto);
+		accA.loadState(_s); accB.loadState(_s);
+	}
+
 	void setup(const uint32_t *_pram, SharedState<lg2eram_size> *_shared) { pram = _pram; shared = _shared; }
 
 	void writeGRAM(int32_t val, uint32_t offset) {shared->gram[(offset + iramPos) & IRAM_MASK] = val;}
@@ -389,6 +428,24 @@ public:
 
 	uint8_t readuC(uint32_t address) { return shared.readback_regs[address & 3]; }
 
+	// Complete state of the chip including the state of the jitted program. Loading regenerates the program for the
+	// loaded PRAM, the JitCache usually has it already
+	template<typename TStream> void saveState(TStream& _s) const
+	{
+		_s.write(intmem); _s.write(if_mode); _s.write(addr_sel); _s.write(program_writing_word);
+		core0.saveState(_s); core1.saveState(_s);
+		shared.saveState(_s);
+		opt.saveState(_s);
+	}
+
+	template<typename TStream> void loadState(TStream& _s)
+	{
+		_s.read(intmem); _s.read(if_mode); _s.read(addr_sel); _s.read(program_writing_word);
+		core0.loadState(_s); core1.loadState(_s);
+		shared.loadState(_s);
+		opt.loadState(_s);
+	}
+
 	void writeuC(uint32_t address, uint8_t value) {
 		address&=0x3fff;
 		program_writing_word[address & 3] = value;
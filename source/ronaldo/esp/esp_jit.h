@@ -8,6 +8,8 @@ struct ESPOptInstr;
 
 namespace esp
 {
+	struct JitBlockData;
+
 	class EspJitBase
 	{
 	public:
@@ -16,6 +18,12 @@ namespace esp
 		virtual void jitEnter() = 0;
 		virtual void jitExit() = 0;
 
+		// block functions run both cores for several samples in a loop, see ESPOptimizer::genBlock
+		virtual void blockBegin() = 0;
+		virtual void blockEnd(const JitBlockData& _block) = 0;
+		virtual void coreBegin() = 0;
+		virtual void coreEnd() = 0;
+
 		virtual void eramRead(uint32_t _eramMask) = 0;
 		virtual void eramWrite(uint32_t _eramMask) = 0;
 		virtual void eramComputeAddr(uint32_t immOffset, bool highOffset, bool shouldUseVarOffset) = 0;
@@ -42,4 +50,17 @@ namespace esp
 		int32_t* last_mulInputA_24;
 		int32_t* last_mulInputB_24;
 	};
+
+	struct JitBlockData
+	{
+		uint32_t* iramPos1 = nullptr;	// iram position of the second core, advanced at the end of each sample, too
+
+		// GRAM locations that are stored to / loaded from the block output / input frames at the end of each sample
+		const uint8_t* gramOut = nullptr;
+		uint32_t gramOutCount = 0;
+		const uint8_t* gramIn = nullptr;
+		uint32_t gramInCount = 0;
+
+		uint32_t eramMask = 0;		// zero if there is no ERAM
+	};
 }
@@ -15,7 +15,7 @@
 // x4  eramPos
 // x5  iramPos
 // x6  (reserved)
-// x7  (reserved)
+// x7  (block frame ptr)
 
 // state:
 // x8  eramEffectiveAddr
@@ -50,6 +50,7 @@ namespace esp
 	constexpr auto ptrVars = x3;
 	constexpr auto eramPos = x4;
 	constexpr auto iramPos = x5;
+	constexpr auto ptrFrame = x7;
 
 	constexpr auto eramEffectiveAddr = x8;
 	constexpr auto eramWriteLatchNext = x9;
@@ -104,6 +105,99 @@ namespace esp
 	    m_asm.ret(x30);
 	}
 
+	void EspJitArm64::blockBegin()
+	{
+		m_blockLoop = m_asm.newLabel();
+		m_asm.bind(m_blockLoop);
+	}
+
+	void EspJitArm64::blockEnd(const JitBlockData& _block)
+	{
+		// ptrVars, ptrGram and iramPos refer to the first core here
+		if (_block.gramOutCount)
+		{
+			m_asm.ldr(ptrFrame, ptr(ptrVars, offsetof(CoreData, blockOut)));
+
+			for (uint32_t i=0; i<_block.gramOutCount; ++i)
+			{
+				// frame[i] = gram[(gramOut[i] + iramPos) & 0xff]
+				m_asm.add(tempB, iramPos, _block.gramOut[i]);
+				m_asm.and_(tempB, tempB, 0xff);
+				m_asm.ldr(tempA.w(), ptr(ptrGram, tempB, lsl(2)));
+				m_asm.str(tempA.w(), ptr(ptrFrame, i << 2));
+			}
+
+			m_asm.add(ptrFrame, ptrFrame, _block.gramOutCount << 2);
+			m_asm.str(ptrFrame, ptr(ptrVars, offsetof(CoreData, blockOut)));
+		}
+
+		if (_block.gramInCount)
+		{
+			m_asm.ldr(ptrFrame, ptr(ptrVars, offsetof(CoreData, blockIn)));
+
+			for (uint32_t i=0; i<_block.gramInCount; ++i)
+			{
+				// gram[(gramIn[i] + iramPos) & 0xff] = frame[i]
+				m_asm.ldr(tempA.w(), ptr(ptrFrame, i << 2));
+				m_asm.add(tempB, iramPos, _block.gramIn[i]);
+				m_asm.and_(tempB, tempB, 0xff);
+				m_asm.str(tempA.w(), ptr(ptrGram, tempB, lsl(2)));
+			}
+
+			m_asm.add(ptrFrame, ptrFrame, _block.gramInCount << 2);
+			m_asm.str(ptrFrame, ptr(ptrVars, offsetof(CoreData, blockIn)));
+		}
+
+		// sync cores: iramPos = (iramPos - 1) & 0xff for both cores, eramPos = (eramPos - 1) & eramMask
+		m_asm.sub(iramPos, iramPos, 1);
+		m_asm.and_(iramPos, iramPos, 0xff);
+		m_asm.ldr(tempA, ptr(ptrVars, offsetof(CoreData, iramPosPtr)));
+		m_asm.str(iramPos.w(), ptr(tempA));
+
+		m_asm.ldr(tempA, ptr(ptrVars, offsetof(CoreData, otherCore)));
+		m_asm.ldr(tempA, ptr(tempA, offsetof(CoreData, iramPosPtr)));
+		m_asm.ldr(tempB.w(), ptr(tempA));
+		m_asm.sub(tempB, tempB, 1);
+		m_asm.and_(tempB, tempB, 0xff);
+		m_asm.str(tempB.w(), ptr(tempA));
+
+		if (_block.eramMask)
+		{
+			m_asm.sub(eramPos, eramPos, 1);
+			m_asm.and_(eramPos, eramPos, _block.eramMask);
+			m_asm.ldr(tempA, ptr(ptrVars, offsetof(CoreData, eramPosPtr)));
+			m_asm.str(eramPos.w(), ptr(tempA));
+		}
+
+		m_asm.ldr(tempA, ptr(ptrVars, offsetof(CoreData, blockRemaining)));
+		m_asm.subs(tempA, tempA, 1);
+		m_asm.str(tempA, ptr(ptrVars, offsetof(CoreData, blockRemaining)));
+		m_asm.b_ne(m_blockLoop);
+	}
+
+	void EspJitArm64::coreBegin()
+	{
+		// the function arguments only cover the first core, load pointers and positions of the current one
+		m_asm.ldr(ptrIram, ptr(ptrVars, offsetof(CoreData, iramPtr)));
+		m_asm.ldr(ptrGram, ptr(ptrVars, offsetof(CoreData, gramPtr)));
+		m_asm.ldr(tempA, ptr(ptrVars, offsetof(CoreData, iramPosPtr)));
+		m_asm.ldr(iramPos.w(), ptr(tempA));
+		m_asm.ldr(tempA, ptr(ptrVars, offsetof(CoreData, eramPosPtr)));
+		m_asm.ldr(eramPos.w(), ptr(tempA));
+
+		// accumulators are kept in CoreData while the other core runs
+		for (uint32_t i=0; i<acc.size(); i+=2)
+			m_asm.ldp(acc[i], acc[i+1], ptr(ptrVars, offsetof(CoreData, accs) + i * sizeof(int64_t)));
+	}
+
+	void EspJitArm64::coreEnd()
+	{
+		for (uint32_t i=0; i<acc.size(); i+=2)
+			m_asm.stp(acc[i], acc[i+1], ptr(ptrVars, offsetof(CoreData, accs) + i * sizeof(int64_t)));
+
+		m_asm.ldr(ptrVars, ptr(ptrVars, offsetof(CoreData, otherCore)));
+	}
+
 	void EspJitArm64::eramRead(uint32_t eramMask)
 	{
 		// eramReadLatch = se<24>(eram[eramEffectiveAddr & ERAM_MASK]);
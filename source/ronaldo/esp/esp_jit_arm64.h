@@ -16,6 +16,11 @@ namespace esp
 		void jitEnter() override;
 		void jitExit() override;
 
+		void blockBegin() override;
+		void blockEnd(const JitBlockData& _block) override;
+		void coreBegin() override;
+		void coreEnd() override;
+
 		void eramRead(uint32_t eramMask) override;
 		void eramWrite(uint32_t eramMask) override;
 		void eramComputeAddr(uint32_t immOffset, bool highOffset, bool shouldUseVarOffset) override;
@@ -24,5 +29,6 @@ namespace esp
 
 	private:
 		Asm& m_asm;
+		asmjit::Label m_blockLoop;
 	};
 }
@@ -0,0 +1,132 @@
+#include "esp_jit_cache.h"
+
+#include <sstream>
+#include <stdexcept>
+
+namespace esp
+{
+	JitProgram::~JitProgram()
+	{
+		m_cache.release(m_func);
+	}
+
+	JitCache::~JitCache()
+	{
+		// programs that are still referenced outlive the runtime, nothing we can do about that
+		m_entries.clear();
+		m_lru.clear();
+	}
+
+	JitCache& JitCache::instance()
+	{
+		static JitCache s_instance;
+		return s_instance;
+	}
+
+	JitProgramPtr JitCache::find(const Key& _key)
+	{
+		std::lock_guard lock(m_mutex);
+
+		const auto it = m_entries.find(_key);
+
+		if (it == m_entries.end())
+		{
+			++m_misses;
+			return {};
+		}
+
+		++m_hits;
+
+		m_lru.splice(m_lru.begin(), m_lru, it->second);
+
+		return it->second->second;
+	}
+
+	JitProgramPtr JitCache::add(const Key& _key, asmjit::CodeHolder& _code)
+	{
+		void* func = nullptr;
+
+		// dropped programs call release() when destroyed, which needs the lock
+		std::vector<JitProgramPtr> dropped;
+
+		std::lock_guard lock(m_mutex);
+
+		const auto err = m_rt.add(&func, &_code);
+
+		if (err)
+		{
+			const auto* const errString = asmjit::DebugUtils::errorAsString(err);
+			std::stringstream ss;
+			ss << "JIT failed: " << err << " - " << errString;
+			throw std::runtime_error(ss.str());
+		}
+
+		auto program = std::make_shared<const JitProgram>(*this, func);
+
+		const auto it = m_entries.find(_key);
+
+		if (it != m_entries.end())
+		{
+			// generated by someone else in the meantime, replace it
+			dropped.push_back(std::move(it->second->second));
+			it->second->second = program;
+			m_lru.splice(m_lru.begin(), m_lru, it->second);
+			return program;
+		}
+
+		m_lru.emplace_front(_key, program);
+		m_entries.insert({_key, m_lru.begin()});
+
+		evict(dropped);
+
+		return program;
+	}
+
+	void JitCache::setCapacity(const size_t _capacity)
+	{
+		std::vector<JitProgramPtr> dropped;
+
+		std::lock_guard lock(m_mutex);
+		m_capacity = _capacity;
+		evict(dropped);
+	}
+
+	size_t JitCache::size() const
+	{
+		std::lock_guard lock(m_mutex);
+		return m_entries.size();
+	}
+
+	void JitCache::release(void* _func)
+	{
+		std::lock_guard lock(m_mutex);
+		m_rt.release(_func);
+	}
+
+	void JitCache::evict(std::vector<JitProgramPtr>& _dropped)
+	{
+		while (m_entries.size() > m_capacity)
+		{
+			auto& entry = m_lru.back();
+			m_entries.erase(entry.first);
+
+			// the program is released once it is not used by any ESP anymore
+			_dropped.push_back(std::move(entry.second));
+			m_lru.pop_back();
+		}
+	}
+
+	size_t JitCache::KeyHash::operator()(const Key& _key) const
+	{
+		// FNV-1a
+		uint64_t hash = 14695981039346656037ull;
+
+		for (const auto v : _key)
+		{
+			hash ^= v;
+			hash *= 1099511628211ull;
+		}
+
+		return static_cast<size_t>(hash);
+	}
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <asmjit/asmjit.h>
+
+namespace esp
+{
+	class JitCache;
+
+	// A generated function, released from the runtime when the last reference is gone
+	class JitProgram
+	{
+	public:
+		JitProgram(JitCache& _cache, void* _func) : m_cache(_cache), m_func(_func) {}
+		~JitProgram();
+
+		JitProgram(const JitProgram&) = delete;
+		JitProgram(JitProgram&&) = delete;
+		JitProgram& operator = (const JitProgram&) = delete;
+		JitProgram& operator = (JitProgram&&) = delete;
+
+		template<typename T> T get() const { return reinterpret_cast<T>(m_func); }
+
+	private:
+		JitCache& m_cache;
+		void* m_func;
+	};
+
+	using JitProgramPtr = std::shared_ptr<const JitProgram>;
+
+	// Process-wide LRU cache of generated ESP programs, keyed by everything that affects code generation
+	class JitCache
+	{
+	public:
+		using Key = std::vector<uint32_t>;
+
+		static constexpr size_t DefaultCapacity = 64;
+
+		JitCache() = default;
+		~JitCache();
+
+		JitCache(const JitCache&) = delete;
+		JitCache(JitCache&&) = delete;
+		JitCache& operator = (const JitCache&) = delete;
+		JitCache& operator = (JitCache&&) = delete;
+
+		static JitCache& instance();
+
+		const asmjit::Environment& getEnvironment() const { return m_rt.environment(); }
+
+		JitProgramPtr find(const Key& _key);
+
+		// adds the code to the runtime and stores the result in the cache, throws if the code cannot be added
+		JitProgramPtr add(const Key& _key, asmjit::CodeHolder& _code);
+
+		void setCapacity(size_t _capacity);
+		size_t size() const;
+
+		uint64_t getHits() const { return m_hits; }
+		uint64_t getMisses() const { return m_misses; }
+
+		void release(void* _func);
+
+	private:
+		struct KeyHash
+		{
+			size_t operator()(const Key& _key) const;
+		};
+
+		using LruList = std::list<std::pair<Key, JitProgramPtr>>;
+
+		void evict(std::vector<JitProgramPtr>& _dropped);
+
+		mutable std::mutex m_mutex;
+		asmjit::JitRuntime m_rt;
+		LruList m_lru;	// most recently used first
+		std::unordered_map<Key, LruList::iterator, KeyHash> m_entries;
+		size_t m_capacity = DefaultCapacity;
+		std::atomic<uint64_t> m_hits{0};
+		std::atomic<uint64_t> m_misses{0};
+	};
+}
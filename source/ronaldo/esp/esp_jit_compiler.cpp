@@ -0,0 +1,97 @@
+#include "esp_jit_compiler.h"
+
+namespace esp
+{
+	JitCompiler::JitCompiler() = default;
+
+	JitCompiler::~JitCompiler()
+	{
+		// all users should be gone by now, see removeUser
+		if (m_thread.joinable())
+			m_thread.detach();
+	}
+
+	JitCompiler& JitCompiler::instance()
+	{
+		static JitCompiler s_instance;
+		return s_instance;
+	}
+
+	void JitCompiler::addUser()
+	{
+		std::lock_guard lock(m_mutex);
+
+		if (m_userCount++)
+			return;
+
+		m_thread = std::thread([this, generation = m_generation] { threadFunc(generation); });
+	}
+
+	void JitCompiler::removeUser()
+	{
+		std::thread thread;
+
+		{
+			std::lock_guard lock(m_mutex);
+
+			if (--m_userCount)
+				return;
+
+			++m_generation;
+			m_jobs.clear();
+			thread = std::move(m_thread);
+		}
+
+		m_cv.notify_all();
+		thread.join();
+	}
+
+	void JitCompiler::add(const void* _owner, Job&& _job)
+	{
+		{
+			std::lock_guard lock(m_mutex);
+			m_jobs.push_back({_owner, std::move(_job)});
+		}
+		m_cv.notify_all();
+	}
+
+	void JitCompiler::cancel(const void* _owner)
+	{
+		std::unique_lock lock(m_mutex);
+
+		for (auto it = m_jobs.begin(); it != m_jobs.end();)
+		{
+			if (it->owner == _owner)
+				it = m_jobs.erase(it);
+			else
+				++it;
+		}
+
+		m_cv.wait(lock, [&] { return m_runningOwner != _owner; });
+	}
+
+	void JitCompiler::threadFunc(const uint32_t _generation)
+	{
+		std::unique_lock lock(m_mutex);
+
+		while (true)
+		{
+			m_cv.wait(lock, [&] { return m_generation != _generation || !m_jobs.empty(); });
+
+			if (m_generation != _generation)
+				return;
+
+			auto entry = std::move(m_jobs.front());
+			m_jobs.pop_front();
+
+			m_runningOwner = entry.owner;
+
+			lock.unlock();
+			entry.job();
+			lock.lock();
+
+			m_runningOwner = nullptr;
+			m_cv.notify_all();
+		}
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace esp
+{
+	// Runs JIT compilation jobs on a background thread that is shared by all ESPs of the process. The thread runs while
+	// there are users, it is stopped by the last one. It is never joined from the static destructor, that may run while
+	// a plugin module is unloaded, where joining a thread deadlocks on some platforms
+	class JitCompiler
+	{
+	public:
+		using Job = std::function<void()>;	// must not throw, it runs on the compiler thread
+
+		JitCompiler();
+		~JitCompiler();
+
+		JitCompiler(const JitCompiler&) = delete;
+		JitCompiler(JitCompiler&&) = delete;
+		JitCompiler& operator = (const JitCompiler&) = delete;
+		JitCompiler& operator = (JitCompiler&&) = delete;
+
+		static JitCompiler& instance();
+
+		void addUser();
+		void removeUser();
+
+		void add(const void* _owner, Job&& _job);
+
+		// removes all queued jobs of the owner and waits for a running one to complete
+		void cancel(const void* _owner);
+
+	private:
+		struct Entry
+		{
+			const void* owner;
+			Job job;
+		};
+
+		void threadFunc(uint32_t _generation);
+
+		std::mutex m_mutex;
+		uint32_t m_userCount = 0;
+		std::condition_variable m_cv;
+		std::deque<Entry> m_jobs;
+		const void* m_runningOwner = nullptr;
+		uint32_t m_generation = 0;	// a thread exits once this does not match the value it has been started with
+		std::thread m_thread;
+	};
+}
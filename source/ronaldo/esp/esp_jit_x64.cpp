@@ -40,6 +40,95 @@ namespace esp
 		m_asm.ret();
 	}
 
+	void EspJitX64::blockBegin()
+	{
+		m_blockLoop = m_asm.newLabel();
+		m_asm.bind(m_blockLoop);
+	}
+
+	void EspJitX64::blockEnd(const JitBlockData& _block)
+	{
+		m_pool.flush();
+
+		// nothing is cached anymore, pool registers can be used directly
+		const auto& pos = rcx;
+		const auto& index = rax;
+		const auto& value = rdx;
+		const auto& frame = rsi;
+
+		m_asm.mov(pos.r32(), ptr(g_regBasePtr, m_pool.getPointerOffset(m_data.iramPos), 4));
+
+		if (_block.gramOutCount)
+		{
+			const auto offFrame = m_pool.getPointerOffset(&m_data.coreData->blockOut);
+
+			m_asm.mov(frame, ptr(g_regBasePtr, offFrame, 8));
+
+			for (uint32_t i=0; i<_block.gramOutCount; ++i)
+			{
+				// frame[i] = gram[(gramOut[i] + iramPos) & 0xff]
+				m_asm.lea(index, ptr(pos, _block.gramOut[i]));
+				m_asm.and_(index, 0xff);
+				m_asm.mov(value.r32(), gramPtr(index));
+				m_asm.mov(ptr(frame, static_cast<int32_t>(i << 2), 4), value.r32());
+			}
+
+			m_asm.add(ptr(g_regBasePtr, offFrame, 8), _block.gramOutCount << 2);
+		}
+
+		if (_block.gramInCount)
+		{
+			const auto offFrame = m_pool.getPointerOffset(&m_data.coreData->blockIn);
+
+			m_asm.mov(frame, ptr(g_regBasePtr, offFrame, 8));
+
+			for (uint32_t i=0; i<_block.gramInCount; ++i)
+			{
+				// gram[(gramIn[i] + iramPos) & 0xff] = frame[i]
+				m_asm.mov(value.r32(), ptr(frame, static_cast<int32_t>(i << 2), 4));
+				m_asm.lea(index, ptr(pos, _block.gramIn[i]));
+				m_asm.and_(index, 0xff);
+				m_asm.mov(gramPtr(index), value.r32());
+			}
+
+			m_asm.add(ptr(g_regBasePtr, offFrame, 8), _block.gramInCount << 2);
+		}
+
+		// sync cores: iramPos = (iramPos - 1) & 0xff for both cores, eramPos = (eramPos - 1) & eramMask
+		m_asm.dec(pos.r32());
+		m_asm.and_(pos.r32(), 0xff);
+		m_asm.mov(ptr(g_regBasePtr, m_pool.getPointerOffset(m_data.iramPos), 4), pos.r32());
+
+		m_asm.mov(pos.r32(), ptr(g_regBasePtr, m_pool.getPointerOffset(_block.iramPos1), 4));
+		m_asm.dec(pos.r32());
+		m_asm.and_(pos.r32(), 0xff);
+		m_asm.mov(ptr(g_regBasePtr, m_pool.getPointerOffset(_block.iramPos1), 4), pos.r32());
+
+		if (_block.eramMask)
+		{
+			m_asm.mov(pos.r32(), ptr(g_regBasePtr, m_pool.getPointerOffset(m_data.eramPos), 4));
+			m_asm.dec(pos.r32());
+			m_asm.and_(pos.r32(), _block.eramMask);
+			m_asm.mov(ptr(g_regBasePtr, m_pool.getPointerOffset(m_data.eramPos), 4), pos.r32());
+		}
+
+		m_asm.dec(ptr(g_regBasePtr, m_pool.getPointerOffset(&m_data.coreData->blockRemaining), 8));
+		m_asm.jnz(m_blockLoop);
+	}
+
+	void EspJitX64::coreBegin()
+	{
+		// registers are loaded on demand
+	}
+
+	void EspJitX64::coreEnd()
+	{
+		m_pool.flush();
+
+		// switch base pointer to the CoreData of the other core
+		m_asm.mov(g_regBasePtr, ptr(g_regBasePtr, m_pool.getPointerOffset(&m_data.coreData->otherCore), 8));
+	}
+
 	void EspJitX64::eramRead(uint32_t _eramMask)
 	{
 		auto eramEffectiveAddr = m_pool.get(m_data.eramEffectiveAddr, Access::ReadWrite);
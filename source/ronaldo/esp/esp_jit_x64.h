@@ -16,6 +16,11 @@ namespace esp
 		void jitEnter() override;
 		void jitExit() override;
 
+		void blockBegin() override;
+		void blockEnd(const JitBlockData& _block) override;
+		void coreBegin() override;
+		void coreEnd() override;
+
 		void eramRead(uint32_t _eramMask) override;
 		void eramWrite(uint32_t _eramMask) override;
 		void eramComputeAddr(uint32_t immOffset, bool highOffset, bool shouldUseVarOffset);
@@ -35,5 +40,6 @@ namespace esp
 		Asm& m_asm;
 		JitInputData m_data;
 		RegPoolX64 m_pool;
+		asmjit::Label m_blockLoop;
 	};
 }
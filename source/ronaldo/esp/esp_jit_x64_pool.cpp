@@ -216,6 +216,22 @@ namespace esp
 		assert(false && "temp not found in used list");
 	}
 
+	void RegPoolX64::flush()
+	{
+		// write back all cached values and return all registers, they can be used freely afterwards
+		while (!m_usedRegs.empty())
+		{
+			auto& reg = m_usedRegs.front().second;
+
+			assert(!reg->isLocked() && "cannot flush a locked register");
+
+			m_unusedRegs.push_back(*reg);
+			reg->~PooledReg();
+			m_pooledRegPool.push_back(std::move(reg));
+			m_usedRegs.pop_front();
+		}
+	}
+
 	void RegPoolX64::clear()
 	{
 		m_usedRegs.clear();
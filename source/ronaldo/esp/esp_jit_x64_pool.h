@@ -135,6 +135,7 @@ namespace esp
 
 		void releaseTemp(uint8_t index);
 
+		void flush();
 		void clear();
 		void checkUninit(const asmjit::x86::Gpq& reg) const;
 
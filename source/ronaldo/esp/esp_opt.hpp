@@ -1,6 +1,16 @@
 #include <asmjit/asmjit.h>
 #include <asmjit/a64.h>
-#include <sstream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "esp_jit_cache.h"
+#include "esp_jit_compiler.h"
 
 #include "esp_jit_x64.h"
 #include "esp_jit_arm64.h"
@@ -15,6 +25,26 @@ struct CoreData {
   int32_t mulcoeffs[8];
   int8_t coefs[PRAM_SIZE];
   int8_t shiftAmounts[PRAM_SIZE];
+
+  // block function state, see ESPOptimizer::runBlock
+  CoreData *otherCore;
+  int64_t blockRemaining;
+  const int32_t *blockIn;
+  int32_t *blockOut;
+  int32_t *iramPtr;
+  int32_t *gramPtr;
+  uint32_t *iramPosPtr;
+  uint32_t *eramPosPtr;
+};
+
+struct ESPJitStats
+{
+  uint32_t compileCount = 0;        // number of programs generated
+  uint32_t cacheHits = 0;           // number of programs taken from the JitCache instead
+  uint64_t compileMicros = 0;       // total time spent generating programs
+  uint64_t lastCompileMicros = 0;
+  uint32_t stallCount = 0;          // number of times the sample loop had to wait for a program
+  uint64_t stallMicros = 0;         // total time the sample loop was blocked by program generation
 };
 
 enum { kNone = 0, kSavesA = 1, kSavesB = 2 };
@@ -182,45 +212,113 @@ class ESPOptimizer
 public:
   ESPOptimizer(ESP<lg2eram_size>* esp) : m_esp(esp), logger(fopen("esp_jit.log", "w"))
   {
+    // make sure the singletons are constructed first, they need to outlive us
+    esp::JitCache::instance();
+    esp::JitCompiler::instance().addUser();
+
     data_core0.hostRegPtr = (int32_t*)esp->shared.readback_regs;
     data_core0.eramPtr = &esp->shared.eram.eram[0];
     data_core1.hostRegPtr = (int32_t*)esp->shared.readback_regs;
     data_core1.eramPtr = &esp->shared.eram.eram[0];
+
+    data_core0.otherCore = &data_core1;
+    data_core0.iramPtr = esp->core0.iram;
+    data_core0.gramPtr = esp->shared.gram;
+    data_core0.iramPosPtr = &esp->core0.iramPos;
+    data_core0.eramPosPtr = &esp->shared.eram.eramPos;
+    data_core1.otherCore = &data_core0;
+    data_core1.iramPtr = esp->core1.iram;
+    data_core1.gramPtr = esp->shared.gram;
+    data_core1.iramPosPtr = &esp->core1.iramPos;
+    data_core1.eramPosPtr = &esp->shared.eram.eramPos;
+  }
+
+  ESPOptimizer(const ESPOptimizer&) = delete;
+  ESPOptimizer& operator = (const ESPOptimizer&) = delete;
+
+  ~ESPOptimizer()
+  {
+    esp::JitCompiler::instance().cancel(this);
+    esp::JitCompiler::instance().removeUser();
   }
 
+  // Generates the program synchronously, the sample loop is blocked until it is done
   void genProgram(ESP<lg2eram_size>* esp)
   {
-    if (runCore0) m_rt.release(runCore0);
-    if (runCore1) m_rt.release(runCore1);
+    const auto t0 = std::chrono::steady_clock::now();
 
-    eramEmitter.init(esp);
-    coreEmitter0.init(esp, &esp->core0);
-    coreEmitter1.init(esp, &esp->core1);
+    // a background job must not use the emitters now and its result would be outdated
+    waitForCompile();
 
-    updateCoef(esp);
+    const auto generation = ++m_generation;
 
-    // logger.log("#### CORE 0 ####\n");
-    genCore(esp, 0, &coreEmitter0, &runCore0);
-    
-    // logger.log("\n\n\n#### CORE 1 ####\n");
-    genCore(esp, 1, &coreEmitter1, &runCore1, true);
+    std::copy_n(esp->core0.pram, PRAM_SIZE, m_compilePram[0]);
+    std::copy_n(esp->core1.pram, PRAM_SIZE, m_compilePram[1]);
+
+    installProgram(compileProgram(), generation);
+
+    addStall(t0);
 
     // fflush(logger._file);
     // printf("JITed ESP cores\n");
   }
+
+  // If enabled, programs are generated on a background thread while the previous program continues to run. The new
+  // program is swapped in at the next sample boundary once it is ready. The output then depends on thread timing, which
+  // is why it is off by default
+  void setBackgroundCompile(bool _enable)
+  {
+    if (!_enable)
+      waitForCompile();
+    m_backgroundCompile = _enable;
+  }
+
+  bool isBackgroundCompile() const { return m_backgroundCompile; }
+
+  ESPJitStats getJitStats() const
+  {
+    ESPJitStats stats;
+    stats.compileCount = m_compileCount;
+    stats.cacheHits = m_cacheHits;
+    stats.compileMicros = m_compileMicros;
+    stats.lastCompileMicros = m_lastCompileMicros;
+    stats.stallCount = m_stallCount;
+    stats.stallMicros = m_stallMicros;
+    return stats;
+  }
   
   void setProgramDirty()
   {
 	  m_programDirty = 3;
   }
 
+  bool isProgramDirty() const
+  {
+      return m_programDirty > 0;
+  }
+
   void genProgramIfDirty()
   {
       if (m_programDirty > 0)
       {
           if (--m_programDirty == 0)
-              genProgram(m_esp);
+          {
+              if (m_backgroundCompile)
+                  requestProgram();
+              else
+                  genProgram(m_esp);
+          }
 	  }
+
+      if (!runBlockFunc && m_compileQueued)
+      {
+          // there is no previous program that could run meanwhile
+          const auto t0 = std::chrono::steady_clock::now();
+          waitForCompile();
+          addStall(t0);
+      }
+
+      swapProgram();
   }
 
   void updateCoef(ESP<lg2eram_size>* esp)
@@ -248,39 +346,313 @@ public:
     }
   }
 
-  inline void callOptimized(ESP<lg2eram_size>* esp)
+  // GRAM locations that are exchanged with the neighbour ASICs at the end of each sample, see runBlock
+  void setBlockIO(const std::vector<uint8_t>& _gramIn, const std::vector<uint8_t>& _gramOut)
+  {
+    m_gramIn = _gramIn;
+    m_gramOut = _gramOut;
+
+    if (runBlockFunc)
+      genProgram(m_esp);
+  }
+
+  // The jitted code keeps accumulators and multiplier coefficients in CoreData. The program itself is not serialized,
+  // it is generated again from the PRAM on load. A pending regeneration is done right away
+  template<typename TStream> void saveState(TStream& _s) const
+  {
+    _s.write(data_core0.accs); _s.write(data_core0.mulcoeffs);
+    _s.write(data_core1.accs); _s.write(data_core1.mulcoeffs);
+    _s.write(static_cast<uint8_t>(runBlockFunc != nullptr || m_programDirty > 0 || m_compileQueued ? 1 : 0));
+  }
+
+  template<typename TStream> void loadState(TStream& _s)
+  {
+    _s.read(data_core0.accs); _s.read(data_core0.mulcoeffs);
+    _s.read(data_core1.accs); _s.read(data_core1.mulcoeffs);
+
+    uint8_t hasProgram = 0;
+    _s.read(hasProgram);
+
+    m_programDirty = 0;
+
+    if (hasProgram)
+    {
+      genProgram(m_esp);
+    }
+    else
+    {
+      waitForCompile();
+      ++m_generation;
+      runBlockFunc = nullptr;
+      m_program.reset();
+      m_installedGeneration = m_generation;
+    }
+
+    updateCoef(m_esp);
+  }
+
+  // Runs both cores for _count samples. At the end of each sample, the GRAM output locations are stored to _out and
+  // the GRAM input locations are loaded from _in, one interleaved frame per sample, then the cores are synced
+  inline void runBlock(ESP<lg2eram_size>* esp, uint32_t _count, const int32_t* _in, int32_t* _out)
   {
-    if (runCore0) runCore0(data_core0.coefs, esp->core0.iram, esp->shared.gram, &data_core0, esp->shared.eram.eramPos, esp->core0.iramPos, 0, 0);
-    if (runCore1) runCore1(data_core1.coefs, esp->core1.iram, esp->shared.gram, &data_core1, esp->shared.eram.eramPos, esp->core1.iramPos, 0, 0);
+    if (!_count)
+      return;
+
+    if (runBlockFunc)
+    {
+      data_core0.blockRemaining = _count;
+      data_core0.blockIn = _in;
+      data_core0.blockOut = _out;
+      runBlockFunc(data_core0.coefs, esp->core0.iram, esp->shared.gram, &data_core0, esp->shared.eram.eramPos, esp->core0.iramPos, 0, 0);
+      return;
+    }
+
+    // no program yet, only move data
+    for (uint32_t i = 0; i < _count; i++)
+    {
+      for (const auto o : m_gramOut) *_out++ = esp->readGRAM(o);
+      for (const auto o : m_gramIn) esp->writeGRAM(*_in++, o);
+      esp->sync_cores();
+    }
   }
   
 private:
   class CoreEmitter;
 
   ESP<lg2eram_size>* m_esp;
-  asmjit::JitRuntime m_rt;
   asmjit::FileLogger logger;
   uint32_t m_programDirty = 0;
   
   typedef void(*RunCore)(int8_t* coefsPtr, int32_t *iramPtr, int32_t *gramPtr, CoreData *varPtr, uint32_t eramPos, uint32_t iramPos, int64_t unused1, int64_t unused2);
-  RunCore runCore0 = nullptr, runCore1 = nullptr;
+  RunCore runBlockFunc = nullptr;
+  esp::JitProgramPtr m_program;                 // owns runBlockFunc
+
+  // Every program request gets a new generation. A program is only installed if it is newer than the current one
+  uint32_t m_generation = 0;
+  uint32_t m_installedGeneration = 0;
+
+  // background compilation
+  bool m_backgroundCompile = false;
+  std::mutex m_compileMutex;
+  std::condition_variable m_compileCv;
+  std::atomic<bool> m_compileQueued{false};     // a job is queued or running
+  bool m_compileRequested = false;              // m_requestPram has not been picked up yet
+  uint32_t m_requestGeneration = 0;
+  uint32_t m_requestPram[2][PRAM_SIZE] {};
+  uint32_t m_compilePram[2][PRAM_SIZE] {};      // PRAM the emitters work on, owned by the compiling thread
+  std::atomic<bool> m_hasCompiledProgram{false};
+  esp::JitProgramPtr m_compiledProgram;         // finished program that waits to be swapped in
+  uint32_t m_compiledGeneration = 0;
+  std::exception_ptr m_compileError;            // rethrown on the emulation thread
+
+  std::atomic<uint32_t> m_compileCount{0};
+  std::atomic<uint32_t> m_cacheHits{0};
+  std::atomic<uint64_t> m_compileMicros{0};
+  std::atomic<uint64_t> m_lastCompileMicros{0};
+  std::atomic<uint32_t> m_stallCount{0};
+  std::atomic<uint64_t> m_stallMicros{0};
+
+  std::vector<uint8_t> m_gramIn, m_gramOut;
 
   // State used by jitted code
   CoreData data_core0{0};
   CoreData data_core1{0};
 
-  void genCore(ESP<lg2eram_size>* esp, uint32_t core, CoreEmitter* emitter, RunCore *dest, bool withEram = false)
+  static uint64_t microsSince(const std::chrono::steady_clock::time_point& _t0)
+  {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - _t0).count());
+  }
+
+  void addStall(const std::chrono::steady_clock::time_point& _t0)
+  {
+    ++m_stallCount;
+    m_stallMicros += microsSince(_t0);
+  }
+
+  // Instructions as they affect code generation. Coefficients are read from CoreData at runtime, except for op 0x30
+  // where they select the operation. A zero coefficient can turn an instruction into a nop
+  static uint32_t codeGenInstr(const uint32_t _instr)
   {
-    // TODO: do we need a new CodeHolder each time?
+    const uint32_t op = (_instr >> 16) & 0x7c;
+    if (op == 0x30)
+      return _instr;
+    return (_instr & ~0xffu) | ((_instr & 0xff) ? 1 : 0);
+  }
+
+  esp::JitCache::Key makeCacheKey(const uint32_t* _pram0, const uint32_t* _pram1) const
+  {
+    esp::JitCache::Key key;
+    key.reserve(3 + m_gramIn.size() + m_gramOut.size() + 2 * PRAM_SIZE);
+
+    // the code addresses ESP members relative to CoreData, the layout depends on the ERAM size
+    key.push_back(lg2eram_size);
+
+    key.push_back(static_cast<uint32_t>(m_gramIn.size()));
+    key.insert(key.end(), m_gramIn.begin(), m_gramIn.end());
+    key.push_back(static_cast<uint32_t>(m_gramOut.size()));
+    key.insert(key.end(), m_gramOut.begin(), m_gramOut.end());
+
+    for (size_t i = 0; i < PRAM_SIZE; i++) key.push_back(codeGenInstr(_pram0[i]));
+    for (size_t i = 0; i < PRAM_SIZE; i++) key.push_back(codeGenInstr(_pram1[i]));
+
+    return key;
+  }
+
+  // returns a program for m_compilePram, either from the cache or newly generated
+  esp::JitProgramPtr compileProgram()
+  {
+    const auto t0 = std::chrono::steady_clock::now();
+
+    auto& cache = esp::JitCache::instance();
+
+    const auto key = makeCacheKey(m_compilePram[0], m_compilePram[1]);
+
+    if (auto program = cache.find(key))
+    {
+      ++m_cacheHits;
+      return program;
+    }
+
+    eramEmitter.init(m_compilePram[1]);
+    coreEmitter0.init(m_compilePram[0]);
+    coreEmitter1.init(m_compilePram[1]);
+
     asmjit::CodeHolder code;
-    code.init(m_rt.environment());
+    code.init(cache.getEnvironment());
 
-  	logger.addFlags(asmjit::FormatFlags::kHexImms | /*asmjit::FormatFlags::kHexOffsets |*/ asmjit::FormatFlags::kMachineCode);
+    genBlock(m_esp, code);
 
-//	code.setLogger(&logger);
-    
-    esp::Builder m_asm(&code);
+    auto program = cache.add(key, code);
+
+    const auto micros = microsSince(t0);
+    ++m_compileCount;
+    m_compileMicros += micros;
+    m_lastCompileMicros = micros;
+
+    return program;
+  }
+
+  void requestProgram()
+  {
+    const auto generation = ++m_generation;
+
+    // programs that have been seen before are installed right away
+    if (auto program = esp::JitCache::instance().find(makeCacheKey(m_esp->core0.pram, m_esp->core1.pram)))
+    {
+      ++m_cacheHits;
+      {
+        // an earlier request that has not been picked up yet is outdated
+        std::lock_guard lock(m_compileMutex);
+        m_compileRequested = false;
+      }
+      installProgram(std::move(program), generation);
+      return;
+    }
+
+    {
+      std::lock_guard lock(m_compileMutex);
+
+      std::copy_n(m_esp->core0.pram, PRAM_SIZE, m_requestPram[0]);
+      std::copy_n(m_esp->core1.pram, PRAM_SIZE, m_requestPram[1]);
+      m_requestGeneration = generation;
+      m_compileRequested = true;
+
+      // a queued or running job picks up the latest request
+      if (m_compileQueued)
+        return;
+
+      m_compileQueued = true;
+    }
+
+    esp::JitCompiler::instance().add(this, [this] { compileJob(); });
+  }
+
+  void compileJob()
+  {
+    while (true)
+    {
+      uint32_t generation;
+
+      {
+        std::lock_guard lock(m_compileMutex);
+
+        if (!m_compileRequested)
+        {
+          m_compileQueued = false;
+          m_compileCv.notify_all();
+          return;
+        }
+
+        m_compileRequested = false;
+        generation = m_requestGeneration;
+        std::copy_n(&m_requestPram[0][0], 2 * PRAM_SIZE, &m_compilePram[0][0]);
+      }
+
+      esp::JitProgramPtr program;
+      std::exception_ptr error;
+
+      try
+      {
+        program = compileProgram();
+      }
+      catch (...)
+      {
+        error = std::current_exception();
+      }
+
+      std::lock_guard lock(m_compileMutex);
+
+      // a program that has not been swapped in yet is outdated now
+      m_compiledProgram = std::move(program);
+      m_compiledGeneration = generation;
+      m_compileError = std::move(error);
+      m_hasCompiledProgram = true;
+    }
+  }
+
+  void waitForCompile()
+  {
+    std::unique_lock lock(m_compileMutex);
+    m_compileCv.wait(lock, [this] { return !m_compileQueued; });
+  }
+
+  void swapProgram()
+  {
+    if (!m_hasCompiledProgram)
+      return;
+
+    esp::JitProgramPtr program;
+    uint32_t generation;
+
+    {
+      std::lock_guard lock(m_compileMutex);
+      program = std::move(m_compiledProgram);
+      generation = m_compiledGeneration;
+      m_hasCompiledProgram = false;
+
+      // the compiler thread cannot report errors, do it here as a synchronous compile would
+      if (m_compileError)
+        std::rethrow_exception(std::exchange(m_compileError, nullptr));
+    }
 
+    installProgram(std::move(program), generation);
+  }
+
+  void installProgram(esp::JitProgramPtr _program, const uint32_t _generation)
+  {
+    if (!_program || _generation <= m_installedGeneration)
+      return;
+
+    m_program = std::move(_program);
+    m_installedGeneration = _generation;
+    runBlockFunc = m_program->get<RunCore>();
+
+    // coefficients may have been updated while the program was generated
+    updateCoef(m_esp);
+  }
+
+  esp::JitInputData makeJitInputData(ESP<lg2eram_size>* esp, uint32_t core)
+  {
 	CoreData& coreData = core ? data_core1 : data_core0;
 	ESPCore<lg2eram_size>& espCore = core ? esp->core1 : esp->core0;
 
@@ -301,44 +673,67 @@ private:
 	jitData.last_mulInputA_24 = &espCore.last_mulInputA_24;
 	jitData.last_mulInputB_24 = &espCore.last_mulInputB_24;
 
-	esp::EspJit jit(m_asm, jitData);
+	return jitData;
+  }
+
+  // Generates a function that runs core 0, then ERAM + core 1, then exchanges GRAM data with the block frames and
+  // advances the iram and eram positions, in a loop for CoreData::blockRemaining samples
+  void genBlock(ESP<lg2eram_size>* esp, asmjit::CodeHolder& code)
+  {
+  	logger.addFlags(asmjit::FormatFlags::kHexImms | /*asmjit::FormatFlags::kHexOffsets |*/ asmjit::FormatFlags::kMachineCode);
+
+//	code.setLogger(&logger);
+    
+    esp::Builder m_asm(&code);
+
+	esp::EspJit jit0(m_asm, makeJitInputData(esp, 0));
+	esp::EspJit jit1(m_asm, makeJitInputData(esp, 1));
+
+	esp::JitBlockData blockData;
+	blockData.iramPos1 = &esp->core1.iramPos;
+	blockData.gramOut = m_gramOut.data();
+	blockData.gramOutCount = static_cast<uint32_t>(m_gramOut.size());
+	blockData.gramIn = m_gramIn.data();
+	blockData.gramInCount = static_cast<uint32_t>(m_gramIn.size());
+	blockData.eramMask = lg2eram_size ? static_cast<uint32_t>(ERAM<lg2eram_size>::ERAM_MASK_FULL) : 0;
 
     // m_asm.addDiagnosticOptions(asmjit::DiagnosticOptions::kValidateAssembler);
     // m_asm.addDiagnosticOptions(asmjit::DiagnosticOptions::kValidateIntermediate);
 
-	jit.jitEnter();
+	jit0.jitEnter();
+	jit0.blockBegin();
 
+    // logger.log("#### CORE 0 ####\n");
+	jit0.coreBegin();
+    for (size_t pc = 0; pc < PRAM_SIZE; pc++)
+      coreEmitter0.emit(pc, jit0, m_asm);
+    coreEmitter0.emitEnd(m_asm);
+	jit0.coreEnd();
+
+    // logger.log("\n\n\n#### CORE 1 ####\n");
+	jit1.coreBegin();
     for (size_t pc = 0; pc < PRAM_SIZE; pc++)
     {
-      if (withEram)
-        eramEmitter.emit(pc, jit, m_asm);
-      emitter->emit(pc, jit, m_asm);
+      eramEmitter.emit(pc, jit1, m_asm);
+      coreEmitter1.emit(pc, jit1, m_asm);
     }
+    coreEmitter1.emitEnd(m_asm);
+	jit1.coreEnd();
 
     // logger.log("---- ending ----\n");
-    emitter->emitEnd(m_asm);
-
-	jit.jitExit();
+	jit0.coreBegin();
+	jit0.blockEnd(blockData);
+	jit0.jitExit();
 
     m_asm.finalize();
-    
-    const auto err = m_rt.add(dest, &code);
-    if (err)
-    {
-      const auto* const errString = asmjit::DebugUtils::errorAsString(err);
-      std::stringstream ss;
-      ss << "JIT failed: " << err << " - " << errString;
-      const std::string msg(ss.str());
-      throw std::runtime_error(msg);
-    }
   }
 
   class ERAMEmitter
   {
   public:
-    void init(ESP<lg2eram_size>* _esp)
+    void init(const uint32_t* _decode)
     {
-      esp = _esp;
+      decode = _decode;
 
       eramPCCommit = 0, eramPCStartNext = 0;
       eramModeCurrent = 0, eramModeNext = 0;
@@ -351,7 +746,6 @@ private:
     {
       if (lg2eram_size == 0) return;
 
-      uint32_t *decode = (uint32_t*)(&esp->intmem[0x1000]);
       uint32_t eramCtrl = (decode[pc] >> 23) & 0x1f;
       int stage1 = pc - eramPCStartNext;
 
@@ -423,7 +817,7 @@ private:
     bool eramActiveCurrent = false, eramActiveNext = false;
     bool highOffset = false;
 
-    ESP<lg2eram_size>* esp;
+    const uint32_t* decode = nullptr;
     static constexpr int64_t ERAM_COMMIT_STAGE = 10, ERAM_MASK_FULL = (1 << 19) - 1;
 		enum {eram_size = 1 << lg2eram_size, ERAM_MASK = eram_size - 1};
   };
@@ -432,12 +826,21 @@ private:
   class CoreEmitter
   {
   public:
-    void init(ESP<lg2eram_size>* _esp, ESPCore<lg2eram_size>* _core)
+    void init(const uint32_t* _pram)
     {
-      esp = _esp;
-      core = _core;
+      pram = _pram;
 
       pre_optimize();
+
+      // the first instruction follows the last one of the previous sample. Do not carry over state from the previous
+      // program, the generated code has to depend on the PRAM only to be cacheable
+      lastMul30 = false;
+      for (int pc = PRAM_SIZE - 1; pc >= 0; pc--)
+      {
+        if (pram_opt[pc].opType == kNop) continue;
+        lastMul30 = (pram_opt[pc].op == 0x30);
+        break;
+      }
     }
 
     void emit(int pc, esp::EspJit& _jit, esp::Builder& m_asm)
@@ -470,7 +873,7 @@ private:
 		void pre_optimize()
 		{
 			for (int i = 0; i < PRAM_SIZE; i++)
-				pram_opt[i] = ESPOptInstr(core->pram[i]);
+				pram_opt[i] = ESPOptInstr(pram[i]);
 
 			// Decided limitations: We will not support op 0x34, mem & 0xcc == 0xc0 (these are the jump operations)
 			for (int pc = 0; pc < PRAM_SIZE; pc++) assert((pram_opt[pc].op != 0xd || (pram_opt[pc].mem & 0xcc) != 0xc0) && "Jumps!"); // jumps. bail.
@@ -591,8 +994,7 @@ private:
 			}
 		}
 
-    ESP<lg2eram_size>* esp;
-    ESPCore<lg2eram_size>* core;
+    const uint32_t* pram = nullptr;
 
     ESPOptInstr pram_opt[PRAM_SIZE] {};
   };
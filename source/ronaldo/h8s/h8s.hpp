@@ -1,10 +1,13 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <memory>
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
+#include <vector>
 
 typedef unsigned char uint8;
 typedef signed char int8;
@@ -40,18 +43,72 @@ protected:
 	class h8state *state {nullptr};
 };
 
+// A device whose state changes at predictable cycles. Instead of being ticked after every instruction, it provides the
+// cycle of its next event and is synchronized once the cpu reaches it. Register accesses synchronize it, too. Devices
+// always catch up to the last instruction boundary (getSyncCycles()), never to the middle of the instruction that
+// accesses them, which makes them behave exactly as if they were ticked after every instruction
+class H8SScheduledDevice : public H8SDevice
+{
+public:
+	static constexpr unsigned long long kNoEvent = ~0ull;
+
+	virtual void sync() = 0;	// catch up to the last instruction boundary and update the deadline
+	unsigned long long getDeadline() const {return deadline;}
+protected:
+	void setDeadline(unsigned long long _cycles);
+private:
+	unsigned long long deadline {kNoEvent};
+};
+
 static volatile bool g_dasm = true;
 
 class h8state {
 public:
+	static constexpr uint32_t kPageBits = 8;
+	static constexpr uint32_t kPageSize = 1u << kPageBits;
+	static constexpr uint32_t kPageMask = kPageSize - 1;
+	static constexpr uint32_t kPageCount = (1u << 24) >> kPageBits;
+
+	// An instruction whose leading opcode byte(s) have been resolved to the handler that executes it. Entries are
+	// keyed by the address of the first byte, operands are still fetched by the handler. An entry only depends on
+	// the first two bytes of an instruction and is dropped if one of them is written
+	struct DecodedInstr
+	{
+		using Exec = uint8* (*)(h8state&, const DecodedInstr&, uint8*);
+		Exec exec {nullptr};
+		uint8 op {0};
+		uint8 b {0};
+		bool prefix {false};	// the second byte has been consumed by the decoder, too
+	};
+
+	// A page either points to host memory, is handled by a single device as a whole or, if devices
+	// are mapped to parts of it only, uses a per-byte device table. Unmapped bytes go to memory
+	struct MemPage
+	{
+		uint8* mem {nullptr};
+		H8SDevice* device {nullptr};
+		std::unique_ptr<H8SDevice*[]> devices;
+		std::unique_ptr<DecodedInstr[]> decoded;	// pre-decoded instructions, memory pages only
+	};
+
+	static constexpr uint32_t kDecodedPerPage = kPageSize >> 1;
+
+	h8state()
+	{
+		for (uint32_t i=0; i<kPageCount; i++) pages[i].mem = memory + (i << kPageBits);
+	}
+
 	uint8 memory[1<<24] {};
 	h8reg regs[8] {};
 	uint8 *pc {0};		// program counter. pc is ALWAYS a multiple of 2. All instructions are 2bytes
 	uint8 ccr {128};
 	uint8 exr {0};
-	H8SDevice* maps[1<<24] {};
+	MemPage pages[kPageCount];
 	unsigned long long  cycles {0};
+	unsigned long long syncCycles {0};	// cycle count at the end of the last completed instruction
 	unsigned long long pending_irqs {0};
+	unsigned long long nextEvent {H8SScheduledDevice::kNoEvent};	// earliest deadline of all scheduled devices
+	std::vector<H8SScheduledDevice*> scheduled;
 	
 	enum
 	{
@@ -82,8 +139,49 @@ public:
 	void boot()
 	{
 		pc = makepc(read32(0) & 0xffffff);
-		cycles = pending_irqs = 0;
+		cycles = syncCycles = pending_irqs = 0;
 		ccr = 128; exr = 0;
+		syncAll();
+	}
+
+	// Registers and cycle counter. Memory and devices are serialized by the owner of the memory map, call updateNextEvent()
+	// once the scheduled devices have been restored, too
+	template<typename TStream> void saveCpuState(TStream& _s) const
+	{
+		_s.write(regs); _s.write(static_cast<uint32>(pcoff(pc))); _s.write(ccr); _s.write(exr);
+		_s.write(cycles); _s.write(pending_irqs); _s.write(lastread); _s.write(lastwrite);
+	}
+	template<typename TStream> void loadCpuState(TStream& _s)
+	{
+		uint32 p = 0;
+		_s.read(regs); _s.read(p); _s.read(ccr); _s.read(exr);
+		_s.read(cycles); _s.read(pending_irqs); _s.read(lastread); _s.read(lastwrite);
+		syncCycles = cycles;
+		pc = makepc(p & 0xffffff);
+	}
+
+	void addScheduledDevice(H8SScheduledDevice *dev)
+	{
+		dev->setState(this);
+		scheduled.push_back(dev);
+		dev->sync();
+		updateNextEvent();
+	}
+	void scheduleEvent(unsigned long long at) {if (at < nextEvent) nextEvent = at;}
+	void runEvents()	// to be called once cycles >= nextEvent
+	{
+		for (auto* d : scheduled) if (d->getDeadline() <= cycles) d->sync();
+		updateNextEvent();
+	}
+	void syncAll()	// synchronize all scheduled devices, regardless of their deadlines
+	{
+		for (auto* d : scheduled) d->sync();
+		updateNextEvent();
+	}
+	void updateNextEvent()
+	{
+		nextEvent = H8SScheduledDevice::kNoEvent;
+		for (const auto* d : scheduled) nextEvent = std::min(nextEvent, d->getDeadline());
 	}
 	
 	uint8 *fail(uint8 *pc)
@@ -96,12 +194,40 @@ public:
 	void memmap(H8SDevice *dev,int start,int len = 1)
 	{
 		dev->setState(this);
-		for (int i=0;i<len;i++) maps[start+i]=dev;
+		while (len > 0)
+		{
+			MemPage& p = pages[(start >> kPageBits) & (kPageCount - 1)];
+			const int offset = start & kPageMask;
+			const int count = std::min(len, static_cast<int>(kPageSize) - offset);
+			p.decoded.reset();
+			if (count == static_cast<int>(kPageSize))
+			{
+				p.mem = nullptr;
+				p.device = dev;
+				p.devices.reset();
+			}
+			else
+			{
+				if (!p.devices)
+				{
+					p.devices.reset(new H8SDevice*[kPageSize]);
+					for (uint32_t i=0; i<kPageSize; i++) p.devices[i] = p.device;
+					p.mem = nullptr;
+					p.device = nullptr;
+				}
+				for (int i=0;i<count;i++) p.devices[offset+i] = dev;
+			}
+			start += count;
+			len -= count;
+		}
 	}
 	
 	void loadmem(const uint8* data,uint32_t size,uint32_t address)
 	{
 		memcpy(memory + address,data,size);
+		if (!size) return;
+		for (uint32_t i = address >> kPageBits; i <= ((address + size - 1) >> kPageBits) && i < kPageCount; i++)
+			pages[i].decoded.reset();
 	}
 	
 	void readMemory(uint8* to, int from, int len)
@@ -127,24 +253,110 @@ public:
 	int16 read16(uint8 *from) {return read16((int)(from-memory));}
 	int8 read8(uint8 *from) {return read8((int)(from-memory));}
 	
-	void write32(int32 val,int to) {write16(val>>16,to);write16(val&0xffff,to+2);}
-	uint32 read32(int from) {uint32 s=read16(from)&0xffff;s=(s<<16)|(read16(from+2)&0xffff);return s;}
-	void write16(int16 val,int to) {write8(val>>8,to);write8(val&255,to+1);}
-	uint16 read16(int from) {uint16 s=read8(from)&255;s=(s<<8)|(read8(from+1)&255);return s;}
+	// aligned 16/32 bit accesses to pages backed by host memory take the fast path. The cycle accounting is identical
+	// to two/four byte accesses via clockMem, only 8 bit bus regions and device pages go byte by byte
+	void write32(int32 val,int to) {
+		to&=0xffffff;
+		if (!(to & 3))
+		{
+			const MemPage& p = pages[to >> kPageBits];
+			if (uint8* m = p.mem)
+			{
+				if (const int states = busStates16(to))
+				{
+					cycles += states << 1;
+					lastwrite = to + 3;
+					m += to & kPageMask;
+					m[0] = (uint8)(val >> 24); m[1] = (uint8)(val >> 16); m[2] = (uint8)(val >> 8); m[3] = (uint8)val;
+					if (p.decoded) invalidateDecoded(p, to, 2);
+					return;
+				}
+			}
+		}
+		write16(val>>16,to);write16(val&0xffff,to+2);
+	}
+	uint32 read32(int from) {
+		from&=0xffffff;
+		if (!(from & 3))
+		{
+			if (const uint8* m = pages[from >> kPageBits].mem)
+			{
+				if (const int states = busStates16(from))
+				{
+					cycles += states << 1;
+					lastread = from + 3;
+					m += from & kPageMask;
+					return ((uint32)m[0] << 24) | ((uint32)m[1] << 16) | ((uint32)m[2] << 8) | m[3];
+				}
+			}
+		}
+		uint32 s=read16(from)&0xffff;s=(s<<16)|(read16(from+2)&0xffff);return s;
+	}
+	void write16(int16 val,int to) {
+		to&=0xffffff;
+		if (!(to & 1))
+		{
+			const MemPage& p = pages[to >> kPageBits];
+			if (uint8* m = p.mem)
+			{
+				if (const int states = busStates16(to))
+				{
+					cycles += states;
+					lastwrite = to + 1;
+					m += to & kPageMask;
+					m[0] = (uint8)(val >> 8); m[1] = (uint8)val;
+					if (p.decoded) invalidateDecoded(p, to, 1);
+					return;
+				}
+			}
+		}
+		write8(val>>8,to);write8(val&255,to+1);
+	}
+	uint16 read16(int from) {
+		from&=0xffffff;
+		if (!(from & 1))
+		{
+			if (const uint8* m = pages[from >> kPageBits].mem)
+			{
+				if (const int states = busStates16(from))
+				{
+					cycles += states;
+					lastread = from + 1;
+					m += from & kPageMask;
+					return (uint16)((m[0] << 8) | m[1]);
+				}
+			}
+		}
+		uint16 s=read8(from)&255;s=(s<<8)|(read8(from+1)&255);return s;
+	}
 	
 	void write8(int8 byte,int to) {
 		to&=0xffffff;
 		clockMem(to, lastwrite);
-		if (maps[to]) maps[to]->write(to, byte);
+		const MemPage& p = pages[to >> kPageBits];
+		if (p.mem)
+		{
+			p.mem[to & kPageMask]=byte;
+			if (p.decoded) invalidateDecoded(p, to, 1);
+		}
+		else if (H8SDevice* d = p.device ? p.device : p.devices[to & kPageMask]) d->write(to, byte);
 		else memory[to]=byte;
 	}
 	int8 read8(int from) {
 		from&=0xffffff;
 		clockMem(from, lastread);
-		if (maps[from]) return maps[from]->read(from);
+		const MemPage& p = pages[from >> kPageBits];
+		if (p.mem) return p.mem[from & kPageMask];
+		if (H8SDevice* d = p.device ? p.device : p.devices[from & kPageMask]) return d->read(from);
 		return memory[from];
 	}
 	
+	static void invalidateDecoded(const MemPage& p, int addr, int count)
+	{
+		DecodedInstr* d = &p.decoded[(addr & kPageMask) >> 1];
+		for (int i=0; i<count; i++) d[i].exec = nullptr;
+	}
+
 	void pushL(uint32 val)	{uint32 sp=getSP()-4;write32(val,sp);setSP(sp);}
 	uint32 popL() 			{uint32 sp=getSP();setSP(sp+4);return read32(sp);}
 	void pushW(uint16 val)	{uint16 sp=getSP()-2;write16(val,sp);setSP(sp);}
@@ -164,16 +376,17 @@ public:
 	uint8 *loadPCFrom(uint32 addr) {return (read32(addr)&0xFFFFFF)+memory;}
 	
 	void clockI(int I) {cycles += I;}
+	static int busStates16(int addr)	// states per access for areas with a 16bit bus, 0 for 8bit areas
+	{
+		if (addr < 0x400000) return 3;	// rom and ram
+		if (addr >= 0xFFFD10 && addr < 0xffffa0) return 1;	// on-chip ram / regs
+		return 0;
+	}
 	void clockMem(int addr, int& last)
 	{
-		if (addr < 0x400000)	// rom and ram, 16bit reads, 3 states
-		{
-			if ((last & 1) || addr != (last | 1)) cycles += 3;
-			last = addr;
-		}
-		else if (addr >= 0xFFFD10 && addr < 0xffffa0)	// on-chip ram / regs, 16bit, 1 state
+		if (const int states = busStates16(addr))	// rom and ram 3 states, on-chip ram / regs 1 state
 		{
-			if ((last & 1) || addr != (last | 1)) cycles++;
+			if ((last & 1) || addr != (last | 1)) cycles += states;
 			last = addr;
 		}
 		else if (addr >= 0xffffa0)	// on-chip regs, 8bit, 1 state
@@ -189,6 +402,7 @@ public:
 	}
 	
 	unsigned long long getCycles() const {return cycles;}
+	unsigned long long getSyncCycles() const {return syncCycles;}
 	
 	double real_time_in_sec() const {double d = static_cast<double>(cycles); return d / (16.0e6);}
 	
@@ -262,6 +476,12 @@ protected:
 	int lastread {-1}, lastwrite {-1};
 };
 
+inline void H8SScheduledDevice::setDeadline(unsigned long long _cycles)
+{
+	deadline = _cycles;
+	if (state) state->scheduleEvent(_cycles);
+}
+
 template<bool execute,bool disassemble>
 class H8S : public h8state
 {
@@ -269,6 +489,25 @@ public:
 	void step()
 	{
 		pc = handle_instr(pc);
+		syncCycles = cycles;
+		if (cycles >= nextEvent) runEvents();
+	}
+	// run until the cycle counter reaches the given value
+	void runUntil(unsigned long long _cycles)
+	{
+		while (cycles < _cycles) step();
+	}
+	// reference implementation, ticks all scheduled devices after every instruction. Much slower but useful to verify
+	// that the deadlines provided by the devices are correct
+	void stepTicked()
+	{
+		pc = handle_instr(pc);
+		syncCycles = cycles;
+		syncAll();
+	}
+	void runUntilTicked(unsigned long long _cycles)
+	{
+		while (cycles < _cycles) stepTicked();
 	}
 	uint8 *handle_instr(uint8 *_pc)
 	{
@@ -294,6 +533,15 @@ public:
 		}
 		if (disassemble && g_dasm) for (int i = 0; i < indent; i++) printf(" ");
 		if (((long long)pc)&1) pc--;	// ALWAYS mask off the bottom bit when loading short or int.
+		if (const DecodedInstr* d = getDecoded(pc))
+		{
+			// the opcode fetches are clocked just like the read8 calls of the dispatchers below
+			const int a = pcoff(pc);
+			clockMem(a, lastread);
+			if (!d->prefix) return d->exec(*this, *d, pc + 1);
+			clockMem(a + 1, lastread);
+			return d->exec(*this, *d, pc + 2);
+		}
 		uint8 firstbyte=read8(pc);pc++;
 		switch((firstbyte>>4)&15)
 		{
@@ -666,6 +914,312 @@ protected:
 	}
 
 
+	// Pre-decoding. The decoder below resolves the same handlers as the dispatchers above, but from the opcode bytes only,
+	// without fetching them. Invalid instructions are not decoded, they take the regular path which reports them
+	typedef uint8* (H8S::*HandlerOp)(uint8, uint8*);
+	typedef uint8* (H8S::*HandlerOpB)(uint8, uint8, uint8*);
+	typedef uint8* (H8S::*HandlerOpBImm)(uint8, uint8, uint8*, int);
+
+	template<HandlerOp F> static uint8* execOp(h8state& s, const DecodedInstr& d, uint8* pc)
+	{
+		return (static_cast<H8S&>(s).*F)(d.op, pc);
+	}
+	template<HandlerOpB F> static uint8* execOpB(h8state& s, const DecodedInstr& d, uint8* pc)
+	{
+		return (static_cast<H8S&>(s).*F)(d.op, d.b, pc);
+	}
+	template<HandlerOpBImm F, int imm> static uint8* execOpBImm(h8state& s, const DecodedInstr& d, uint8* pc)
+	{
+		return (static_cast<H8S&>(s).*F)(d.op, d.b, pc, imm);
+	}
+
+	template<HandlerOp F> static bool decoded(DecodedInstr& d)			{d.exec = &execOp<F>; d.prefix = false; return true;}
+	template<HandlerOpB F> static bool decoded(DecodedInstr& d)			{d.exec = &execOpB<F>; d.prefix = true; return true;}
+	template<HandlerOpBImm F, int imm> static bool decoded(DecodedInstr& d)	{d.exec = &execOpBImm<F,imm>; d.prefix = true; return true;}
+
+	const DecodedInstr *getDecoded(uint8 *pc)
+	{
+		const int a = pcoff(pc) & 0xffffff;
+		MemPage& p = pages[a >> kPageBits];
+		if (!p.mem) return nullptr;	// devices may have side effects on reads, never pre-decode them
+		if (!p.decoded) p.decoded.reset(new DecodedInstr[kDecodedPerPage]);
+		DecodedInstr& d = p.decoded[(a & kPageMask) >> 1];
+		if (d.exec) return &d;
+		const uint8* m = p.mem + (a & kPageMask);
+		return decode(d, m[0], m[1]) ? &d : nullptr;
+	}
+
+	static bool decode(DecodedInstr& d, uint8 op, uint8 b)
+	{
+		d.op = op;
+		d.b = b;
+		switch((op>>4)&15)
+		{
+		case 0: return decode_0(d);
+		case 1: return decode_1(d);
+		case 2: return decoded<&H8S::handle_movba>(d);
+		case 3: return decoded<&H8S::handle_movba>(d);
+		case 4: return decoded<&H8S::handle_bcc>(d);
+		case 5: return decode_5(d);
+		case 6: return decode_6(d);
+		case 7:	return decode_7(d);
+		case 8: return decoded<&H8S::handle_addi>(d);
+		case 9:	return decoded<&H8S::handle_addxi>(d);
+		case 10:return decoded<&H8S::handle_cmpi>(d);
+		case 11:return decoded<&H8S::handle_subxi>(d);
+		case 12:return decoded<&H8S::handle_ori>(d);
+		case 13:return decoded<&H8S::handle_xori>(d);
+		case 14:return decoded<&H8S::handle_andi>(d);
+		case 15:return decoded<&H8S::handle_movbi>(d);
+		}
+		return false;
+	}
+	static bool decode_0(DecodedInstr& d)
+	{
+		switch (d.op&15)
+		{
+		case 0:	return decoded<&H8S::handle_nop>(d);
+		case 1:	return decode_01(d);
+		case 2:	return decoded<&H8S::handle_stcr>(d);
+		case 3:	return decoded<&H8S::handle_ldcr>(d);
+		case 4:	return decoded<&H8S::handle_orc>(d);
+		case 5:	return decoded<&H8S::handle_xorc>(d);
+		case 6:	return decoded<&H8S::handle_andc>(d);
+		case 7:	return decoded<&H8S::handle_ldci>(d);
+		case 8: return decoded<&H8S::handle_addr>(d);
+		case 9: return decoded<&H8S::handle_addrw>(d);
+		case 10:return decode_0a(d);
+		case 11:return decode_0b(d);
+		case 12:return decoded<&H8S::handle_movr>(d);
+		case 13:return decoded<&H8S::handle_movrw>(d);
+		case 14:return decoded<&H8S::handle_addxr>(d);
+		case 15:return decode_0f(d);
+		}
+		return false;
+	}
+	static bool decode_1(DecodedInstr& d)
+	{
+		switch (d.op&15)
+		{
+		case 0:	return decode_shift<&H8S::handle_shal, &H8S::handle_shll>(d);
+		case 1:	return decode_shift<&H8S::handle_shar, &H8S::handle_shlr>(d);
+		case 2:	return decode_shift<&H8S::handle_rotl, &H8S::handle_rotxl>(d);
+		case 3:	return decode_shift<&H8S::handle_rotr, &H8S::handle_rotxr>(d);
+		case 4:	return decoded<&H8S::handle_orr>(d);
+		case 5:	return decoded<&H8S::handle_xorr>(d);
+		case 6:	return decoded<&H8S::handle_andr>(d);
+		case 7:	return decode_17(d);
+		case 8:	return decoded<&H8S::handle_subr>(d);
+		case 9:	return decoded<&H8S::handle_subrw>(d);
+		case 10:return decode_1a(d);
+		case 11:return decode_1b(d);
+		case 12:return decoded<&H8S::handle_cmpr>(d);
+		case 13:return decoded<&H8S::handle_cmprw>(d);
+		case 14:return decoded<&H8S::handle_subxr>(d);
+		case 15:return decode_1f(d);
+		}
+		return false;
+	}
+	static bool decode_5(DecodedInstr& d)
+	{
+		switch (d.op&15)
+		{
+		case 0:	return decoded<&H8S::handle_mulxu>(d);
+		case 1:	return decoded<&H8S::handle_divxu>(d);
+		case 2:	return decoded<&H8S::handle_mulxuw>(d);
+		case 3:	return decoded<&H8S::handle_divxuw>(d);
+		case 4:	return decoded<&H8S::handle_rts>(d);
+		case 5: return decoded<&H8S::handle_bsr>(d);
+		case 6:	return decoded<&H8S::handle_rte>(d);
+		case 7: return decoded<&H8S::handle_trapa>(d);
+		case 8:	return decoded<&H8S::handle_bccw>(d);
+		case 9:	return decoded<&H8S::handle_jmpae>(d);
+		case 10:return decoded<&H8S::handle_jmpimm>(d);
+		case 11:return decoded<&H8S::handle_jmpaa>(d);
+		case 12:return decoded<&H8S::handle_bsrw>(d);
+		case 13:return decoded<&H8S::handle_jsrae>(d);
+		case 14:return decoded<&H8S::handle_jsrimm>(d);
+		case 15:return decoded<&H8S::handle_jsraa>(d);
+		}
+		return false;
+	}
+	static bool decode_6(DecodedInstr& d)
+	{
+		switch (d.op&15)
+		{
+		case 0: return decoded<&H8S::handle_bsetr>(d);
+		case 1: return decoded<&H8S::handle_bnotr>(d);
+		case 2: return decoded<&H8S::handle_bclrr>(d);
+		case 3: return decoded<&H8S::handle_btstr>(d);
+		case 4:	return decoded<&H8S::handle_orrw>(d);
+		case 5:	return decoded<&H8S::handle_xorrw>(d);
+		case 6:	return decoded<&H8S::handle_andrw>(d);
+		case 7:	return decoded<&H8S::handle_bsti>(d);
+		case 8: return decoded<&H8S::handle_movbae>(d);
+		case 9:	return decoded<&H8S::handle_movwae>(d);
+		case 10:return decode_6a(d);
+		case 11:return decoded<&H8S::handle_movwaa>(d);
+		case 12:return decoded<&H8S::handle_movbaep>(d);
+		case 13:return decoded<&H8S::handle_movwaep>(d);
+		case 14:return decoded<&H8S::handle_movbaeo>(d);
+		case 15:return decoded<&H8S::handle_movwaeo>(d);
+		}
+		return false;
+	}
+	static bool decode_7(DecodedInstr& d)
+	{
+		switch (d.op&15)
+		{
+		case 0: return decoded<&H8S::handle_bseti>(d);
+		case 1: return decoded<&H8S::handle_bnoti>(d);
+		case 2: return decoded<&H8S::handle_bclri>(d);
+		case 3: return decoded<&H8S::handle_btsti>(d);
+		case 4:	return decoded<&H8S::handle_bor>(d);
+		case 5:	return decoded<&H8S::handle_bxor>(d);
+		case 6: return decoded<&H8S::handle_band>(d);
+		case 7: return decoded<&H8S::handle_bld>(d);
+		case 8: return decoded<&H8S::handle_movbwaed>(d);
+		case 9:	return decode_79(d);
+		case 10:return decode_7a(d);
+		case 11:return decoded<&H8S::handle_eepmov>(d);
+		default:return decoded<&H8S::handle_bitstuff_1>(d);
+		}
+	}
+	static bool decode_01(DecodedInstr& d)
+	{
+		switch ((d.b>>4)&15)
+		{
+		case 0:	return decoded<&H8S::handle_movl>(d);
+		case 1:
+		case 2:
+		case 3:	return decoded<&H8S::handle_ldmstm>(d);
+		case 4:	return decoded<&H8S::handle_ldcstc>(d);
+		case 8: return decoded<&H8S::handle_sleep>(d);
+		case 12:return decoded<&H8S::handle_instr_01c>(d);
+		case 13:return decoded<&H8S::handle_instr_01d>(d);
+		case 14:return decoded<&H8S::handle_tas>(d);
+		case 15:return decoded<&H8S::handle_instr_01f>(d);
+		default:return false;
+		}
+	}
+	static bool decode_0a(DecodedInstr& d)
+	{
+		if (d.b&0x80) return decoded<&H8S::handle_addl>(d);
+		if (!(d.b&0xf0)) return decoded<&H8S::handle_incb>(d);
+		return false;
+	}
+	static bool decode_0b(DecodedInstr& d)
+	{
+		switch ((d.b>>4)&15)
+		{
+		case 0:	return decoded<&H8S::handle_addsi,1>(d);
+		case 5: return decoded<&H8S::handle_incwi,1>(d);
+		case 7: return decoded<&H8S::handle_incli,1>(d);
+		case 8:	return decoded<&H8S::handle_addsi,2>(d);
+		case 9:	return decoded<&H8S::handle_addsi,4>(d);
+		case 13:return decoded<&H8S::handle_incwi,2>(d);
+		case 15:return decoded<&H8S::handle_incli,2>(d);
+		default:return false;
+		}
+	}
+	static bool decode_0f(DecodedInstr& d)
+	{
+		if (d.b&0x80) return decoded<&H8S::handle_movrl>(d);
+		if (!(d.b&0xf0)) return decoded<&H8S::handle_daa>(d);
+		return false;
+	}
+	template<HandlerOpB FA, HandlerOpB FL> static bool decode_shift(DecodedInstr& d)	// 0x10 - 0x13
+	{
+		int top=(d.b>>4)&7; if (top==2 || top==6) return false;
+		if (d.b&128)	return decoded<FA>(d);
+		else		return decoded<FL>(d);
+	}
+	static bool decode_17(DecodedInstr& d)
+	{
+		switch ((d.b>>4)&15)
+		{
+		case 0:
+		case 1:
+		case 3:	return decoded<&H8S::handle_not>(d);
+		case 5:
+		case 7:	return decoded<&H8S::handle_extu>(d);
+		case 8:
+		case 9:
+		case 11:return decoded<&H8S::handle_neg>(d);
+		case 13:
+		case 15:return decoded<&H8S::handle_exts>(d);
+		default:return false;
+		}
+	}
+	static bool decode_1a(DecodedInstr& d)
+	{
+		if (d.b&0x80) return decoded<&H8S::handle_subl>(d);
+		if (!(d.b&0xf0)) return decoded<&H8S::handle_decb>(d);
+		return false;
+	}
+	static bool decode_1b(DecodedInstr& d)
+	{
+		switch ((d.b>>4)&15)
+		{
+		case 0:	return decoded<&H8S::handle_subsi,1>(d);
+		case 5:	return decoded<&H8S::handle_decwi,1>(d);
+		case 7:	return decoded<&H8S::handle_decli,1>(d);
+		case 8:	return decoded<&H8S::handle_subsi,2>(d);
+		case 9:	return decoded<&H8S::handle_subsi,4>(d);
+		case 13:return decoded<&H8S::handle_decwi,2>(d);
+		case 15:return decoded<&H8S::handle_decli,2>(d);
+		default:return false;
+		}
+	}
+	static bool decode_1f(DecodedInstr& d)
+	{
+		if (d.b&0x80) return decoded<&H8S::handle_cmpl>(d);
+		if (!(d.b&0xf0)) return decoded<&H8S::handle_das>(d);
+		return false;
+	}
+	static bool decode_6a(DecodedInstr& d)
+	{
+		switch ((d.b>>4)&15)
+		{
+		case 0:
+		case 2:
+		case 8:
+		case 10:return decoded<&H8S::handle_movbaa>(d);
+		case 1:
+		case 3:	return decoded<&H8S::handle_bitstuff_2>(d);
+		default:return false;
+		}
+	}
+	static bool decode_79(DecodedInstr& d)
+	{
+		switch ((d.b>>4)&15)
+		{
+		case 0:	return decoded<&H8S::handle_movwi>(d);
+		case 1:	return decoded<&H8S::handle_addwi>(d);
+		case 2: return decoded<&H8S::handle_cmpwi>(d);
+		case 3: return decoded<&H8S::handle_subwi>(d);
+		case 4: return decoded<&H8S::handle_orwi>(d);
+		case 5:	return decoded<&H8S::handle_xorwi>(d);
+		case 6:	return decoded<&H8S::handle_andwi>(d);
+		default:return false;
+		}
+	}
+	static bool decode_7a(DecodedInstr& d)
+	{
+		switch ((d.b>>4)&15)
+		{
+		case 0:	return decoded<&H8S::handle_movli>(d);
+		case 1:	return decoded<&H8S::handle_addli>(d);
+		case 2: return decoded<&H8S::handle_cmpli>(d);
+		case 3: return decoded<&H8S::handle_subli>(d);
+		case 4: return decoded<&H8S::handle_orli>(d);
+		case 5:	return decoded<&H8S::handle_xorli>(d);
+		case 6:	return decoded<&H8S::handle_andli>(d);
+		default:return false;
+		}
+	}
+
+
 	//////// MOV.B @immediate,Reg
 	uint8 *handle_movba(uint8 op,uint8 *pc)
 	{
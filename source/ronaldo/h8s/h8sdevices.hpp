@@ -13,25 +13,31 @@ public:
 };
 
 // H8S timers (all timers)
-class Timers : public H8SDevice
+class Timers : public H8SScheduledDevice
 {
 public:
 	Timers() {}
 	void tick_extclock(int which) {
 		channels[which].gra++;
 	}
+	void sync() override { tick(); }
 	void tick()
 	{
 		for (int i = 0; i < 5; i++)
 		{
-			if (!(tstr & (1 << i))) continue;	// skip halted channels
-			if (tmdr & (1 << i)) continue;		// skip pwm channels
+			if (!isCounting(i)) continue;
 			class channel& c = channels[i];
-			if (c.tcr & 4) continue;			// skip externally clocked channels
 			int shift = (c.tcr & 3);
-			unsigned int inc = (unsigned int)((state->cycles >> shift) - (lastCycles >> shift));	// how many cycles have passed?
-			for (int j = 0; j < inc; j++)
+			unsigned int inc = (unsigned int)((state->getSyncCycles() >> shift) - (lastCycles >> shift));	// how many cycles have passed?
+			while (inc)
 			{
+				// nothing happens until tcnt reaches one of gra, grb or zero, skip to that increment
+				const unsigned int skip = std::min(inc, incrementsToEvent(c));
+				c.tcnt += skip;
+				inc -= skip;
+				if (!inc) break;
+				inc--;
+
 				uint16 nt = c.tcnt + 1;
 				if (c.tcnt == c.gra)
 				{
@@ -53,10 +59,12 @@ public:
 				c.tcnt = nt;
 			}
 		}
-		lastCycles = state->cycles;
+		lastCycles = state->getSyncCycles();
+		updateDeadline();
 	}
 	virtual uint8_t read(uint32_t address) {
 		if (address<0xffff60 || address >= 0xffffa0) return 0;
+		tick();
 		address -= 0xffff60;
 		switch (address)
 		{
@@ -94,7 +102,49 @@ public:
 		
 	virtual void write(uint32_t address, uint8_t value) {
 		if (address<0xffff60 || address >= 0xffffa0) return;
-		address -= 0xffff60;
+		tick();
+		writeReg(address - 0xffff60, value);
+		updateDeadline();
+	}
+
+	template<typename TStream> void saveState(TStream& _s) const
+	{
+		_s.write(lastCycles); _s.write(space); _s.write(tstr); _s.write(tsnc); _s.write(tmdr); _s.write(tfcr); _s.write(channels);
+	}
+	template<typename TStream> void loadState(TStream& _s)
+	{
+		_s.read(lastCycles); _s.read(space); _s.read(tstr); _s.read(tsnc); _s.read(tmdr); _s.read(tfcr); _s.read(channels);
+		updateDeadline();
+	}
+
+private:	// 0x9f -> 0x60
+	class channel;
+
+	bool isCounting(int i) const
+	{
+		if (!(tstr & (1 << i))) return false;	// halted channel
+		if (tmdr & (1 << i)) return false;		// pwm channel
+		return !(channels[i].tcr & 4);			// externally clocked channel
+	}
+
+	static unsigned int incrementsToEvent(const channel& c)	// until tcnt equals gra, grb or zero
+	{
+		return std::min({(c.gra - c.tcnt) & 0xffffu, (c.grb - c.tcnt) & 0xffffu, (0x10000u - c.tcnt) & 0xffffu});
+	}
+
+	void updateDeadline()
+	{
+		unsigned long long next = kNoEvent;
+		for (int i = 0; i < 5; i++)
+		{
+			if (!isCounting(i)) continue;
+			const int shift = (channels[i].tcr & 3);
+			next = std::min(next, ((lastCycles >> shift) + incrementsToEvent(channels[i]) + 1) << shift);
+		}
+		setDeadline(next);
+	}
+
+	void writeReg(uint32_t address, uint8_t value) {
 		switch (address)
 		{
 			case 0: tstr = value; return;
@@ -128,7 +178,6 @@ public:
 		}
 	}
 
-private:	// 0x9f -> 0x60
 	unsigned long long lastCycles {0};
 	int8 space[64] {};
 	uint8 tstr {0xc0}, tsnc {0xc0}, tmdr {0x80}, tfcr {0xc0};	// timer start, timer sync, timer mode reg, timer function control
@@ -141,11 +190,12 @@ private:	// 0x9f -> 0x60
 	channel channels[5];
 };
 
-class RefreshController : public H8SDevice
+class RefreshController : public H8SScheduledDevice
 {
 public:
 	virtual uint8_t read(uint32_t address)
 	{
+		tick();
 		address &= 3;
 		int force = 0;
 		if (address == 0) force = 2;
@@ -154,6 +204,7 @@ public:
 	}
 	virtual void write(uint32_t address, uint8_t value)
 	{
+		tick();
 		address &= 3;
 		if (address == 0) printf("Write to RFSHCR %02x\n", value);
 		if (address == 1)
@@ -164,23 +215,39 @@ public:
 			cmie = value & 64;
 		}
 		regs[address] = value;
+		updateDeadline();
 	}
+	void sync() override { tick(); }
 	void tick()
 	{
 		if (!shift) return;
-		unsigned int inc = (unsigned int)((state->cycles >> shift) - (lastCycles >> shift));	// how many cycles have passed?
-		for (int i = 0; i < inc; i++)
+		unsigned int inc = (unsigned int)((state->getSyncCycles() >> shift) - (lastCycles >> shift));	// how many cycles have passed?
+		while (inc)
 		{
+			// skip the increments that do not reach the compare value
+			const unsigned int skip = std::min(inc, incrementsToMatch() - 1);
+			regs[2] += skip;
+			inc -= skip;
+			if (!inc) break;
+			inc--;
+
 			regs[2]++;
 			if (regs[2] != regs[3]) continue;
 			regs[2] = 0;
 			regs[0] |= 128; // Set CMF
 			if (cmie) state->interrupt(21);
 		}
-		lastCycles = state->cycles;
-		
+		lastCycles = state->getSyncCycles();
+		updateDeadline();
 	}
 protected:
+	unsigned int incrementsToMatch() const { return ((regs[3] - regs[2] - 1) & 0xff) + 1; }
+	void updateDeadline()
+	{
+		if (!shift) setDeadline(kNoEvent);
+		else setDeadline(((lastCycles >> shift) + incrementsToMatch()) << shift);
+	}
+
 	uint8_t regs[4] {2, 7, 0, 255};
 	uint64_t lastCycles {0};
 	uint32_t shift {0};
@@ -188,11 +255,12 @@ protected:
 };
 
 // H8S Serial port (single)
-class Serial : public H8SDevice
+class Serial : public H8SScheduledDevice
 {
 public:
 	Serial(int _irqoff = 0, std::function<void(uint8_t)>&& _outputCallback = [](uint8_t) {}) : irqoff(_irqoff), outputCallback(std::move(_outputCallback)) {}
 	virtual uint8_t read(uint32_t address) {
+		tick();
 		address &= 7;
 		switch (address)
 		{
@@ -205,6 +273,7 @@ public:
 		}
 	}
 	virtual void write(uint32_t address, uint8_t value) {
+		tick();
 		address &= 7;
 		switch (address)
 		{
@@ -229,13 +298,15 @@ public:
 				data[address] = value;
 				break;
 		}
+		updateDeadline();
 	}
-	void provideMIDI(const uint8 *data, size_t len) {for (size_t i = 0; i < len; i++) tosend.push(data[i]);}
+	void provideMIDI(const uint8 *data, size_t len) {for (size_t i = 0; i < len; i++) tosend.push(data[i]); updateDeadline();}
+	void sync() override { tick(); }
 	void tick()
 	{
 		if (txrtimer)
 		{
-			unsigned long long cycles = state->getCycles();
+			unsigned long long cycles = state->getSyncCycles();
 			int diff = (int)(cycles - lastcycles);
 			lastcycles = cycles;
 			txrtimer -= diff;
@@ -254,8 +325,32 @@ public:
 			tosend.pop();
 			state->interrupt(53 + irqoff);
 		}
+		updateDeadline();
+	}
+	template<typename TStream> void saveState(TStream& _s) const
+	{
+		auto q = tosend;
+		_s.write(static_cast<uint32_t>(q.size()));
+		for (; !q.empty(); q.pop()) _s.write(q.front());
+		_s.write(data); _s.write(scr); _s.write(txr); _s.write(rdr); _s.write(ssr); _s.write(lastcycles); _s.write(txrtimer);
+	}
+	template<typename TStream> void loadState(TStream& _s)	// restore the cpu state first
+	{
+		uint32_t count = 0;
+		_s.read(count);
+		tosend = {};
+		for (uint32_t i = 0; i < count; i++) {uint8 b = 0; _s.read(b); tosend.push(b);}
+		_s.read(data); _s.read(scr); _s.read(txr); _s.read(rdr); _s.read(ssr); _s.read(lastcycles); _s.read(txrtimer);
+		updateDeadline();
 	}
 protected:
+	void updateDeadline()
+	{
+		if (!tosend.empty() && !(ssr & 64)) setDeadline(state ? state->getSyncCycles() : 0);	// receive as soon as possible
+		else if (txrtimer) setDeadline(lastcycles + txrtimer);
+		else setDeadline(kNoEvent);
+	}
+
 	static constexpr int clocktime = (16000000 / 31250) * 10;	// 5120 clocks to send a midi byte.
 	std::queue<uint8> tosend;
 	int8 data[8], scr {0}, txr {-1}, rdr {0}, ssr {-128};
@@ -278,7 +373,7 @@ public:
 			outputCallback(static_cast<uint8_t>(value & 255));
 		}
 	}
-	void provideMIDI(const uint8 *data, size_t len) {for (size_t i = 0; i < len; i++) tosend.push(data[i]);}
+	void provideMIDI(const uint8 *data, size_t len) {for (size_t i = 0; i < len; i++) tosend.push(data[i]); updateDeadline();}
 
 protected:
 	std::function<void(uint8_t)> outputCallback;
@@ -373,6 +468,8 @@ public:
 	HWRegs() {}
 	virtual uint8_t read(uint32_t address) { return data[address&255]; }
 	virtual void write(uint32_t address, uint8_t value) { data[address&255] = value; }
+	template<typename TStream> void saveState(TStream& _s) const { _s.write(data); }
+	template<typename TStream> void loadState(TStream& _s) { _s.read(data); }
 protected:
 	int8 data[256];
 };
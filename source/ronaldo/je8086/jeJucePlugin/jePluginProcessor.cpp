@@ -40,6 +40,12 @@ namespace jeJucePlugin
 			m_selectedRom = 0;
 		}
 
+		// runs the four ASICs on separate threads, trades CPU load per core for higher latency
+		m_pipelinedAsics = getConfig().getBoolValue("pipelinedAsics", false);
+
+		// avoids dropouts on patch changes, but offline renders are no longer reproducible
+		m_backgroundCompile = getConfig().getBoolValue("backgroundAsicCompile", false);
+
 		getController();
 		const auto latencyBlocks = getConfig().getIntValue("latencyBlocks", static_cast<int>(getPlugin().getLatencyBlocks()));
 		Processor::setLatencyBlocks(latencyBlocks);
@@ -70,6 +76,11 @@ namespace jeJucePlugin
 		params.romName = rom.getName();
 		params.homePath = getDataFolder();
 
+		if (m_pipelinedAsics)
+			params.customData |= jeLib::Device::CustomDataPipelinedAsics;
+		if (m_backgroundCompile)
+			params.customData |= jeLib::Device::CustomDataBackgroundCompile;
+
 		auto* d = new jeLib::Device(params);
 		if(!d->isValid())
 			throw synthLib::DeviceException(synthLib::DeviceError::FirmwareMissing, errorMsg);
@@ -80,12 +91,16 @@ namespace jeJucePlugin
 	{
 		Processor::getRemoteDeviceParams(_params);
 
+		if (m_pipelinedAsics)
+			_params.customData |= jeLib::Device::CustomDataPipelinedAsics;
+		if (m_backgroundCompile)
+			_params.customData |= jeLib::Device::CustomDataBackgroundCompile;
+
 		auto rom = jeLib::RomLoader::findROM();
 
 		if (rom.isValid())
 		{
-			auto data = rom.getData();
-			_params.romData.assign(data.begin(), data.end());
+			_params.romData = rom.getData();
 			_params.romName = rom.getName();
 		}
 	}
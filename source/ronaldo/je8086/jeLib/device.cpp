@@ -2,6 +2,11 @@
 
 #include "je8086.h"
 #include "jeThread.h"
+
+#include "baseLib/filesystem.h"
+
+#include "dsp56kBase/logging.h"
+
 #include "synthLib/midiToSysex.h"
 
 namespace
@@ -21,7 +26,8 @@ namespace jeLib
 
 	Device::Device(const synthLib::DeviceCreateParams& _params) : synthLib::Device(_params)
 	{
-		const auto ramDataFilename = _params.homePath.empty() ? "ram_dump.bin" : _params.homePath + "/roms/ram_dump.bin";
+		const auto romsPath = _params.homePath.empty() ? std::string() : _params.homePath + "/roms/";
+		const auto ramDataFilename = romsPath + "ram_dump.bin";
 		m_je8086.reset(new Je8086(_params.romData, ramDataFilename));
 
 		if (m_je8086->hasDoneFactoryReset())
@@ -30,6 +36,36 @@ namespace jeLib
 			m_je8086.reset(new Je8086(_params.romData, ramDataFilename));
 		}
 
+		// booting takes millions of uC cycles. It is done once per ROM and build, later instances start from the snapshot
+		const auto snapshotFilename = Je8086::getSnapshotFilename(romsPath, _params.romData.getHash());
+
+		std::vector<uint8_t> snapshot;
+		baseLib::filesystem::readFile(snapshot, snapshotFilename);
+
+		if (!m_je8086->loadSnapshot(snapshot))
+		{
+			if (!snapshot.empty())
+			{
+				// outdated or from a different RAM image, the machine may have been partially modified
+				m_je8086.reset();
+				m_je8086.reset(new Je8086(_params.romData, ramDataFilename));
+			}
+
+			// this instance boots from power-on and provides the snapshot for the next one once it has booted
+			if (!m_je8086->hasDoneFactoryReset())
+			{
+				m_je8086->setBootSnapshotCallback([this, snapshotFilename](std::vector<uint8_t>& _snapshot)
+				{
+					writeSnapshot(snapshotFilename, _snapshot);
+				});
+			}
+		}
+
+		if (_params.customData & CustomDataPipelinedAsics)
+			m_je8086->setPipelinedAsics(true);
+		if (_params.customData & CustomDataBackgroundCompile)
+			m_je8086->setBackgroundCompile(true);
+
 		m_thread.reset(new JeThread(*m_je8086));
 
 		m_paramChangedListener.set(m_sysexRemote.evParamChanged, [this](const uint8_t _page, const uint8_t _index, const int32_t& _value)
@@ -48,10 +84,25 @@ namespace jeLib
 
 	Device::~Device()
 	{
+		// the emulation thread is the one that starts writing the snapshot, stop it first
 		m_thread.reset();
+
+		if (m_snapshotThread.joinable())
+			m_snapshotThread.join();
+
 		m_je8086.reset();
 	}
 
+	void Device::writeSnapshot(const std::string& _snapshotFilename, std::vector<uint8_t>& _snapshot)
+	{
+		// the snapshot is taken while processing audio, do not wait for the file system there
+		m_snapshotThread = std::thread([_snapshotFilename, snapshot = std::move(_snapshot)]
+		{
+			if (!baseLib::filesystem::writeFileAtomic(_snapshotFilename, snapshot))
+				LOG("Failed to write boot snapshot " << _snapshotFilename);
+		});
+	}
+
 	float Device::getSamplerate() const
 	{
 		return 88200.0f;
@@ -143,7 +194,7 @@ namespace jeLib
 
 	uint32_t Device::getInternalLatencyMidiToOutput() const
 	{
-		return static_cast<uint32_t>(getSamplerate() * 4.5f / 1000.0f); // 4.5 ms
+		return static_cast<uint32_t>(getSamplerate() * 4.5f / 1000.0f) + m_je8086->getAsicLatency(); // 4.5 ms + ASIC pipeline
 	}
 
 	void Device::readMidiOut(std::vector<synthLib::SMidiEvent>& _midiOut)
@@ -161,11 +212,14 @@ namespace jeLib
 		m_thread->processSamples(static_cast<uint32_t>(_samples), getExtraLatencySamples(), m_midiIn, m_midiOut);
 		m_midiIn.clear();
 
-		auto& sampleBuffer = m_thread->getSampleBuffer();
+		if (m_audioOut.size() < _samples)
+			m_audioOut.resize(_samples);
+
+		m_thread->getSampleBuffer().read(m_audioOut.data(), static_cast<uint32_t>(_samples));
 
 		for (size_t i=0; i<_samples; ++i)
 		{
-			const auto s = sampleBuffer.pop_front();
+			const auto& s = m_audioOut[i];
 
 			_outputs[0][i] = dspWordToFloat(s.first) * m_masterVolume;
 			_outputs[1][i] = dspWordToFloat(s.second) * m_masterVolume;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <thread>
 
 #include "state.h"
 #include "sysexRemoteControl.h"
@@ -18,6 +19,10 @@ namespace jeLib
 	class Device : public synthLib::Device
 	{
 	public:
+		// bits of DeviceCreateParams::customData
+		static constexpr uint32_t CustomDataPipelinedAsics = 1;	// see MultiAsic::setPipelined
+		static constexpr uint32_t CustomDataBackgroundCompile = 2;	// see ESPOptimizer::setBackgroundCompile
+
 		Device(const synthLib::DeviceCreateParams& _params);
 		Device(const Device&) = delete;
 		Device& operator=(const Device&) = delete;
@@ -56,11 +61,16 @@ namespace jeLib
 
 		void createMasterVolumeMessage(std::vector<synthLib::SMidiEvent>& _messages) const;
 
+		void writeSnapshot(const std::string& _snapshotFilename, std::vector<uint8_t>& _snapshot);
+
 		std::unique_ptr<Je8086> m_je8086;
 		std::unique_ptr<JeThread> m_thread;
 
+		std::thread m_snapshotThread;
+
 		std::vector<synthLib::SMidiEvent> m_midiIn;
 		std::vector<synthLib::SMidiEvent> m_midiOut;
+		std::vector<std::pair<int32_t, int32_t>> m_audioOut;	// left, right
 
 		State m_state;
 		SysexRemoteControl m_sysexRemote;
@@ -1,12 +1,32 @@
 #include "je8086.h"
 
+#include <cstring>
+
+#include "baseLib/binarystream.h"
 #include "baseLib/filesystem.h"
 
+#include "synthLib/buildconfig.h"
 #include "synthLib/deviceException.h"
 
 namespace jeLib
 {
-	Je8086::Je8086(const std::vector<uint8_t>& _romData, const std::string& _ramDataFilename)
+	namespace
+	{
+		// uC cycles until the firmware accepts MIDI
+		constexpr uint64_t g_bootCycles = 12776184;
+
+		constexpr uint32_t g_snapshotVersion = 2;
+
+		// emulation changes alter the machine state without necessarily changing the snapshot format
+		const std::string g_buildVersion = SYNTHLIB_BUILD_VERSION;
+
+		constexpr uint32_t g_sramAddr = 0x200000;
+		constexpr uint32_t g_sramSize = 0x40000;
+		constexpr uint32_t g_onChipRamAddr = 0xfffd10;
+		constexpr uint32_t g_onChipRamSize = 0x1000000 - g_onChipRamAddr;	// including registers that are not mapped to devices
+	}
+
+	Je8086::Je8086(const synthLib::RomData& _romData, const std::string& _ramDataFilename)
 	: ports([this](devices::Port* _port) { onLedsChanged(_port); })
 	, midi(0, [this](uint8_t _byte) { onReceiveMidiByte(_byte); })
 	, m_midiOutParser(synthLib::MidiEventSource::Device)
@@ -20,6 +40,10 @@ namespace jeLib
 
 		m_factoryreset = ram.size() != 256 * 1024;
 
+		m_romHash = _romData.getHash();
+		if (!m_factoryreset)
+			m_ramHash = baseLib::MD5(ram);
+
 		emu.loadmem(_romData.data(),(int)_romData.size(), 0);
 
 		if (!m_factoryreset) 
@@ -41,12 +65,17 @@ namespace jeLib
 		emu.memmap(&midi, 0xffffb0, 6);
 		emu.boot();
 
+		emu.addScheduledDevice(&timers);
+
 		if (m_factoryreset)
 		{
 			runfactoryreset(_ramDataFilename); // Run a factory reset if needs be.
+			emu.addScheduledDevice(&midi);
 			return;
 		}
 
+		emu.addScheduledDevice(&midi);
+
 		asics.setPostSample([this](const int32_t _left, const int32_t _right) { onReceiveSample(_left, _right); });
 
 		m_midiInRateLimiter.setSamplerate(88200.0f);
@@ -78,22 +107,199 @@ namespace jeLib
 		}
 	}
 
+	void Je8086::runUntilSamples(const uint32_t _count, SampleFrame* _out)
+	{
+		// samples left over from the previous call, pipelined ASICs produce multiple samples at once
+		const auto carry = std::min<size_t>(_count, m_sampleBuffer.size());
+		std::copy_n(m_sampleBuffer.begin(), carry, _out);
+		m_sampleBuffer.erase(m_sampleBuffer.begin(), m_sampleBuffer.begin() + static_cast<ptrdiff_t>(carry));
+
+		m_sampleOut = _out + carry;
+		m_sampleOutRemaining = _count - static_cast<uint32_t>(carry);
+
+		while (m_sampleOutRemaining)
+			runToNextSample();
+
+		m_sampleOut = nullptr;
+	}
+
 	void Je8086::step()
 	{
-		uint64_t now = emu.getCycles();
+		processMidiIn();
+
+		if (m_tickDevicesPerInstruction)
+			emu.stepTicked();
+		else
+			emu.step();
+
+		asics.runForCycles(emu.getCycles() * 1323 / 625); // Convert from uC cycles to DSP steps. (this is (clockrate / 2) / (uc clock = 16000000), simplified)
+	}
+
+	void Je8086::processMidiIn()
+	{
+		if (!isBooted())
+			return;
 
-		if (now > 12776184)// && !((++ctr) & 0x3fff))
+		if (m_bootSnapshotCallback)
 		{
-			for (auto& m : m_midiInEvents)
-				m_midiInRateLimiter.write(std::move(m));
-			m_midiInEvents.clear();
+			// MIDI that has been sent while booting is still pending, the state is the same for every instance
+			std::vector<uint8_t> snapshot;
+			if (saveSnapshot(snapshot))
+				m_bootSnapshotCallback(snapshot);
+			m_bootSnapshotCallback = nullptr;
 		}
 
-		emu.step();
-		timers.tick();
-		midi.tick();
+		for (auto& m : m_midiInEvents)
+			m_midiInRateLimiter.write(std::move(m));
+		m_midiInEvents.clear();
+	}
 
-		asics.runForCycles(emu.getCycles() * 1323 / 625); // Convert from uC cycles to DSP steps. (this is (clockrate / 2) / (uc clock = 16000000), simplified)
+	void Je8086::runToNextSample()
+	{
+		processMidiIn();
+
+		// The ASICs do not produce anything until the uC reaches the cycle of the next sample, run the uC up to that point
+		// without calling into them. The first uC cycle at which cycles * 1323 / 625 reaches the next sample step:
+		const uint64_t end = (asics.getNextSampleStep() * 625 + 1322) / 1323;
+
+		if (m_tickDevicesPerInstruction)
+			emu.runUntilTicked(end);
+		else
+			emu.runUntil(end);
+
+		asics.runForCycles(emu.getCycles() * 1323 / 625);
+	}
+
+	bool Je8086::isBooted() const
+	{
+		return emu.getCycles() > g_bootCycles;
+	}
+
+	void Je8086::runUntilBooted()
+	{
+		// the firmware does not produce audio while booting, drop it
+		while (!isBooted())
+		{
+			runToNextSample();
+			m_sampleBuffer.clear();
+		}
+	}
+
+	std::string Je8086::getSnapshotFilename(const std::string& _folder, const baseLib::MD5& _romHash)
+	{
+		return _folder + "je8086_" + g_buildVersion + '_' + _romHash.toString() + ".snapshot";
+	}
+
+	bool Je8086::saveSnapshot(std::vector<uint8_t>& _data)
+	{
+		if (m_factoryreset)
+			return false;
+
+		// process pending samples first, their output ends up in the sample buffer
+		asics.flush();
+
+		baseLib::BinaryStream s;
+
+		s.write4CC("JESN");
+		s.write(g_snapshotVersion);
+		s.write(g_buildVersion);
+		s.write(m_romHash);
+		s.write(m_ramHash);
+
+		emu.saveCpuState(s);
+
+		s.write(std::vector<uint8_t>(emu.memory + g_sramAddr, emu.memory + g_sramAddr + g_sramSize));
+		s.write(std::vector<uint8_t>(emu.memory + g_onChipRamAddr, emu.memory + g_onChipRamAddr + g_onChipRamSize));
+
+		timers.saveState(s);
+		midi.saveState(s);
+		hwregs.saveState(s);
+		ports.saveState(s);
+		faders.saveState(s);
+		lcd.saveState(s);
+		asics.saveState(s);
+
+		s.write(static_cast<uint32_t>(m_sampleBuffer.size()));
+		for (const auto& frame : m_sampleBuffer)
+		{
+			s.write(frame.first);
+			s.write(frame.second);
+		}
+
+		s.write4CC("JEND");
+
+		s.toVector(_data);
+		return true;
+	}
+
+	bool Je8086::loadSnapshot(const std::vector<uint8_t>& _data)
+	{
+		// a truncated file is rejected before anything is modified
+		if (m_factoryreset || _data.size() < 8 || memcmp(&_data[_data.size() - 4], "JEND", 4) != 0)
+			return false;
+
+		try
+		{
+			baseLib::BinaryStream s(_data);
+
+			char fourCC[5];
+			s.read4CC(fourCC);
+
+			if (strcmp(fourCC, "JESN") != 0 || s.read<uint32_t>() != g_snapshotVersion)
+				return false;
+
+			if (s.readString() != g_buildVersion)
+				return false;
+
+			if (s.read<baseLib::MD5>() != m_romHash || s.read<baseLib::MD5>() != m_ramHash)
+				return false;
+
+			asics.flush();
+
+			emu.loadCpuState(s);
+
+			std::vector<uint8_t> mem;
+			s.read(mem);
+			if (mem.size() != g_sramSize)
+				return false;
+			emu.loadmem(mem.data(), g_sramSize, g_sramAddr);
+
+			s.read(mem);
+			if (mem.size() != g_onChipRamSize)
+				return false;
+			emu.loadmem(mem.data(), g_onChipRamSize, g_onChipRamAddr);
+
+			// scheduled devices update their deadlines on load and need the cpu state for that
+			timers.loadState(s);
+			midi.loadState(s);
+			emu.updateNextEvent();
+
+			hwregs.loadState(s);
+			ports.loadState(s);
+			faders.loadState(s);
+			lcd.loadState(s);
+			asics.loadState(s);
+
+			const auto sampleCount = s.read<uint32_t>();
+			m_sampleBuffer.clear();
+			m_sampleBuffer.reserve(sampleCount);
+			for (uint32_t i=0; i<sampleCount; ++i)
+			{
+				const auto l = s.read<int32_t>();
+				const auto r = s.read<int32_t>();
+				m_sampleBuffer.emplace_back(l, r);
+			}
+		}
+		catch (std::range_error&)
+		{
+			return false;
+		}
+
+		// let the UI know about the display contents
+		onLcdDdRamChanged();
+		onLcdCgRamChanged();
+
+		return true;
 	}
 
 	void Je8086::setButton(const devices::SwitchType _type, const bool _pressed)
@@ -117,7 +323,16 @@ namespace jeLib
 	void Je8086::onReceiveSample(int32_t _left, int32_t _right)
 	{
 		m_midiInRateLimiter.processSample();
-		m_sampleBuffer.emplace_back(_left, _right);
+
+		if (m_sampleOutRemaining)
+		{
+			*m_sampleOut++ = SampleFrame(_left, _right);
+			--m_sampleOutRemaining;
+		}
+		else
+		{
+			m_sampleBuffer.emplace_back(_left, _right);
+		}
 	}
 
 	void Je8086::onLcdDdRamChanged()
@@ -139,7 +354,6 @@ namespace jeLib
 		while (true)
 		{
 			emu.step();
-			timers.tick();
 
 			if (emu.getCycles() > 112776184 && !((++ctr) & 0x3ffff))
 			{
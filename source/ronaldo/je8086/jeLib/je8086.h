@@ -1,12 +1,18 @@
 #pragma once
 
+#include <functional>
+
 #include <h8s/h8sdevices.hpp>
 
 #include "je8086devices.h"
+
+#include "baseLib/md5.h"
+
 #include "jeLcd.h"
 #include "sysexRemoteControl.h"
 #include "synthLib/midiBufferParser.h"
 #include "synthLib/midiRateLimiter.h"
+#include "synthLib/romData.h"
 
 namespace jeLib
 {
@@ -16,19 +22,47 @@ namespace jeLib
 		using SampleFrame = std::pair<int32_t, int32_t>; // left, right
 		using SampleBuffer = std::vector<SampleFrame>;
 
-		Je8086(const std::vector<uint8_t>& _romData, const std::string& _ramDataFilename);
+		Je8086(const synthLib::RomData& _romData, const std::string& _ramDataFilename);
 		~Je8086() = default;
 
 		void addMidiEvent(const synthLib::SMidiEvent& _event);
 		void readMidiOut(std::vector<synthLib::SMidiEvent>& _events);
 
-		const auto& getSampleBuffer() const { return m_sampleBuffer; }
-		void clearSampleBuffer() { m_sampleBuffer.clear(); }
+		// Runs the emulation until _count stereo frames have been written to _out
+		void runUntilSamples(uint32_t _count, SampleFrame* _out);
 
 		void step();
 
+		// see MultiAsic::setPipelined
+		void setPipelinedAsics(const bool _pipelined) { asics.setPipelined(_pipelined); }
+		uint32_t getAsicLatency() const { return asics.getLatency(); }
+
+		// see ESPOptimizer::setBackgroundCompile
+		void setBackgroundCompile(const bool _enable) { asics.setBackgroundCompile(_enable); }
+		ESPJitStats getJitStats() const { return asics.getJitStats(); }
+
+		// debugging aid: tick the uC devices after every instruction instead of at the cycles of their next events
+		void setTickDevicesPerInstruction(const bool _enable) { m_tickDevicesPerInstruction = _enable; }
+
 		bool hasDoneFactoryReset() const { return m_factoryreset; }
 
+		// the firmware ignores MIDI until it has finished booting
+		bool isBooted() const;
+		void runUntilBooted();
+
+		// A snapshot contains the complete machine state: cpu, SRAM and on-chip RAM, all devices including the ASICs and
+		// the LCD, plus samples that have not been delivered yet. Flash is loaded from the ROM, MIDI that has not reached
+		// the uC is not part of it. A snapshot can only be loaded by an instance that uses the same ROM and RAM image
+		bool saveSnapshot(std::vector<uint8_t>& _data);
+		bool loadSnapshot(const std::vector<uint8_t>& _data);
+
+		// snapshots are specific to the ROM and the emulator build that created them
+		static std::string getSnapshotFilename(const std::string& _folder, const baseLib::MD5& _romHash);
+
+		// called once with a snapshot of the state right after booting, before any MIDI reaches the uC. Runs on the thread
+		// that runs the emulation
+		void setBootSnapshotCallback(const std::function<void(std::vector<uint8_t>&)>& _callback) { m_bootSnapshotCallback = _callback; }
+
 		void setButton(devices::SwitchType _type, bool _pressed);
 
 	private:
@@ -39,6 +73,8 @@ namespace jeLib
 		void onLcdCgRamChanged();
 
 		void runfactoryreset(const std::string& _ramDataFilename);
+		void processMidiIn();
+		void runToNextSample();
 
 		H8SEmulator emu;
 		devices::MultiAsic asics;
@@ -53,11 +89,17 @@ namespace jeLib
 		int ctr {0};
 
 		bool m_factoryreset = false;
+		bool m_tickDevicesPerInstruction = false;
+		baseLib::MD5 m_romHash;
+		baseLib::MD5 m_ramHash;
 
 		synthLib::MidiBufferParser m_midiOutParser;
 		std::vector<synthLib::SMidiEvent> m_midiInEvents;
-		SampleBuffer m_sampleBuffer;
+		SampleBuffer m_sampleBuffer;	// samples that did not fit into the output of runUntilSamples
+		SampleFrame* m_sampleOut = nullptr;
+		uint32_t m_sampleOutRemaining = 0;
 		synthLib::MidiRateLimiter m_midiInRateLimiter;
 		std::vector<synthLib::SMidiEvent> m_midiOutEvents;
+		std::function<void(std::vector<uint8_t>&)> m_bootSnapshotCallback;
 	};
 }
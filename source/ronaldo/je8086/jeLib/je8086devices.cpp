@@ -1,5 +1,318 @@
 #include "je8086devices.h"
 
+#include "baseLib/binarystream.h"
+
+#include "dsp56kBase/threadtools.h"
+
 namespace jeLib
 {
+	namespace devices
+	{
+		namespace
+		{
+			// GRAM locations that are handed from one ASIC to the next one at the end of each sample. The block function of
+			// each ASIC stores its outputs to a frame per sample, the next ASIC loads its inputs from these frames
+			const std::vector<uint8_t> g_gramOut[4] =
+			{
+				{0x80, 0x82, 0x84},
+				{0x80, 0x82, 0x84, 0x86, 0x88, 0x8a},
+				{0x80, 0x82, 0x84, 0x86, 0x88, 0x8a, 0x8c, 0x8e, 0xa0, 0xa2},
+				{0xe8, 0xec}	// audio output
+			};
+
+			const std::vector<uint8_t> g_gramIn[4] =
+			{
+				{},
+				{0x00, 0x02, 0x04},
+				{0x00, 0x02, 0x04, 0x06, 0x08, 0x0a},
+				{0x00, 0x02, 0x04, 0x06, 0x08, 0x0a, 0x0c, 0x0e, 0x20, 0x22}
+			};
+
+			// maximum number of samples per block function call in serial mode
+			constexpr uint32_t g_maxBlockSize = 64;
+
+			// number of samples a pipeline stage processes before handing them to the next stage
+			constexpr uint32_t g_pipelineChunkSize = 4;
+		}
+
+		MultiAsic::MultiAsic()
+		{
+			asic0.opt.setBlockIO(g_gramIn[0], g_gramOut[0]);
+			asic1.opt.setBlockIO(g_gramIn[1], g_gramOut[1]);
+			asic2.opt.setBlockIO(g_gramIn[2], g_gramOut[2]);
+			asic3.opt.setBlockIO(g_gramIn[3], g_gramOut[3]);
+
+			for (size_t i=0; i<stages.size(); ++i)
+				stages[i].frames.resize(g_maxBlockSize * g_gramOut[i].size());
+		}
+
+		MultiAsic::~MultiAsic()
+		{
+			stopThreads();
+		}
+
+		void MultiAsic::setPipelined(const bool _pipelined, const uint32_t _blockSize)
+		{
+			flush();
+
+			blockSize = std::max(1u, _blockSize);
+
+			if (_pipelined == pipelined)
+				return;
+
+			pipelined = _pipelined;
+
+			if (!pipelined)
+			{
+				stopThreads();
+				return;
+			}
+
+			exitThreads = false;
+
+			for (uint32_t i=0; i<stages.size() - 1; ++i)
+				stages[i].thread.reset(new std::thread([this, i] { threadFunc(i); }));
+		}
+
+		void MultiAsic::flush()
+		{
+			const auto count = pendingSamples;
+
+			if (!count)
+				return;
+
+			pendingSamples = 0;
+			blockCount = count;
+
+			for (size_t i=0; i<stages.size(); ++i)
+			{
+				auto& stage = stages[i];
+				if (stage.frames.size() < count * g_gramOut[i].size())
+					stage.frames.resize(count * g_gramOut[i].size());
+				stage.produced.store(0, std::memory_order_relaxed);
+				stage.writeIndex = 0;
+			}
+
+			for (uint32_t i=0; i<stages.size() - 1; ++i)
+				stages[i].start.notify();
+
+			runStage(static_cast<uint32_t>(stages.size() - 1), count);
+
+			for (uint32_t i=0; i<stages.size() - 1; ++i)
+				stages[i].done.wait();
+
+			// writes that arrived after the last pending sample
+			applyWrites(asic0, stages[0], count);
+			applyWrites(asic1, stages[1], count);
+			applyWrites(asic2, stages[2], count);
+			applyWrites(asic3, stages[3], count);
+
+			for (auto& stage : stages)
+				stage.writes.clear();
+		}
+
+		void MultiAsic::setBackgroundCompile(const bool _enable)
+		{
+			flush();
+
+			asic0.opt.setBackgroundCompile(_enable);
+			asic1.opt.setBackgroundCompile(_enable);
+			asic2.opt.setBackgroundCompile(_enable);
+			asic3.opt.setBackgroundCompile(_enable);
+		}
+
+		ESPJitStats MultiAsic::getJitStats() const
+		{
+			ESPJitStats result;
+
+			for (const auto& stats : {asic0.opt.getJitStats(), asic1.opt.getJitStats(), asic2.opt.getJitStats(), asic3.opt.getJitStats()})
+			{
+				result.compileCount += stats.compileCount;
+				result.cacheHits += stats.cacheHits;
+				result.compileMicros += stats.compileMicros;
+				result.lastCompileMicros = std::max(result.lastCompileMicros, stats.lastCompileMicros);
+				result.stallCount += stats.stallCount;
+				result.stallMicros += stats.stallMicros;
+			}
+
+			return result;
+		}
+
+		void MultiAsic::saveState(baseLib::BinaryStream& _s)
+		{
+			flush();
+
+			_s.write(lastCycles);
+			_s.write(cyclesResidual);
+			_s.write(cycles_this_sample);
+
+			asic0.saveState(_s);
+			asic1.saveState(_s);
+			asic2.saveState(_s);
+			asic3.saveState(_s);
+		}
+
+		void MultiAsic::loadState(baseLib::BinaryStream& _s)
+		{
+			flush();
+
+			_s.read(lastCycles);
+			_s.read(cyclesResidual);
+			_s.read(cycles_this_sample);
+
+			asic0.loadState(_s);
+			asic1.loadState(_s);
+			asic2.loadState(_s);
+			asic3.loadState(_s);
+		}
+
+		uint32_t MultiAsic::nextBlockSize() const
+		{
+			// a program that is about to be regenerated needs to be checked every sample
+			if (asic0.opt.isProgramDirty() || asic1.opt.isProgramDirty() || asic2.opt.isProgramDirty() || asic3.opt.isProgramDirty())
+				return 1;
+			return g_maxBlockSize;
+		}
+
+		void MultiAsic::runBlock(const uint32_t _count)
+		{
+			asic0.opt.genProgramIfDirty();
+			asic1.opt.genProgramIfDirty();
+			asic2.opt.genProgramIfDirty();
+			asic3.opt.genProgramIfDirty();
+
+			// each ASIC runs the whole block, then the next one consumes its output frames
+			asic0.opt.runBlock(&asic0, _count, nullptr, stages[0].frames.data());
+			asic1.opt.runBlock(&asic1, _count, stages[0].frames.data(), stages[1].frames.data());
+			asic2.opt.runBlock(&asic2, _count, stages[1].frames.data(), stages[2].frames.data());
+			asic3.opt.runBlock(&asic3, _count, stages[2].frames.data(), stages[3].frames.data());
+
+			// Last DSP audio output
+			const auto* audio = stages[3].frames.data();
+			for (uint32_t i=0; i<_count; ++i, audio += 2)
+				postSample(audio[0], audio[1]);
+		}
+
+		void MultiAsic::threadFunc(const uint32_t _stage)
+		{
+			dsp56k::ThreadTools::setCurrentThreadName("JE8086 ASIC " + std::to_string(_stage));
+			dsp56k::ThreadTools::setCurrentThreadPriority(dsp56k::ThreadPriority::Highest);
+
+			auto& stage = stages[_stage];
+
+			while (true)
+			{
+				stage.start.wait();
+
+				if (exitThreads)
+					break;
+
+				runStage(_stage, blockCount);
+
+				stage.done.notify();
+			}
+		}
+
+		void MultiAsic::runStage(const uint32_t _stage, const uint32_t _count)
+		{
+			switch (_stage)
+			{
+			case 0:		runStage(asic0, 0, _count); break;
+			case 1:		runStage(asic1, 1, _count); break;
+			case 2:		runStage(asic2, 2, _count); break;
+			default:	runStage(asic3, 3, _count); break;
+			}
+		}
+
+		template<int lg2eram_size> void MultiAsic::runStage(ESP<lg2eram_size>& _asic, const uint32_t _stage, const uint32_t _count)
+		{
+			auto& stage = stages[_stage];
+			auto* prev = _stage > 0 ? &stages[_stage - 1] : nullptr;
+			const auto isLast = _stage == stages.size() - 1;
+
+			const auto inStride = prev ? g_gramOut[_stage - 1].size() : 0;
+			const auto outStride = g_gramOut[_stage].size();
+
+			uint32_t i = 0;
+
+			while (i < _count)
+			{
+				applyWrites(_asic, stage, i);
+
+				// run up to the next queued uC write, but not more than a chunk to keep the next stage busy
+				auto end = std::min(_count, i + g_pipelineChunkSize);
+				if (stage.writeIndex < stage.writes.size())
+					end = std::min(end, stage.writes[stage.writeIndex].sample);
+				if (_asic.opt.isProgramDirty())
+					end = i + 1;
+
+				_asic.opt.genProgramIfDirty();
+
+				if (prev)
+				{
+					// DSP->DSP communication, wait for the previous ASIC to finish these samples
+					prev->waitProduced(end);
+				}
+
+				const int32_t* in = prev ? prev->frames.data() + i * inStride : nullptr;
+				int32_t* out = stage.frames.data() + i * outStride;
+
+				_asic.opt.runBlock(&_asic, end - i, in, out);
+
+				if (isLast)
+				{
+					// Last DSP audio output
+					for (; i < end; ++i, out += 2)
+						postSample(out[0], out[1]);
+				}
+				else
+				{
+					stage.setProduced(end);
+					i = end;
+				}
+			}
+		}
+
+		template<int lg2eram_size> void MultiAsic::applyWrites(ESP<lg2eram_size>& _asic, Stage& _stage, const uint32_t _sample)
+		{
+			while (_stage.writeIndex < _stage.writes.size() && _stage.writes[_stage.writeIndex].sample <= _sample)
+			{
+				const auto& w = _stage.writes[_stage.writeIndex++];
+				_asic.writeuC(w.address, w.value);
+			}
+		}
+
+		void MultiAsic::Stage::setProduced(const uint32_t _count)
+		{
+			{
+				std::lock_guard lock(producedMutex);
+				produced.store(_count, std::memory_order_release);
+			}
+			producedCv.notify_one();
+		}
+
+		void MultiAsic::Stage::waitProduced(const uint32_t _count)
+		{
+			if (produced.load(std::memory_order_acquire) >= _count)
+				return;
+
+			std::unique_lock lock(producedMutex);
+			producedCv.wait(lock, [&] { return produced.load(std::memory_order_acquire) >= _count; });
+		}
+
+		void MultiAsic::stopThreads()
+		{
+			exitThreads = true;
+
+			for (uint32_t i=0; i<stages.size() - 1; ++i)
+			{
+				auto& stage = stages[i];
+				if (!stage.thread)
+					continue;
+				stage.start.notify();
+				stage.thread->join();
+				stage.thread.reset();
+			}
+		}
+	}
 }
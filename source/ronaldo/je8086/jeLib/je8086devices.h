@@ -1,8 +1,23 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include <h8s/h8s.hpp>
 
+#include "baseLib/semaphore.h"
+
+namespace baseLib
+{
+	class BinaryStream;
+}
+
 #include "esp/esp.hpp"
 
 namespace jeLib
@@ -111,9 +126,32 @@ namespace jeLib
 		class MultiAsic : public H8SDevice
 		{
 		public:
+			MultiAsic();
+			MultiAsic(const MultiAsic&) = delete;
+			MultiAsic(MultiAsic&&) = delete;
+			~MultiAsic() override;
+
+			MultiAsic& operator = (const MultiAsic&) = delete;
+			MultiAsic& operator = (MultiAsic&&) = delete;
+
 			void setPostSample(const std::function<void(int32_t, int32_t)>& _postSample) { postSample = _postSample; }
 
+			// In pipelined mode, samples are not calculated immediately but deferred and then processed in blocks, with each
+			// ASIC running on its own thread a few samples behind its predecessor. uC writes are queued and applied at their sample
+			// position and uC reads flush the pipeline, the result is identical to the serial mode. The audio output is delayed
+			// by up to getLatency() samples relative to the uC
+			void setPipelined(bool _pipelined, uint32_t _blockSize = 32);
+			bool isPipelined() const { return pipelined; }
+			uint32_t getLatency() const { return pipelined ? blockSize : 0; }
+
+			void flush();
+
+			// see ESPOptimizer::setBackgroundCompile
+			void setBackgroundCompile(bool _enable);
+			ESPJitStats getJitStats() const;
+
 			void dump() {
+				flush();
 				asic0.dump("dumps/asic0.bin", "dumps/asic0.txt");
 				asic1.dump("dumps/asic1.bin", "dumps/asic1.txt");
 				asic2.dump("dumps/asic2.bin", "dumps/asic2.txt");
@@ -122,6 +160,7 @@ namespace jeLib
 
 			uint8_t read(uint32_t _address) override
 			{
+				if (pendingSamples) flush();
 				const int asic = (_address >> 14) & 3; _address &= 0x3fff;
 				if (asic == 0) return asic0.readuC(_address);
 				if (asic == 1) return asic1.readuC(_address);
@@ -132,7 +171,8 @@ namespace jeLib
 			void write(uint32_t _address, uint8_t _value) override
 			{
 				const int asic = (_address >> 14) & 3; _address &= 0x3fff;
-				if (asic == 0) asic0.writeuC(_address, _value);
+				if (pendingSamples) stages[asic].writes.push_back({pendingSamples, static_cast<uint16_t>(_address), _value});
+				else if (asic == 0) asic0.writeuC(_address, _value);
 				else if (asic == 1) asic1.writeuC(_address, _value);
 				else if (asic == 2) asic2.writeuC(_address, _value);
 				else asic3.writeuC(_address, _value);
@@ -145,42 +185,63 @@ namespace jeLib
 				uint64_t samples = diff / (768/2);
 				cyclesResidual = diff % (768/2);
 
-				for (int i = 0; i < samples; i++) {
-					// Intepreter version
-					// for (size_t j = 0; j < (768/2); j++) asic0.step_cores();
-					// for (size_t j = 0; j < (768/2); j++) asic1.step_cores();
-					// for (size_t j = 0; j < (768/2); j++) asic2.step_cores();
-					// for (size_t j = 0; j < (768/2); j++) asic3.step_cores();
-
-					// JIT version
-					asic0.opt.genProgramIfDirty();
-					asic1.opt.genProgramIfDirty();
-					asic2.opt.genProgramIfDirty();
-					asic3.opt.genProgramIfDirty();
-
-					asic0.opt.callOptimized(&asic0);
-					asic1.opt.callOptimized(&asic1);
-					asic2.opt.callOptimized(&asic2);
-					asic3.opt.callOptimized(&asic3);
-
-					// Last DSP audio output
-					postSample(asic3.readGRAM(0xe8), asic3.readGRAM(0xec));
-					
-					// DSP->DSP communication
-					for (int k = 0; k <= 0x4; k += 2) asic1.writeGRAM(asic0.readGRAM(0x80 + k), k);
-					for (int k = 0; k <= 0xa; k += 2) asic2.writeGRAM(asic1.readGRAM(0x80 + k), k);
-					for (int k = 0; k <= 0xe; k += 2) asic3.writeGRAM(asic2.readGRAM(0x80 + k), k);
-					asic3.writeGRAM(asic2.readGRAM(0xa0), 0x20);
-					asic3.writeGRAM(asic2.readGRAM(0xa2), 0x22);
-
-					// Advance PCs
-					asic0.sync_cores();
-					asic1.sync_cores();
-					asic2.sync_cores();
-					asic3.sync_cores();
+				if (pipelined)
+				{
+					pendingSamples += static_cast<uint32_t>(samples);
+					if (pendingSamples >= blockSize) flush();
+					return;
+				}
+
+				// Intepreter version
+				// for (int i = 0; i < samples; i++) {
+				// 	for (size_t j = 0; j < (768/2); j++) asic0.step_cores();
+				// 	for (size_t j = 0; j < (768/2); j++) asic1.step_cores();
+				// 	for (size_t j = 0; j < (768/2); j++) asic2.step_cores();
+				// 	for (size_t j = 0; j < (768/2); j++) asic3.step_cores();
+				// }
+
+				// JIT version
+				while (samples)
+				{
+					const auto count = static_cast<uint32_t>(std::min<uint64_t>(samples, nextBlockSize()));
+					runBlock(count);
+					samples -= count;
 				}
 			}
+
+			// DSP step count at which runForCycles() produces the next sample. Calls with smaller values only advance the residual
+			uint64_t getNextSampleStep() const { return lastCycles - cyclesResidual + stepsPerFS; }
+
+			// pending samples are processed first, their output is delivered via postSample as usual
+			void saveState(baseLib::BinaryStream& _s);
+			void loadState(baseLib::BinaryStream& _s);
 		protected:
+			struct PendingWrite { uint32_t sample; uint16_t address; uint8_t value; };
+
+			struct Stage
+			{
+				std::vector<int32_t> frames;				// GRAM output of this stage, one frame per sample of the current block
+				std::atomic<uint32_t> produced {0};			// number of valid frames
+				std::mutex producedMutex;
+				std::condition_variable producedCv;
+				std::vector<PendingWrite> writes;			// uC writes, sorted by sample position
+				size_t writeIndex = 0;
+				baseLib::Semaphore start;
+				baseLib::Semaphore done;
+				std::unique_ptr<std::thread> thread;
+
+				void setProduced(uint32_t _count);
+				void waitProduced(uint32_t _count);
+			};
+
+			uint32_t nextBlockSize() const;
+			void runBlock(uint32_t _count);
+			void threadFunc(uint32_t _stage);
+			void runStage(uint32_t _stage, uint32_t _count);
+			template<int lg2eram_size> void runStage(ESP<lg2eram_size>& _asic, uint32_t _stage, uint32_t _count);
+			template<int lg2eram_size> static void applyWrites(ESP<lg2eram_size>& _asic, Stage& _stage, uint32_t _sample);
+			void stopThreads();
+
 			ESP<17> asic0;
 			ESP<0> asic1, asic2;
 			ESP<19> asic3; // should really be 18, but it works only with 19
@@ -188,6 +249,13 @@ namespace jeLib
 			std::function<void(int32_t, int32_t)> postSample;
 			uint64_t lastCycles = 0, cyclesResidual = 0;
 			uint32_t cycles_this_sample {0};
+
+			bool pipelined = false;
+			bool exitThreads = false;
+			uint32_t blockSize = 32;
+			uint32_t pendingSamples = 0;
+			uint32_t blockCount = 0;
+			std::array<Stage, 4> stages;	// the last stage runs on the calling thread
 		};
 
 		class Port : public H8SDevice
@@ -250,6 +318,15 @@ namespace jeLib
 			static int getLedId(const uint32_t _index) {return lits[_index];}
 
 			bool getLed(const uint32_t _i) const { const int w = getLedId(_i); return (leds[w >> 3] & (1 << (w & 7))); }
+
+			template<typename TStream> void saveState(TStream& _s) const
+			{
+				_s.write(data); _s.write(leds); _s.write(latch); _s.write(latchA); _s.write(portAstate); _s.write(portBDDR); _s.write(portBDR);
+			}
+			template<typename TStream> void loadState(TStream& _s)
+			{
+				_s.read(data); _s.read(leds); _s.read(latch); _s.read(latchA); _s.read(portAstate); _s.read(portBDDR); _s.read(portBDR);
+			}
 		protected:
 			static int lits[];
 			static const char* const litnames[66];
@@ -302,6 +379,8 @@ namespace jeLib
 				// e.g. cutoff = VR12, so n = 12 + 15 = 27. See datasheet.
 				values[which] = value;
 			}
+			template<typename TStream> void saveState(TStream& _s) const { _s.write(scanning); _s.write(p6dr); _s.write(adcsr); _s.write(values); }
+			template<typename TStream> void loadState(TStream& _s) { _s.read(scanning); _s.read(p6dr); _s.read(adcsr); _s.read(values); }
 		protected:
 			int8 scanning {0}, p6dr {0}, adcsr {0};
 			int values[64] {};
@@ -6,6 +6,12 @@
 
 namespace jeLib
 {
+	namespace
+	{
+		// maximum number of samples that are calculated without checking for MIDI input or output
+		constexpr uint32_t g_maxBatchSize = 64;
+	}
+
 	JeThread::JeThread(Je8086& _je8086) : m_je8086(_je8086)
 	{
 		m_thread.reset(new std::thread([this]() { threadFunc(); }));
@@ -115,8 +121,13 @@ namespace jeLib
 			_job.midiEvents.clear();
 		}
 
-		for (uint32_t i=0; i<_job.samplesToProcess; ++i)
+		uint32_t remaining = _job.samplesToProcess;
+
+		while (remaining)
 		{
+			// run in one go up to the next MIDI event or the end of the job
+			auto count = std::min(remaining, g_maxBatchSize);
+
 			for(auto it = m_tempMidiIn.begin(); it != m_tempMidiIn.end();)
 			{
 				auto& e = *it;
@@ -128,17 +139,23 @@ namespace jeLib
 				}
 				else
 				{
+					count = static_cast<uint32_t>(std::min<uint64_t>(count, e.first - m_processedSampleOffset));
 					++it;
 				}
 			}
 
-			while (m_je8086.getSampleBuffer().empty())
-				m_je8086.step();
-
-			m_audioOut.push_back(m_je8086.getSampleBuffer().front());
-			m_je8086.clearSampleBuffer();
+			// render straight into the output buffer, in two parts if the batch wraps around its end
+			for (uint32_t done = 0; done < count;)
+			{
+				auto n = count - done;
+				auto* out = m_audioOut.beginWrite(n);
+				m_je8086.runUntilSamples(n, out);
+				m_audioOut.endWrite(n);
+				done += n;
+			}
 
-			++m_processedSampleOffset;
+			m_processedSampleOffset += count;
+			remaining -= count;
 
 			m_je8086.readMidiOut(m_tempMidiOut);
 
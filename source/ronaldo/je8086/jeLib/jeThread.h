@@ -4,6 +4,8 @@
 
 #include "baseLib/semaphore.h"
 
+#include "sampleRingBuffer.h"
+
 #include "dsp56kBase/ringbuffer.h"
 
 #include "synthLib/midiTypes.h"
@@ -43,7 +45,7 @@ namespace jeLib
 
 		uint32_t m_currentLatency = 0;
 
-		dsp56k::RingBuffer<SampleFrame, 16384, true> m_audioOut;
+		SampleRingBuffer<SampleFrame, 16384> m_audioOut;
 
 		std::vector<synthLib::SMidiEvent> m_midiOutput;
 
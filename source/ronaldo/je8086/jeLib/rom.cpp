@@ -21,15 +21,15 @@ namespace jeLib
 
 	Rom::Rom(const std::string& _filename)
 	{
-		baseLib::filesystem::readFile(m_data, _filename);
+		m_data.loadFromFile(_filename);
 		m_name = baseLib::filesystem::getFilenameWithoutPath(_filename);
 
 		validate();
 	}
 
-	Rom::Rom(const std::vector<uint8_t>& _data, const std::string& _name)
+	Rom::Rom(synthLib::RomData _data, const std::string& _name)
 	{
-		m_data = _data;
+		m_data = std::move(_data);
 		m_name = _name;
 
 		validate();
@@ -126,7 +126,7 @@ namespace jeLib
 
 		for (size_t i = 0; i < m_data.size() - keySize; ++i)
 		{
-			if (std::equal(_key, _key + keySize, &m_data[i]))
+			if (std::equal(_key, _key + keySize, m_data.data() + i))
 				return i;
 		}
 		return 0;
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace jeLib
+{
+	// Single producer, single consumer ring buffer for stereo frames. The producer renders directly into the free space
+	// and both sides transfer whole blocks, the lock is taken once per block instead of once per frame
+	template<typename T, uint32_t C>
+	class SampleRingBuffer
+	{
+	public:
+		static constexpr uint32_t Capacity = C;
+
+		// Blocks until there is free space and returns a contiguous region of up to _count frames. _count is set to the
+		// size of that region, which may be smaller because of the wrap-around
+		T* beginWrite(uint32_t& _count)
+		{
+			std::unique_lock lock(m_mutex);
+
+			m_cv.wait(lock, [this] { return m_writePos - m_readPos < C; });
+
+			const auto offset = static_cast<uint32_t>(m_writePos % C);
+			const auto free = static_cast<uint32_t>(C - (m_writePos - m_readPos));
+
+			_count = std::min({_count, free, C - offset});
+
+			return &m_data[offset];
+		}
+
+		// makes the first _count frames of the region returned by beginWrite available to the consumer
+		void endWrite(const uint32_t _count)
+		{
+			{
+				std::scoped_lock lock(m_mutex);
+				m_writePos += _count;
+			}
+			m_cv.notify_all();
+		}
+
+		// blocks until _count frames have been read
+		void read(T* _out, uint32_t _count)
+		{
+			while (_count)
+			{
+				std::unique_lock lock(m_mutex);
+
+				m_cv.wait(lock, [this] { return m_writePos > m_readPos; });
+
+				const auto offset = static_cast<uint32_t>(m_readPos % C);
+				const auto count = std::min({_count, static_cast<uint32_t>(m_writePos - m_readPos), C - offset});
+
+				std::copy_n(&m_data[offset], count, _out);
+
+				m_readPos += count;
+				_out += count;
+				_count -= count;
+
+				lock.unlock();
+				m_cv.notify_all();
+			}
+		}
+
+	private:
+		std::array<T, C> m_data;
+
+		// total number of frames written and read, the difference is the fill level
+		uint64_t m_writePos = 0;
+		uint64_t m_readPos = 0;
+
+		std::mutex m_mutex;
+		std::condition_variable m_cv;
+	};
+}
@@ -1,5 +1,6 @@
 #include "state.h"
 
+#include <algorithm>
 #include <cassert>
 
 #include "jemiditypes.h"
@@ -506,19 +507,21 @@ namespace jeLib
 
 		constexpr auto firstDataOffset = std::size(g_sysexHeader) + 1 + std::tuple_size_v<decltype(addr4)>;
 
-		std::vector<uint8_t> dataToWrite;
+		if (_sysex.size() < firstDataOffset + 2 /*checksum + eox*/)
+			return false;
 
-		dataToWrite.insert(dataToWrite.end(), _sysex.begin() + firstDataOffset, _sysex.end() - 2 /*checksum + eox*/);
+		const auto* data = _sysex.data() + firstDataOffset;
+		const auto size = _sysex.size() - firstDataOffset - 2;
 
 		if (area == AddressArea::System)
 		{
-			m_system.write(addr4, dataToWrite);
+			m_system.write(addr4, data, size);
 			return true;
 		}
 
 		if (area == AddressArea::PerformanceTemp)
 		{
-			m_tempPerformance.write(addr4, dataToWrite);
+			m_tempPerformance.write(addr4, data, size);
 			return true;
 		}
 
@@ -539,6 +542,36 @@ namespace jeLib
 	}
 
 	bool State::createTempPerformanceDumps(std::vector<synthLib::SMidiEvent>& _results, const PerformanceData _data, const uint32_t _sizeRack, const uint32_t _sizeKeyboard) const
+	{
+		const auto addr4 = toAddress(static_cast<uint32_t>(AddressArea::PerformanceTemp) | static_cast<uint32_t>(_data));
+
+		// a section is contiguous even if it is split into two dumps. Sections start at block boundaries, so limiting
+		// the range to the section size keeps clearDirty() away from the blocks of the next one
+		const auto size = std::max(_sizeRack, _sizeKeyboard);
+
+		auto& cache = m_tempPerformanceDumps[_data];
+
+		if (!cache.empty() && !m_tempPerformance.isDirty(addr4, size))
+		{
+			_results.insert(_results.end(), cache.begin(), cache.end());
+			return true;
+		}
+
+		const auto first = _results.size();
+
+		if (!serializeTempPerformanceDumps(_results, _data, _sizeRack, _sizeKeyboard))
+		{
+			cache.clear();
+			return false;
+		}
+
+		cache.assign(_results.begin() + static_cast<std::ptrdiff_t>(first), _results.end());
+		m_tempPerformance.clearDirty(addr4, size);
+
+		return true;
+	}
+
+	bool State::serializeTempPerformanceDumps(std::vector<synthLib::SMidiEvent>& _results, const PerformanceData _data, const uint32_t _sizeRack, const uint32_t _sizeKeyboard) const
 	{
 		auto addr = static_cast<uint32_t>(AddressArea::PerformanceTemp) | static_cast<uint32_t>(_data);
 		auto addr4 = toAddress(addr);
@@ -573,7 +606,7 @@ namespace jeLib
 
 			size = std::max(_sizeRack, _sizeKeyboard) - sizeLimit;
 
-			numRead = m_tempPerformance.read(event.sysex, addr4, std::max(_sizeRack, _sizeKeyboard));
+			numRead = m_tempPerformance.read(event.sysex, addr4, size);
 
 			if (!numRead)
 				return true;
@@ -82,8 +82,13 @@ namespace jeLib
 		bool createTempPerformanceDumps(std::vector<synthLib::SMidiEvent>& _results, PerformanceData _data) const;
 
 	private:
+		bool serializeTempPerformanceDumps(std::vector<synthLib::SMidiEvent>& _results, PerformanceData _data, uint32_t _sizeRack, uint32_t _sizeKeyboard) const;
+
 		rLib::Storage m_tempPerformance;
 		rLib::Storage m_system;
 		std::map<uint32_t, Dump> m_stateDumps;
+
+		// serialized temp performance dumps, reused as long as the underlying storage blocks are not dirty
+		mutable std::map<PerformanceData, std::vector<synthLib::SMidiEvent>> m_tempPerformanceDumps;
 	};
 }
@@ -0,0 +1,274 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include "jeLib/je8086.h"
+#include "jeLib/romloader.h"
+#include "jeLib/state.h"
+
+#include "baseLib/filesystem.h"
+
+using namespace jeLib;
+
+// Custom assertion that works in both Debug and Release builds
+#define TEST_ASSERT(condition) \
+	do { \
+		if (!(condition)) { \
+			std::ostringstream oss; \
+			oss << "Test assertion failed: " << #condition \
+			    << " at " << __FILE__ << ":" << __LINE__; \
+			throw std::runtime_error(oss.str()); \
+		} \
+	} while (0)
+
+namespace
+{
+	constexpr int g_returnCodeSkipped = 77;
+
+	const std::string g_ramDataFilename = "je8086Test_ram.bin";
+
+	// header, command and four address bytes
+	constexpr uint32_t g_dumpDataOffset = 10;
+
+	// two instances only behave identically if they start from the same RAM image. The first instance that does not
+	// find one runs a factory reset, which writes it
+	void prepareRam(const Rom& _rom)
+	{
+		Je8086 je(_rom.getData(), g_ramDataFilename);
+	}
+
+	void sendNote(Je8086& _je, const uint8_t _note, const bool _on)
+	{
+		_je.addMidiEvent(synthLib::SMidiEvent(synthLib::MidiEventSource::Host, _on ? synthLib::M_NOTEON : synthLib::M_NOTEOFF, _note, _on ? 100 : 0));
+	}
+
+	// sends a full temp performance section to the state, split into dumps of at most DataLengthLimitPerDump bytes
+	void sendSection(State& _state, const PerformanceData _data, const uint32_t _size, const uint8_t _value)
+	{
+		constexpr auto sizeLimit = static_cast<uint32_t>(Patch::DataLengthLimitPerDump);
+
+		for (uint32_t offset = 0; offset < _size; offset += sizeLimit)
+		{
+			// addresses use 7 bits per byte
+			const auto addr = static_cast<uint32_t>(AddressArea::PerformanceTemp) | static_cast<uint32_t>(_data) | ((offset >> 7) << 8) | (offset & 0x7f);
+
+			auto dump = State::createHeader(SysexByte::CommandIdDataSet1, SysexByte::DeviceIdDefault, State::toAddress(addr));
+			dump.insert(dump.end(), std::min(sizeLimit, _size - offset), _value);
+			TEST_ASSERT(_state.receive(State::createFooter(dump)));
+		}
+	}
+
+	// returns the data byte at _offset of the first dump of a section
+	uint8_t getDumpValue(const State& _state, const PerformanceData _data, const uint32_t _offset)
+	{
+		std::vector<synthLib::SMidiEvent> dumps;
+		TEST_ASSERT(_state.createTempPerformanceDumps(dumps, _data));
+		TEST_ASSERT(!dumps.empty());
+
+		const auto& sysex = dumps.front().sysex;
+		TEST_ASSERT(sysex.size() > g_dumpDataOffset + _offset + 2);
+		return sysex[g_dumpDataOffset + _offset];
+	}
+}
+
+namespace
+{
+	// Runs both instances for a few seconds while playing notes and expects identical output. The block sizes are used
+	// in turn. Returns the time spent in each of them
+	std::pair<double, double> runAndCompare(Je8086& _a, Je8086& _b, const std::vector<uint32_t>& _blockSizes = {256})
+	{
+		constexpr uint32_t totalSamples = 88200 * 4;
+		constexpr uint32_t noteInterval = 4096;
+
+		const auto maxBlockSize = *std::max_element(_blockSizes.begin(), _blockSizes.end());
+
+		std::vector<Je8086::SampleFrame> outA(maxBlockSize);
+		std::vector<Je8086::SampleFrame> outB(maxBlockSize);
+
+		std::chrono::duration<double> timeA{0};
+		std::chrono::duration<double> timeB{0};
+
+		uint64_t sampleCount = 0;
+		uint64_t nextNote = 0;
+
+		for (size_t b=0; sampleCount < totalSamples; ++b)
+		{
+			// notes make the uC write to the ASICs while they run
+			if (sampleCount >= nextNote)
+			{
+				const auto index = nextNote / noteInterval;
+				const auto note = static_cast<uint8_t>(48 + (index >> 1) % 24);
+				const auto on = (index & 1) == 0;
+				sendNote(_a, note, on);
+				sendNote(_b, note, on);
+				nextNote += noteInterval;
+			}
+
+			const auto blockSize = _blockSizes[b % _blockSizes.size()];
+
+			const auto t0 = std::chrono::steady_clock::now();
+			_a.runUntilSamples(blockSize, outA.data());
+			const auto t1 = std::chrono::steady_clock::now();
+			_b.runUntilSamples(blockSize, outB.data());
+			const auto t2 = std::chrono::steady_clock::now();
+
+			timeA += t1 - t0;
+			timeB += t2 - t1;
+
+			for (uint32_t i=0; i<blockSize; ++i, ++sampleCount)
+			{
+				if (outA[i] == outB[i])
+					continue;
+
+				std::ostringstream ss;
+				ss << "Output differs at sample " << sampleCount << ": " << outA[i].first << '/' << outA[i].second
+					<< " vs " << outB[i].first << '/' << outB[i].second;
+				throw std::runtime_error(ss.str());
+			}
+		}
+
+		std::cout << "  " << sampleCount << " samples identical" << std::endl;
+
+		return {timeA.count(), timeB.count()};
+	}
+}
+
+void testPipelinedAsics(const Rom& _rom)
+{
+	std::cout << "Testing pipelined ASICs against serial mode..." << std::endl;
+
+	Je8086 serial(_rom.getData(), g_ramDataFilename);
+	Je8086 pipelined(_rom.getData(), g_ramDataFilename);
+
+	TEST_ASSERT(!serial.hasDoneFactoryReset() && !pipelined.hasDoneFactoryReset());
+
+	// program generation on a background thread depends on thread timing
+	serial.setBackgroundCompile(false);
+	pipelined.setBackgroundCompile(false);
+
+	serial.runUntilBooted();
+	pipelined.runUntilBooted();
+
+	// enabled after booting, runUntilBooted() drops the audio of the boot phase
+	pipelined.setPipelinedAsics(true);
+
+	runAndCompare(serial, pipelined);
+
+	std::cout << "  Pipelined ASIC tests passed!" << std::endl;
+}
+
+void testPipelinedAsicsUnalignedBlocks(const Rom& _rom)
+{
+	std::cout << "Testing pipelined ASICs with block sizes that are not a multiple of the pipeline block..." << std::endl;
+
+	Je8086 serial(_rom.getData(), g_ramDataFilename);
+	Je8086 pipelined(_rom.getData(), g_ramDataFilename);
+
+	TEST_ASSERT(!serial.hasDoneFactoryReset() && !pipelined.hasDoneFactoryReset());
+
+	serial.setBackgroundCompile(false);
+	pipelined.setBackgroundCompile(false);
+
+	serial.runUntilBooted();
+	pipelined.runUntilBooted();
+
+	pipelined.setPipelinedAsics(true);
+
+	// samples that the pipeline produced beyond the requested count are carried over to the next call
+	runAndCompare(serial, pipelined, {1, 31, 33, 127, 2, 64, 255});
+
+	std::cout << "  Unaligned block tests passed!" << std::endl;
+}
+
+void testScheduledDevices(const Rom& _rom)
+{
+	std::cout << "Testing scheduled uC devices against ticking them after every instruction..." << std::endl;
+
+	Je8086 ticked(_rom.getData(), g_ramDataFilename);
+	Je8086 scheduled(_rom.getData(), g_ramDataFilename);
+
+	TEST_ASSERT(!ticked.hasDoneFactoryReset() && !scheduled.hasDoneFactoryReset());
+
+	ticked.setBackgroundCompile(false);
+	scheduled.setBackgroundCompile(false);
+
+	// the boot phase is included, it is where most of the timer and serial setup happens
+	ticked.setTickDevicesPerInstruction(true);
+
+	ticked.runUntilBooted();
+	scheduled.runUntilBooted();
+
+	const auto [timeTicked, timeScheduled] = runAndCompare(ticked, scheduled);
+
+	std::cout << "  Ticked: " << timeTicked << "s, scheduled: " << timeScheduled << "s" << std::endl;
+	std::cout << "  Scheduled device tests passed!" << std::endl;
+}
+
+void testTempPerformanceDumpCache()
+{
+	std::cout << "Testing temp performance dump cache..." << std::endl;
+
+	constexpr auto patchSize = static_cast<uint32_t>(Patch::DataLengthRack);
+
+	State state;
+
+	sendSection(state, PerformanceData::PerformanceCommon, static_cast<uint32_t>(PerformanceCommon::DataLengthRack), 0);
+	sendSection(state, PerformanceData::PatchUpper, patchSize, 1);
+	sendSection(state, PerformanceData::PatchLower, patchSize, 1);
+
+	// a rack patch does not fit into a single dump
+	std::vector<synthLib::SMidiEvent> dumps;
+	TEST_ASSERT(state.createTempPerformanceDumps(dumps, PerformanceData::PatchLower));
+	TEST_ASSERT(dumps.size() == 2);
+	TEST_ASSERT(dumps[1].sysex.size() == g_dumpDataOffset + patchSize - static_cast<uint32_t>(Patch::DataLengthLimitPerDump) + 2);
+
+	TEST_ASSERT(getDumpValue(state, PerformanceData::PatchUpper, 0) == 1);
+	TEST_ASSERT(getDumpValue(state, PerformanceData::PatchLower, 0) == 1);
+
+	// a parameter change of the lower patch must not be hidden by dumping the upper patch first
+	TEST_ASSERT(state.receive(State::createParameterChange(PerformanceData::PatchLower, Patch::PatchName1, 0x41)));
+
+	TEST_ASSERT(getDumpValue(state, PerformanceData::PatchUpper, 0) == 1);
+	TEST_ASSERT(getDumpValue(state, PerformanceData::PatchLower, 0) == 0x41);
+
+	// and vice versa
+	TEST_ASSERT(state.receive(State::createParameterChange(PerformanceData::PatchUpper, Patch::PatchName1, 0x42)));
+
+	TEST_ASSERT(getDumpValue(state, PerformanceData::PatchLower, 0) == 0x41);
+	TEST_ASSERT(getDumpValue(state, PerformanceData::PatchUpper, 0) == 0x42);
+
+	std::cout << "  Temp performance dump cache tests passed!" << std::endl;
+}
+
+int main()
+{
+	try
+	{
+		testTempPerformanceDumpCache();
+
+		const auto rom = RomLoader::findROM();
+
+		if (!rom.isValid())
+		{
+			std::cout << "No ROM found, skipping tests that require a ROM" << std::endl;
+			return g_returnCodeSkipped;
+		}
+
+		prepareRam(rom);
+
+		testPipelinedAsics(rom);
+		testPipelinedAsicsUnalignedBlocks(rom);
+		testScheduledDevices(rom);
+
+		std::cout << "All tests passed!" << std::endl;
+		return 0;
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "Test failed: " << e.what() << std::endl;
+		return 1;
+	}
+}
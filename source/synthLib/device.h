@@ -10,6 +10,7 @@
 #include "midiTypes.h"
 #include "buildconfig.h"
 #include "midiTranslator.h"
+#include "romData.h"
 
 #include "baseLib/compilerdefs.h"
 #include "baseLib/md5.h"
@@ -21,7 +22,7 @@ namespace synthLib
 		float preferredSamplerate = 0.0f;
 		float hostSamplerate = 0.0f;
 		std::string romName;
-		std::vector<uint8_t> romData;
+		RomData romData;
 		baseLib::MD5 romHash;
 		uint32_t customData = 0;
 		std::string homePath;
@@ -146,7 +146,19 @@
 #include "mameResamplers.h"
 
 #include <algorithm>
+#include <cassert>
 #include <cmath>
+#include <cstring>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#   define HAVE_SSE 1
+#   include <xmmintrin.h>
+#elif defined(__aarch64__) || defined(__ARM_ARCH_8) || defined(_M_ARM64)
+#   define HAVE_SSE 1
+#   include "baseLib/sse2neon.h"
+#else
+#   define HAVE_SSE 0
+#endif
 
 namespace synthLib
 {
@@ -154,16 +166,98 @@ namespace synthLib
     {
         constexpr double kPi = 3.14159265358979323846;
 
-        static float sample_at(const std::deque<float>& src, const int64_t srcBase, const int64_t index)
+        float dotProduct(const float* a, const float* b, const uint32_t count)
         {
-            if (index < srcBase)
-                return 0.0f;
+            uint32_t i = 0;
+            float result = 0.0f;
+#if HAVE_SSE
+            __m128 acc0 = _mm_setzero_ps();
+            __m128 acc1 = _mm_setzero_ps();
+            for (; i + 8 <= count; i += 8)
+            {
+                acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+                acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+            }
+            for (; i + 4 <= count; i += 4)
+                acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+
+            acc0 = _mm_add_ps(acc0, acc1);
+            acc0 = _mm_add_ps(acc0, _mm_movehl_ps(acc0, acc0));
+            acc0 = _mm_add_ss(acc0, _mm_shuffle_ps(acc0, acc0, _MM_SHUFFLE(1, 1, 1, 1)));
+            result = _mm_cvtss_f32(acc0);
+#endif
+            for (; i < count; ++i)
+                result += a[i] * b[i];
+            return result;
+        }
+    }
+
+    void MameSampleHistory::reset(const uint32_t channels, const uint32_t silence)
+    {
+        m_data.assign(channels, {});
+        m_capacity = 0;
+        m_mask = 0;
+        m_begin = m_end = -static_cast<int64_t>(silence);
+
+        grow(silence);
+
+        m_end = 0;
+    }
+
+    void MameSampleHistory::append(const float* const* src, const uint32_t samples)
+    {
+        if (static_cast<size_t>(m_end - m_begin) + samples > m_capacity)
+            grow(static_cast<size_t>(m_end - m_begin) + samples);
+
+        for (uint32_t c = 0; c < m_data.size(); ++c)
+            write(c, m_end, src[c], samples);
+
+        m_end += samples;
+    }
+
+    void MameSampleHistory::discardUntil(const int64_t index)
+    {
+        m_begin = std::clamp(index, m_begin, m_end);
+    }
+
+    void MameSampleHistory::write(const uint32_t c, const int64_t index, const float* src, size_t count)
+    {
+        float* data = m_data[c].data();
+        size_t o = offset(index);
+
+        while (count)
+        {
+            const size_t n = std::min(count, m_capacity - o);
+            std::memcpy(data + o, src, n * sizeof(float));
+            std::memcpy(data + o + m_capacity, src, n * sizeof(float));
+            src += n;
+            count -= n;
+            o = 0;
+        }
+    }
+
+    void MameSampleHistory::grow(const size_t minCapacity)
+    {
+        size_t capacity = std::max<size_t>(m_capacity, 1024);
+        while (capacity < minCapacity)
+            capacity <<= 1;
+
+        if (capacity == m_capacity)
+            return;
+
+        const auto size = static_cast<size_t>(m_end - m_begin);
 
-            const int64_t off = index - srcBase;
-            if (off < 0 || static_cast<size_t>(off) >= src.size())
-                return 0.0f;
+        std::vector<std::vector<float>> existing(m_data.size());
+        for (uint32_t c = 0; c < m_data.size(); ++c)
+            existing[c].assign(channel(c), channel(c) + size);
 
-            return src[static_cast<size_t>(off)];
+        m_capacity = capacity;
+        m_mask = m_capacity - 1;
+
+        for (uint32_t c = 0; c < m_data.size(); ++c)
+        {
+            m_data[c].assign(m_capacity * 2, 0.0f);
+            write(c, m_begin, existing[c].data(), size);
         }
     }
 
@@ -230,6 +324,9 @@ namespace synthLib
             const float inv = (s != 0.0f) ? (1.0f / s) : 1.0f;
             for (uint32_t j = 0; j != m_orderPerLane; ++j)
                 m_coefficients[i][j] *= inv;
+
+            // coefficient k applies to source sample s-k, reversed they run in the same direction as the source
+            std::reverse(m_coefficients[i].begin(), m_coefficients[i].end());
         }
 
         m_delta = m_ftm % m_fsm;
@@ -288,7 +385,7 @@ namespace synthLib
         return maxS;
     }
 
-    void MameResamplerHq::apply(const std::deque<float>& src, const int64_t srcBase, float* dest, const uint64_t destSample, const uint32_t samples, const float gain) const
+    void MameResamplerHq::apply(const float* const* src, const int64_t srcBase, float* const* dest, const uint32_t channels, const uint64_t destSample, const uint32_t samples, const float gain) const
     {
         if (samples == 0)
             return;
@@ -299,23 +396,15 @@ namespace synthLib
         int64_t s = static_cast<int64_t>(ssamp + uint64_t(m_fs) * seconds);
         uint32_t phase = (dsamp * m_ftm) % m_fsm;
 
-        // Copy needed source range to contiguous buffer for cache-friendly inner loop
-        const int64_t rangeStart = s - static_cast<int64_t>(m_orderPerLane) + 1;
-        const int64_t rangeEnd = maxSourceIndexNeeded(destSample, samples);
-        const size_t rangeSize = static_cast<size_t>(rangeEnd - rangeStart + 1);
-
-        m_scratchBuffer.resize(rangeSize);
-        for (size_t i = 0; i < rangeSize; ++i)
-            m_scratchBuffer[i] = sample_at(src, srcBase, rangeStart + static_cast<int64_t>(i));
+        assert(s - static_cast<int64_t>(m_orderPerLane) + 1 >= srcBase);
 
         for (uint32_t sample = 0; sample != samples; ++sample)
         {
-            float acc = 0.0f;
+            // all channels share the phase and source position, the taps run over s-order+1 ... s
             const float* filter = m_coefficients[phase >> m_phaseShift].data();
-            const size_t srcOff = static_cast<size_t>(s - rangeStart);
-            for (uint32_t k = 0; k != m_orderPerLane; ++k)
-                acc += filter[k] * m_scratchBuffer[srcOff - k];
-            dest[sample] += acc * gain;
+            const auto srcOff = static_cast<size_t>(s - srcBase) + 1 - m_orderPerLane;
+            for (uint32_t c = 0; c != channels; ++c)
+                dest[c][sample] += dotProduct(filter, src[c] + srcOff, m_orderPerLane) * gain;
 
             phase += m_delta;
             s += m_skip;
@@ -441,7 +530,7 @@ namespace synthLib
         return maxUsed;
     }
 
-    void MameResamplerLofi::apply(const std::deque<float>& src, const int64_t srcBase, float* dest, const uint64_t destSample, const uint32_t samples, const float gain) const
+    void MameResamplerLofi::apply(const float* const* src, const int64_t srcBase, float* const* dest, const uint32_t channels, const uint64_t destSample, const uint32_t samples, const float gain) const
     {
         if (samples == 0)
             return;
@@ -461,47 +550,45 @@ namespace synthLib
 
         ssample -= static_cast<int64_t>(4 * m_sourceDivide);
 
-        // Copy needed source range to contiguous buffer
-        const int64_t rangeStart = ssample;
-        const int64_t rangeEnd = maxSourceIndexNeeded(destSample, samples);
-        const size_t rangeSize = static_cast<size_t>(rangeEnd - rangeStart + 1);
-
-        m_scratchBuffer.resize(rangeSize);
-        for (size_t i = 0; i < rangeSize; ++i)
-            m_scratchBuffer[i] = sample_at(src, srcBase, rangeStart + static_cast<int64_t>(i));
+        assert(ssample >= srcBase);
 
-        int64_t readPos = ssample;
+        phase <<= 12;
 
-        auto reader = [&]() -> float
+        for (uint32_t c = 0; c != channels; ++c)
         {
-            float sm = 0.0f;
-            const size_t off = static_cast<size_t>(readPos - rangeStart);
-            for (uint32_t i = 0; i != m_sourceDivide; ++i)
-                sm += m_scratchBuffer[off + i];
-            readPos += m_sourceDivide;
-            return sm * m_invSourceDivide;
-        };
+            const float* in = src[c] + (ssample - srcBase);
+            float* out = dest[c];
 
-        phase <<= 12;
+            auto reader = [&]() -> float
+            {
+                float sm = 0.0f;
+                for (uint32_t i = 0; i != m_sourceDivide; ++i)
+                    sm += in[i];
+                in += m_sourceDivide;
+                return sm * m_invSourceDivide;
+            };
 
-        float s0 = reader();
-        float s1 = reader();
-        float s2 = reader();
-        float s3 = reader();
+            uint32_t p = phase;
 
-        for (uint32_t sample = 0; sample != samples; ++sample)
-        {
-            const uint32_t cphase = phase >> 12;
-            dest[sample] += gain * (-s0 * s_interpolationTable[0][0x1000 - cphase] + s1 * s_interpolationTable[1][0x1000 - cphase] + s2 * s_interpolationTable[1][cphase] - s3 * s_interpolationTable[0][cphase]);
+            float s0 = reader();
+            float s1 = reader();
+            float s2 = reader();
+            float s3 = reader();
 
-            phase += m_step;
-            if (phase & 0x1000000)
+            for (uint32_t sample = 0; sample != samples; ++sample)
             {
-                phase &= 0x00ffffff;
-                s0 = s1;
-                s1 = s2;
-                s2 = s3;
-                s3 = reader();
+                const uint32_t cphase = p >> 12;
+                out[sample] += gain * (-s0 * s_interpolationTable[0][0x1000 - cphase] + s1 * s_interpolationTable[1][0x1000 - cphase] + s2 * s_interpolationTable[1][cphase] - s3 * s_interpolationTable[0][cphase]);
+
+                p += m_step;
+                if (p & 0x1000000)
+                {
+                    p &= 0x00ffffff;
+                    s0 = s1;
+                    s1 = s2;
+                    s2 = s3;
+                    s3 = reader();
+                }
             }
         }
     }
@@ -2,7 +2,6 @@
 
 #include <array>
 #include <cstdint>
-#include <deque>
 #include <memory>
 #include <vector>
 
@@ -14,6 +13,35 @@ namespace synthLib
         Lofi
     };
 
+    // Source history of all channels. Each channel is a power-of-two ring buffer that is stored twice in a row, which
+    // makes every range of up to capacity samples readable as one contiguous block without wrap-around checks
+    class MameSampleHistory
+    {
+    public:
+        // resets to the given channel count, with 'silence' zero samples in front of sample index zero
+        void reset(uint32_t channels, uint32_t silence);
+
+        int64_t begin() const { return m_begin; }
+        int64_t end() const { return m_end; }
+
+        void append(const float* const* src, uint32_t samples);
+        void discardUntil(int64_t index);
+
+        // contiguous samples of a channel, starting at begin()
+        const float* channel(const uint32_t c) const { return m_data[c].data() + offset(m_begin); }
+
+    private:
+        size_t offset(const int64_t index) const { return static_cast<size_t>(static_cast<uint64_t>(index) & m_mask); }
+        void write(uint32_t c, int64_t index, const float* src, size_t count);
+        void grow(size_t minCapacity);
+
+        std::vector<std::vector<float>> m_data;
+        size_t m_capacity = 0;
+        uint64_t m_mask = 0;
+        int64_t m_begin = 0;
+        int64_t m_end = 0;
+    };
+
     class MameResampler
     {
     public:
@@ -22,7 +50,10 @@ namespace synthLib
         virtual uint32_t historySize() const = 0;
         virtual int64_t minSourceIndexForOutput(uint64_t destSample) const = 0;
         virtual int64_t maxSourceIndexNeeded(uint64_t destSample, uint32_t samples) const = 0;
-        virtual void apply(const std::deque<float>& src, int64_t srcBase, float* dest, uint64_t destSample, uint32_t samples, float gain) const = 0;
+
+        // Adds the output of all channels to dest. src[c] points to the source sample with index srcBase of channel c,
+        // all samples up to maxSourceIndexNeeded() have to be contiguous
+        virtual void apply(const float* const* src, int64_t srcBase, float* const* dest, uint32_t channels, uint64_t destSample, uint32_t samples, float gain) const = 0;
 
         static std::unique_ptr<MameResampler> create(MameResamplerMode mode, uint32_t fs, uint32_t ft);
     };
@@ -35,7 +66,7 @@ namespace synthLib
         uint32_t historySize() const override;
         int64_t minSourceIndexForOutput(uint64_t destSample) const override;
         int64_t maxSourceIndexNeeded(uint64_t destSample, uint32_t samples) const override;
-        void apply(const std::deque<float>& src, int64_t srcBase, float* dest, uint64_t destSample, uint32_t samples, float gain) const override;
+        void apply(const float* const* src, int64_t srcBase, float* const* dest, uint32_t channels, uint64_t destSample, uint32_t samples, float gain) const override;
 
     private:
         static uint32_t computeGcd(uint32_t fs, uint32_t ft);
@@ -50,8 +81,7 @@ namespace synthLib
         uint32_t m_phases = 0;
         uint32_t m_phaseShift = 0;
 
-        std::vector<std::vector<float>> m_coefficients;
-        mutable std::vector<float> m_scratchBuffer;
+        std::vector<std::vector<float>> m_coefficients;  // per phase, in reverse order to run forward over the source
     };
 
     class MameResamplerLofi final : public MameResampler
@@ -62,7 +92,7 @@ namespace synthLib
         uint32_t historySize() const override;
         int64_t minSourceIndexForOutput(uint64_t destSample) const override;
         int64_t maxSourceIndexNeeded(uint64_t destSample, uint32_t samples) const override;
-        void apply(const std::deque<float>& src, int64_t srcBase, float* dest, uint64_t destSample, uint32_t samples, float gain) const override;
+        void apply(const float* const* src, int64_t srcBase, float* const* dest, uint32_t channels, uint64_t destSample, uint32_t samples, float gain) const override;
 
     private:
         static const std::array<std::array<float, 0x1001>, 2> s_interpolationTable;
@@ -72,7 +102,6 @@ namespace synthLib
         uint32_t m_fs = 0;
         uint32_t m_ft = 0;
         uint32_t m_step = 0;
-        mutable std::vector<float> m_scratchBuffer;
     };
 }
 
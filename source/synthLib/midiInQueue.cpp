@@ -0,0 +1,104 @@
+#include "midiInQueue.h"
+
+namespace synthLib
+{
+	static_assert((MidiInQueue::Size & (MidiInQueue::Size - 1)) == 0, "size needs to be a power of two");
+
+	MidiInQueue::MidiInQueue()
+	{
+		for(uint32_t i=0; i<Size; ++i)
+		{
+			m_slots[i].sequence.store(i, std::memory_order_relaxed);
+			m_slots[i].event.sysex.reserve(SysexReserve);
+		}
+
+		m_overflow.reserve(Size);
+	}
+
+	void MidiInQueue::push(const SMidiEvent& _ev)
+	{
+		m_pushed.fetch_add(1, std::memory_order_relaxed);
+
+		// keep the order of events of a producer, once an event went to the overflow list all further ones go there
+		// too until the consumer has processed them
+		if(m_hasOverflow.load(std::memory_order_acquire))
+		{
+			pushOverflow(_ev);
+			return;
+		}
+
+		auto writePos = m_writePos.load(std::memory_order_relaxed);
+
+		while(true)
+		{
+			auto& slot = m_slots[writePos & (Size - 1)];
+
+			const auto sequence = slot.sequence.load(std::memory_order_acquire);
+			const auto diff = static_cast<int64_t>(sequence) - static_cast<int64_t>(writePos);
+
+			if(diff == 0)
+			{
+				if(m_writePos.compare_exchange_weak(writePos, writePos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if(diff < 0)
+			{
+				// queue is full
+				pushOverflow(_ev);
+				return;
+			}
+			else
+			{
+				writePos = m_writePos.load(std::memory_order_relaxed);
+			}
+		}
+
+		auto& slot = m_slots[writePos & (Size - 1)];
+
+		auto& ev = slot.event;
+		ev.a = _ev.a;
+		ev.b = _ev.b;
+		ev.c = _ev.c;
+		ev.offset = _ev.offset;
+		ev.source = _ev.source;
+		ev.sysex.assign(_ev.sysex.begin(), _ev.sysex.end());
+
+		slot.sequence.store(writePos + 1, std::memory_order_release);
+
+		updateMaxFill(writePos);
+	}
+
+	MidiInQueue::Stats MidiInQueue::getStats() const
+	{
+		Stats s;
+		s.pushed = m_pushed.load(std::memory_order_relaxed);
+		s.overflows = m_overflows.load(std::memory_order_relaxed);
+		s.maxFill = m_maxFill.load(std::memory_order_relaxed);
+		return s;
+	}
+
+	void MidiInQueue::pushOverflow(const SMidiEvent& _ev)
+	{
+		m_overflows.fetch_add(1, std::memory_order_relaxed);
+
+		std::lock_guard lock(m_overflowMutex);
+		m_overflow.push_back(_ev);
+		m_hasOverflow.store(true, std::memory_order_release);
+	}
+
+	void MidiInQueue::updateMaxFill(const uint64_t _writePos)
+	{
+		const auto readPos = m_readPos.load(std::memory_order_relaxed);
+
+		if(readPos > _writePos)
+			return;
+
+		const auto fill = static_cast<uint32_t>(_writePos + 1 - readPos);
+
+		auto maxFill = m_maxFill.load(std::memory_order_relaxed);
+
+		while(fill > maxFill && !m_maxFill.compare_exchange_weak(maxFill, fill, std::memory_order_relaxed))
+		{
+		}
+	}
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "midiTypes.h"
+
+namespace synthLib
+{
+	// Bounded multi-producer single-consumer queue for incoming MIDI events.
+	// Producers never wait for the consumer. Each slot keeps its sysex buffer, once it has grown to the size of the
+	// messages passed through it, producers do not allocate anymore. The consumer takes sysex by swapping buffers.
+	// If the queue is full, events go to an overflow list that is protected by a mutex that only producers and the
+	// consumer touch, the audio thread lock is never taken.
+	class MidiInQueue
+	{
+	public:
+		static constexpr uint32_t Size = 1024;
+		static constexpr uint32_t SysexReserve = 512;
+
+		struct Stats
+		{
+			uint64_t pushed = 0;
+			uint64_t overflows = 0;		// events that did not fit into the queue
+			uint32_t maxFill = 0;		// maximum number of events that have been waiting in the queue
+		};
+
+		MidiInQueue();
+
+		void push(const SMidiEvent& _ev);
+
+		// consumer only. The event passed to the callback may be modified, for example to take its sysex buffer
+		template<typename TFunc> void pop(TFunc&& _func)
+		{
+			auto readPos = m_readPos.load(std::memory_order_relaxed);
+
+			while(true)
+			{
+				auto& slot = m_slots[readPos & (Size - 1)];
+
+				if(slot.sequence.load(std::memory_order_acquire) != readPos + 1)
+					break;
+
+				_func(slot.event);
+
+				slot.event.sysex.clear();
+				slot.sequence.store(readPos + Size, std::memory_order_release);
+
+				m_readPos.store(++readPos, std::memory_order_relaxed);
+			}
+
+			if(!m_hasOverflow.load(std::memory_order_acquire))
+				return;
+
+			// overflowing events are newer than the queued ones, wait until all of them have been published and processed
+			if(m_writePos.load(std::memory_order_acquire) != readPos)
+				return;
+
+			std::lock_guard lock(m_overflowMutex);
+
+			for (auto& ev : m_overflow)
+				_func(ev);
+
+			m_overflow.clear();
+			m_hasOverflow.store(false, std::memory_order_release);
+		}
+
+		Stats getStats() const;
+
+	private:
+		void pushOverflow(const SMidiEvent& _ev);
+		void updateMaxFill(uint64_t _writePos);
+
+		struct Slot
+		{
+			std::atomic<uint64_t> sequence;
+			SMidiEvent event;
+		};
+
+		std::array<Slot, Size> m_slots;
+
+		alignas(64) std::atomic<uint64_t> m_writePos{0};
+		alignas(64) std::atomic<uint64_t> m_readPos{0};
+
+		std::mutex m_overflowMutex;
+		std::vector<SMidiEvent> m_overflow;
+		std::atomic<bool> m_hasOverflow{false};
+
+		std::atomic<uint64_t> m_pushed{0};
+		std::atomic<uint64_t> m_overflows{0};
+		std::atomic<uint32_t> m_maxFill{0};
+	};
+}
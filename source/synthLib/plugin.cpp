@@ -12,64 +12,70 @@ namespace synthLib
 	constexpr uint8_t g_stateVersion = 1;
 
 	Plugin::Plugin(Device* _device, CallbackDeviceInvalid _callbackDeviceInvalid)
-	: m_resampler(_device->getChannelCountIn(), _device->getChannelCountOut())
+	: m_resampler(std::make_unique<ResamplerInOut>(_device->getChannelCountIn(), _device->getChannelCountOut()))
 	, m_device(_device)
 	, m_midiClock(*this)
-	, m_deviceSamplerate(_device->getSamplerate())
 	, m_callbackDeviceInvalid(std::move(_callbackDeviceInvalid))
 	{
+		m_config.deviceSamplerate = _device->getSamplerate();
+		m_activeConfig = m_config;
+
+		m_midiIn.reserve(MidiInQueue::Size);
+		m_sysexBuffers.reserve(MidiInQueue::Size);
 	}
 
 	void Plugin::addMidiEvent(const SMidiEvent& _ev)
 	{
-		std::lock_guard lock(m_lockAddMidiEvent);
-
-		if(m_midiInRingBuffer.full())
-		{
-			std::lock_guard l(m_lock);
-			processMidiInEvent(m_midiInRingBuffer.pop_front());
-		}
-		m_midiInRingBuffer.push_back(_ev);
+		m_midiInQueue.push(_ev);
 	}
 
 	bool Plugin::setPreferredDeviceSamplerate(const float _samplerate)
 	{
+		// the device must not process audio while its samplerate changes. Samplerate changes are rare, they take the
+		// audio lock and are applied immediately
 		std::lock_guard lock(m_lock);
+		std::lock_guard lockConfig(m_configMutex);
+
+		auto config = m_config;
 
-		const auto sr = m_device->getDeviceSamplerate(_samplerate, m_hostSamplerate);
+		const auto sr = m_device->getDeviceSamplerate(_samplerate, config.hostSamplerate);
 
-		if(sr == m_deviceSamplerate)  // NOLINT(clang-diagnostic-float-equal)
+		if(sr == config.deviceSamplerate)  // NOLINT(clang-diagnostic-float-equal)
 			return true;
 
 		if(!m_device->setSamplerate(sr))
 			return false;
 
-		m_deviceSamplerate = sr;
-		m_resampler.setSamplerates(m_hostSamplerate, m_deviceSamplerate);
-
-		updateDeviceLatency();
+		config.deviceSamplerate = sr;
+		commitConfig(config);
+		applyConfig();
+		m_retiredResampler.reset();
 		return true;
 	}
 
 	void Plugin::setHostSamplerate(const float _hostSamplerate, const float _preferredDeviceSamplerate)
 	{
 		std::lock_guard lock(m_lock);
+		std::lock_guard lockConfig(m_configMutex);
 
-		m_deviceSamplerate = m_device->getDeviceSamplerate(_preferredDeviceSamplerate, _hostSamplerate);
-		m_device->setSamplerate(m_deviceSamplerate);
-		m_resampler.setSamplerates(_hostSamplerate, m_deviceSamplerate);
+		auto config = m_config;
+		config.hostSamplerate = _hostSamplerate;
+		config.deviceSamplerate = m_device->getDeviceSamplerate(_preferredDeviceSamplerate, _hostSamplerate);
 
-		m_hostSamplerate = _hostSamplerate;
-		m_hostSamplerateInv = _hostSamplerate > 0 ? 1.0f / _hostSamplerate : 0.0f;
+		m_device->setSamplerate(config.deviceSamplerate);
 
-		updateDeviceLatency();
+		commitConfig(config);
+		applyConfig();
+		m_retiredResampler.reset();
 	}
 
 	void Plugin::setResamplerMode(const Resampler::Mode _mode)
 	{
-		std::lock_guard lock(m_lock);
-		m_resampler.setResamplerMode(_mode);
-		updateDeviceLatency();
+		std::lock_guard lock(m_configMutex);
+
+		auto config = m_config;
+		config.resamplerMode = _mode;
+		commitConfig(config);
 	}
 
 	void Plugin::process(const TAudioInputs& _inputs, const TAudioOutputs& _outputs, size_t _count, const float _bpm, const float _ppqPos, const bool _isPlaying)
@@ -89,21 +95,26 @@ namespace synthLib
 
 		if(!m_device->isValid())
 		{
+			std::lock_guard lockConfig(m_configMutex);
+
 			m_device = m_callbackDeviceInvalid(m_device);
 
 			if(!m_device || !m_device->isValid())
 				return;
 		}
 
+		applyPendingConfig();
+
 		processMidiInEvents();
 		processMidiClock(_bpm, _ppqPos, _isPlaying, _count);
 
-		m_resampler.process(inputs, outputs, m_midiIn, m_midiOut, static_cast<uint32_t>(_count), 
+		m_resampler->process(inputs, outputs, m_midiIn, m_midiOut, static_cast<uint32_t>(_count), 
 			[&](const TAudioInputs& _ins, const TAudioOutputs& _outs, size_t _c, const ResamplerInOut::TMidiVec& _midiIn, ResamplerInOut::TMidiVec& _midiOut)
 		{
 			m_device->process(_ins, _outs, _c, _midiIn, _midiOut);
 		});
 
+		recycleSysexBuffers();
 		m_midiIn.clear();
 	}
 
@@ -128,11 +139,19 @@ namespace synthLib
 		std::vector<uint8_t> deviceState;
 		getState(deviceState, StateTypeGlobal);
 
-		delete m_device;
+		{
+			std::lock_guard lockConfig(m_configMutex);
+
+			delete m_device;
 
-		m_device = _device;
+			m_device = _device;
+
+			m_device->setSamplerate(m_activeConfig.deviceSamplerate);
+
+			if(m_configPending.load(std::memory_order_acquire))
+				applyConfig();
+		}
 
-		m_device->setSamplerate(m_deviceSamplerate);
 		if(!deviceState.empty())
 			setState(deviceState);
 
@@ -140,6 +159,9 @@ namespace synthLib
 		m_midiClock.restart();
 
 		updateDeviceLatency();
+
+		std::lock_guard lockConfig(m_configMutex);
+		updateLatencies(m_activeConfig, *m_resampler);
 	}
 
 #if !SYNTHLIB_DEMO_MODE
@@ -200,16 +222,102 @@ namespace synthLib
 
 	bool Plugin::setLatencyBlocks(uint32_t _latencyBlocks)
 	{
-		std::lock_guard lock(m_lock);
+		std::lock_guard lock(m_configMutex);
 
-		if(m_extraLatencyBlocks == _latencyBlocks)
+		if(m_config.extraLatencyBlocks == _latencyBlocks)
 			return false;
 
-		m_extraLatencyBlocks = _latencyBlocks;
-		updateDeviceLatency();
+		auto config = m_config;
+		config.extraLatencyBlocks = _latencyBlocks;
+		commitConfig(config);
 		return true;
 	}
 
+	uint32_t Plugin::getLatencyBlocks() const
+	{
+		std::lock_guard lock(m_configMutex);
+		return m_config.extraLatencyBlocks;
+	}
+
+	void Plugin::commitConfig(const Config& _config)
+	{
+		// a resampler that has been replaced by the audio thread is destroyed here instead of there
+		m_retiredResampler.reset();
+
+		const bool recreateResampler =
+			_config.hostSamplerate != m_config.hostSamplerate ||		// NOLINT(clang-diagnostic-float-equal)
+			_config.deviceSamplerate != m_config.deviceSamplerate ||	// NOLINT(clang-diagnostic-float-equal)
+			_config.resamplerMode != m_config.resamplerMode;
+
+		if(recreateResampler)
+		{
+			// allocate and initialize the resampler here so that the audio thread only needs to swap it in
+			auto resampler = std::make_unique<ResamplerInOut>(m_device->getChannelCountIn(), m_device->getChannelCountOut());
+			resampler->setResamplerMode(_config.resamplerMode);
+			resampler->setSamplerates(_config.hostSamplerate, _config.deviceSamplerate);
+			m_pendingResampler = std::move(resampler);
+		}
+
+		m_config = _config;
+
+		updateLatencies(m_config, m_pendingResampler ? *m_pendingResampler : *m_resampler);
+
+		m_configPending.store(true, std::memory_order_release);
+	}
+
+	void Plugin::applyPendingConfig()
+	{
+		if(!m_configPending.load(std::memory_order_acquire))
+			return;
+
+		// never wait for a setter, the config is applied in one of the next blocks instead
+		std::unique_lock lock(m_configMutex, std::try_to_lock);
+
+		if(!lock.owns_lock())
+			return;
+
+		applyConfig();
+	}
+
+	void Plugin::applyConfig()
+	{
+		// the device samplerate has already been changed by the setter, see setPreferredDeviceSamplerate
+		if(m_pendingResampler)
+		{
+			m_retiredResampler = std::move(m_resampler);
+			m_resampler = std::move(m_pendingResampler);
+		}
+
+		m_activeConfig = m_config;
+
+		m_hostSamplerate.store(m_activeConfig.hostSamplerate);
+		m_hostSamplerateInv.store(m_activeConfig.hostSamplerate > 0 ? 1.0f / m_activeConfig.hostSamplerate : 0.0f);
+
+		updateDeviceLatency();
+		updateLatencies(m_activeConfig, *m_resampler);
+
+		m_configPending.store(false, std::memory_order_release);
+	}
+
+	void Plugin::updateLatencies(const Config& _config, const ResamplerInOut& _resampler)
+	{
+		const auto blockLatency = _config.blockSize * _config.extraLatencyBlocks;
+
+		uint32_t deviceLatencyMidiToOutput = 0;
+		uint32_t deviceLatencyInputToOutput = 0;
+
+		if(_config.deviceSamplerate > 0)
+		{
+			const auto scale = _config.hostSamplerate / _config.deviceSamplerate;
+
+			deviceLatencyMidiToOutput = static_cast<uint32_t>(static_cast<float>(m_device->getInternalLatencyMidiToOutput()) * scale);
+			deviceLatencyInputToOutput = static_cast<uint32_t>(static_cast<float>(m_device->getInternalLatencyInputToOutput()) * scale);
+		}
+
+		m_latencyMidiToOutput.store(blockLatency + deviceLatencyMidiToOutput + _resampler.getOutputLatency(), std::memory_order_relaxed);
+		m_latencyInputToOutput.store(blockLatency + deviceLatencyInputToOutput + _resampler.getOutputLatency() + _resampler.getInputLatency(), std::memory_order_relaxed);
+	}
+
 	void Plugin::processMidiClock(const float _bpm, const float _ppqPos, const bool _isPlaying, const size_t _sampleCount)
 	{
 		m_midiClock.process(_bpm, _ppqPos, _isPlaying, _sampleCount);
@@ -225,27 +333,48 @@ namespace synthLib
 
 	void Plugin::updateDeviceLatency()
 	{
-		if(m_blockSize <= 0 || m_hostSamplerate <= 0)
+		if(m_activeConfig.blockSize <= 0 || m_hostSamplerate <= 0)
 			return;
 
-		const auto latency = static_cast<uint32_t>(std::ceil(static_cast<float>(m_blockSize * m_extraLatencyBlocks) * m_device->getSamplerate() * m_hostSamplerateInv));
+		const auto latency = static_cast<uint32_t>(std::ceil(static_cast<float>(m_activeConfig.blockSize * m_activeConfig.extraLatencyBlocks) * m_device->getSamplerate() * m_hostSamplerateInv));
 		m_device->setExtraLatencySamples(latency);
-
-		m_deviceLatencyMidiToOutput = static_cast<uint32_t>(static_cast<float>(m_device->getInternalLatencyMidiToOutput()) * m_hostSamplerate / m_device->getSamplerate());
-		m_deviceLatencyInputToOutput = static_cast<uint32_t>(static_cast<float>(m_device->getInternalLatencyInputToOutput()) * m_hostSamplerate / m_device->getSamplerate());
 	}
 
 	void Plugin::processMidiInEvents()
 	{
-		while (!m_midiInRingBuffer.empty())
+		m_midiInQueue.pop([this](SMidiEvent& _ev)
+		{
+			SMidiEvent ev(_ev.source, _ev.a, _ev.b, _ev.c, _ev.offset);
+
+			if(!_ev.sysex.empty())
+			{
+				// take the sysex buffer of the queue slot and give it a recycled one so that it keeps its capacity
+				ev.sysex.swap(_ev.sysex);
+
+				if(!m_sysexBuffers.empty())
+				{
+					_ev.sysex.swap(m_sysexBuffers.back());
+					m_sysexBuffers.pop_back();
+				}
+			}
+
+			processMidiInEvent(std::move(ev));
+		});
+	}
+
+	void Plugin::recycleSysexBuffers()
+	{
+		for (auto& ev : m_midiIn)
 		{
-			const auto ev = m_midiInRingBuffer.pop_front();
+			if(ev.sysex.capacity() == 0 || m_sysexBuffers.size() >= m_sysexBuffers.capacity())
+				continue;
 
-			processMidiInEvent(ev);
+			ev.sysex.clear();
+			m_sysexBuffers.emplace_back(std::move(ev.sysex));
 		}
 	}
 
-	void Plugin::processMidiInEvent(const SMidiEvent& _ev)
+	void Plugin::processMidiInEvent(SMidiEvent&& _ev)
 	{
 		// sysex might be sent in multiple chunks. Happens if coming from hardware
 		if (!_ev.sysex.empty())
@@ -254,7 +383,7 @@ namespace synthLib
 
 			if (isComplete)
 			{
-				m_midiIn.push_back(_ev);
+				m_midiIn.push_back(std::move(_ev));
 				return;
 			}
 
@@ -263,7 +392,7 @@ namespace synthLib
 
 			if (isStart)
 			{
-				m_pendingSysexInput = _ev;
+				m_pendingSysexInput = std::move(_ev);
 				return;
 			}
 
@@ -273,31 +402,31 @@ namespace synthLib
 
 				if (isEnd)
 				{
-					m_midiIn.push_back(m_pendingSysexInput);
+					m_midiIn.push_back(std::move(m_pendingSysexInput));
 					m_pendingSysexInput.sysex.clear();
 				}
 			}
 		}
 
-		m_midiIn.push_back(_ev);
+		m_midiIn.push_back(std::move(_ev));
 	}
 
 	void Plugin::setBlockSize(const uint32_t _blockSize)
 	{
-		std::lock_guard lock(m_lock);
-		m_blockSize = _blockSize;
-		updateDeviceLatency();
+		std::lock_guard lock(m_configMutex);
+
+		auto config = m_config;
+		config.blockSize = _blockSize;
+		commitConfig(config);
 	}
 
 	uint32_t Plugin::getLatencyMidiToOutput() const
 	{
-		std::lock_guard lock(m_lock);
-		return m_blockSize * m_extraLatencyBlocks + m_deviceLatencyMidiToOutput + m_resampler.getOutputLatency();
+		return m_latencyMidiToOutput.load(std::memory_order_relaxed);
 	}
 
 	uint32_t Plugin::getLatencyInputToOutput() const
 	{
-		std::lock_guard lock(m_lock);
-		return m_blockSize * m_extraLatencyBlocks + m_deviceLatencyInputToOutput + m_resampler.getOutputLatency() + m_resampler.getInputLatency();
+		return m_latencyInputToOutput.load(std::memory_order_relaxed);
 	}
 }
@@ -1,14 +1,15 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
 #include <mutex>
 #include <functional>
 
+#include "midiInQueue.h"
 #include "midiTypes.h"
 #include "resamplerInOut.h"
 #include "buildconfig.h"
 
-#include "dsp56kBase/ringbuffer.h"
-
 #include "deviceTypes.h"
 #include "midiClock.h"
 
@@ -24,6 +25,7 @@ namespace synthLib
 		Plugin(Device* _device, CallbackDeviceInvalid _callbackDeviceInvalid);
 
 		void addMidiEvent(const SMidiEvent& _ev);
+		MidiInQueue::Stats getMidiInStats() const { return m_midiInQueue.getStats(); }
 
 		bool setPreferredDeviceSamplerate(float _samplerate);
 
@@ -51,42 +53,66 @@ namespace synthLib
 		void insertMidiEvent(const SMidiEvent& _ev);
 
 		bool setLatencyBlocks(uint32_t _latencyBlocks);
-		uint32_t getLatencyBlocks() const { return m_extraLatencyBlocks; }
+		uint32_t getLatencyBlocks() const;
 
 	private:
+		// Configuration that is changed from non-audio threads. Setters prepare it, including a new resampler if
+		// required, and process() commits it at the start of the next block without waiting for the setter. Changes
+		// of the device samplerate are the exception, they are applied by the setter while holding the audio lock
+		struct Config
+		{
+			float hostSamplerate = 0.0f;
+			float deviceSamplerate = 0.0f;
+			Resampler::Mode resamplerMode = Resampler::Mode::Legacy;
+			uint32_t blockSize = 0;
+			uint32_t extraLatencyBlocks = 1;
+		};
+
+		void commitConfig(const Config& _config);
+		void applyPendingConfig();
+		void applyConfig();
+		void updateLatencies(const Config& _config, const ResamplerInOut& _resampler);
+
 		void processMidiClock(float _bpm, float _ppqPos, bool _isPlaying, size_t _sampleCount);
 		float* getDummyBuffer(size_t _minimumSize);
 		void updateDeviceLatency();
 		void processMidiInEvents();
-		void processMidiInEvent(const SMidiEvent& _ev);
+		void processMidiInEvent(SMidiEvent&& _ev);
+		void recycleSysexBuffers();
 
-		dsp56k::RingBuffer<SMidiEvent, 1024, false> m_midiInRingBuffer;
+		MidiInQueue m_midiInQueue;
 		std::vector<SMidiEvent> m_midiIn;
+		std::vector<SysexBuffer> m_sysexBuffers;
 		std::vector<SMidiEvent> m_midiOut;
 
 		SMidiEvent m_pendingSysexInput;
 
-		ResamplerInOut m_resampler;
+		std::unique_ptr<ResamplerInOut> m_resampler;
 		mutable std::recursive_mutex m_lock;
-		mutable std::mutex m_lockAddMidiEvent;
 
 		Device* m_device;
 
 		std::vector<float> m_dummyBuffer;
 
-		float m_hostSamplerate = 0.0f;
-		float m_hostSamplerateInv = 0.0f;
+		// read by any thread
+		std::atomic<float> m_hostSamplerate{0.0f};
+		std::atomic<float> m_hostSamplerateInv{0.0f};
 
-		uint32_t m_blockSize = 0;
+		// config as requested by the setters, guarded by m_configMutex
+		mutable std::mutex m_configMutex;
+		Config m_config;
+		std::unique_ptr<ResamplerInOut> m_pendingResampler;
+		std::unique_ptr<ResamplerInOut> m_retiredResampler;	// replaced on the audio thread, destroyed by the next setter
+		std::atomic<bool> m_configPending{false};
 
-		uint32_t m_deviceLatencyMidiToOutput = 0;
-		uint32_t m_deviceLatencyInputToOutput = 0;
+		// config used by the audio thread
+		Config m_activeConfig;
 
-		MidiClock m_midiClock;
+		std::atomic<uint32_t> m_latencyMidiToOutput{0};
+		std::atomic<uint32_t> m_latencyInputToOutput{0};
 
-		uint32_t m_extraLatencyBlocks = 1;
+		MidiClock m_midiClock;
 
-		float m_deviceSamplerate = 0.0f;
 		CallbackDeviceInvalid m_callbackDeviceInvalid;
 	};
 }
@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <utility>
 
 #include "libresample/include/libresample.h"
@@ -61,23 +62,27 @@ uint32_t synthLib::Resampler::process(TAudioOutputs& _output, const uint32_t _nu
 
 uint32_t synthLib::Resampler::processResampleMame(const TAudioOutputs& _output, const uint32_t _numChannels, const uint32_t _numSamples, const TProcessFunc& _processFunc)
 {
-	if (m_mameResamplerOut.empty())
+	if (!m_mameResampler)
 		return 0;
 
-	const int64_t maxNeeded = m_mameResamplerOut[0]->maxSourceIndexNeeded(m_mameDestSample, _numSamples);
-	const int64_t currentEnd = m_mameSourceBaseSample + static_cast<int64_t>(m_mameTempOutput[0].size()) - 1;
+	const int64_t maxNeeded = m_mameResampler->maxSourceIndexNeeded(m_mameDestSample, _numSamples);
+	const int64_t currentEnd = m_mameHistory.end() - 1;
 	const uint32_t requiredInput = (maxNeeded > currentEnd) ? static_cast<uint32_t>(maxNeeded - currentEnd) : 0u;
 
 	ensureMameInput(_numChannels, requiredInput, _processFunc);
 
+	std::array<const float*, std::tuple_size_v<TAudioOutputs>> src{};
+
 	for (uint32_t i = 0; i < _numChannels; ++i)
 	{
 		std::fill(_output[i], _output[i] + _numSamples, 0.0f);
-		m_mameResamplerOut[i]->apply(m_mameTempOutput[i], m_mameSourceBaseSample, _output[i], m_mameDestSample, _numSamples, 1.0f);
+		src[i] = m_mameHistory.channel(i);
 	}
 
+	m_mameResampler->apply(src.data(), m_mameHistory.begin(), _output.data(), _numChannels, m_mameDestSample, _numSamples, 1.0f);
+
 	m_mameDestSample += _numSamples;
-	trimMameHistory(_numChannels);
+	trimMameHistory();
 	return _numSamples;
 }
 
@@ -88,20 +93,19 @@ uint32_t synthLib::Resampler::processResample(const TAudioOutputs& _output, cons
 	const uint32_t inputLen = std::max(1, dsp56k::round_int(m_inputLen));
 	m_inputLen -= inputLen;
 
-	const auto availableInputLen = static_cast<uint32_t>(m_tempOutput[0].size());
-
-	if (availableInputLen < inputLen)
+	if (m_inputSize < inputLen)
 	{
+		reserveInput(inputLen);
+
 		TAudioOutputs tempBuffers;
 		tempBuffers.fill(nullptr);
 
 		for (uint32_t i = 0; i < _numChannels; ++i)
-		{
-			m_tempOutput[i].resize(inputLen, 0.0f);
-			tempBuffers[i] = &m_tempOutput[i][availableInputLen];
-		}
+			tempBuffers[i] = getInput(i) + m_inputSize;
+
+		_processFunc(tempBuffers, inputLen - m_inputSize);
 
-		_processFunc(tempBuffers, inputLen - availableInputLen);
+		m_inputSize = inputLen;
 	}
 
 	uint32_t outBufferUsed = 0;
@@ -111,25 +115,52 @@ uint32_t synthLib::Resampler::processResample(const TAudioOutputs& _output, cons
 	{
 		float* output = _output[i];
 
-		outBufferUsed = resample_process(m_resamplerOut[i], m_factorOutToIn, &m_tempOutput[i][0], static_cast<int>(inputLen), 0, &inBufferUsed, output, static_cast<int>(_numSamples));
+		const int used = inBufferUsed;
+
+		outBufferUsed = resample_process(m_resamplerOut[i], m_factorOutToIn, getInput(i), static_cast<int>(inputLen), 0, &inBufferUsed, output, static_cast<int>(_numSamples));
+
+		// all channels run with identical parameters and consume the same amount of input
+		assert(i == 0 || used == inBufferUsed);
+		(void)used;
+	}
+
+	// keep the unconsumed tail, it is the start of the input of the next call
+	const auto consumed = static_cast<uint32_t>(inBufferUsed);
 
-		if (static_cast<uint32_t>(inBufferUsed) < inputLen)
-		{
-//			LOG("inBufferUsed " << inBufferUsed << " inputLen " << inputLen);
-			const auto remaining = inputLen - inBufferUsed;
+	if (consumed)
+	{
+		const auto remaining = m_inputSize - consumed;
+
+		for (uint32_t i = 0; i < _numChannels; ++i)
+			std::memmove(getInput(i), getInput(i) + consumed, remaining * sizeof(float));
 
-			// NOTE: possible bug here, maybe we should only keep the unconsumed tail
-			m_tempOutput[i].erase(m_tempOutput[i].begin() + remaining, m_tempOutput[i].end());
-		}
-		else
-		{
-			m_tempOutput[i].clear();
-		}
+		m_inputSize = remaining;
 	}
 
 	return outBufferUsed;
 }
 
+void synthLib::Resampler::reserveInput(const uint32_t _numSamples)
+{
+	if (_numSamples <= m_inputCapacity)
+		return;
+
+	// grows only if the host increases its block size, the steady state is allocation free
+	const auto capacity = std::max(_numSamples, m_inputCapacity << 1);
+
+	std::vector<float> input(static_cast<size_t>(capacity) * m_numChannels, 0.0f);
+
+	// the old buffer is empty after a channel count change, do not form pointers into it
+	if (m_inputSize)
+	{
+		for (uint32_t i = 0; i < m_numChannels; ++i)
+			std::copy_n(getInput(i), m_inputSize, input.data() + static_cast<size_t>(i) * capacity);
+	}
+
+	std::swap(m_input, input);
+	m_inputCapacity = capacity;
+}
+
 void synthLib::Resampler::ensureMameInput(const uint32_t _numChannels, const uint32_t _requiredInputSamples, const TProcessFunc& _processFunc)
 {
 	if (_requiredInputSamples == 0)
@@ -146,42 +177,19 @@ void synthLib::Resampler::ensureMameInput(const uint32_t _numChannels, const uin
 
 	_processFunc(tempBuffers, _requiredInputSamples);
 
-	for (uint32_t i = 0; i < _numChannels; ++i)
-	{
-		auto& dst = m_mameTempOutput[i];
-		dst.insert(dst.end(), m_mameInputTemp[i].begin(), m_mameInputTemp[i].end());
-	}
+	m_mameHistory.append(tempBuffers.data(), _requiredInputSamples);
 }
 
-void synthLib::Resampler::trimMameHistory(const uint32_t _numChannels)
+void synthLib::Resampler::trimMameHistory()
 {
-	if (m_mameResamplerOut.empty() || m_mameTempOutput.empty() || m_mameTempOutput[0].empty())
-		return;
-
-	int64_t minNeeded = m_mameResamplerOut[0]->minSourceIndexForOutput(m_mameDestSample);
-	uint32_t historyKeep = m_mameResamplerOut[0]->historySize();
-	for (uint32_t i = 1; i < _numChannels; ++i)
-	{
-		minNeeded = std::min(minNeeded, m_mameResamplerOut[i]->minSourceIndexForOutput(m_mameDestSample));
-		historyKeep = std::max(historyKeep, m_mameResamplerOut[i]->historySize());
-	}
-
-	int64_t safeBase = minNeeded - static_cast<int64_t>(historyKeep);
-	if (safeBase < 0)
-		safeBase = 0;
-
-	if (safeBase <= m_mameSourceBaseSample)
+	if (!m_mameResampler)
 		return;
 
-	const int64_t drop64 = safeBase - m_mameSourceBaseSample;
-	const size_t drop = static_cast<size_t>(std::min<int64_t>(drop64, static_cast<int64_t>(m_mameTempOutput[0].size())));
-	if (drop == 0)
-		return;
+	const int64_t minNeeded = m_mameResampler->minSourceIndexForOutput(m_mameDestSample);
+	const int64_t safeBase = minNeeded - static_cast<int64_t>(m_mameResampler->historySize());
 
-	for (uint32_t i = 0; i < _numChannels; ++i)
-		m_mameTempOutput[i].erase(m_mameTempOutput[i].begin(), m_mameTempOutput[i].begin() + static_cast<std::ptrdiff_t>(drop));
-
-	m_mameSourceBaseSample += static_cast<int64_t>(drop);
+	if (safeBase > m_mameHistory.begin())
+		m_mameHistory.discardUntil(safeBase);
 }
 
 void synthLib::Resampler::destroyResamplers()
@@ -192,37 +200,37 @@ void synthLib::Resampler::destroyResamplers()
 			resample_close(resampler);
 	}
 	m_resamplerOut.clear();
-	m_mameResamplerOut.clear();
-	m_mameTempOutput.clear();
+	m_mameResampler.reset();
+	m_mameHistory.reset(0, 0);
 	m_mameInputTemp.clear();
-	m_mameSourceBaseSample = 0;
 	m_mameDestSample = 0;
 }
 
 void synthLib::Resampler::setChannelCount(uint32_t _numChannels)
 {
-	if (m_tempOutput.size() == _numChannels)
+	if (m_numChannels == _numChannels)
 		return;
 
 	destroyResamplers();
 
+	m_numChannels = _numChannels;
+
 	m_resamplerOut.resize(_numChannels);
-	m_tempOutput.resize(_numChannels);
-	m_mameResamplerOut.resize(_numChannels);
-	m_mameTempOutput.resize(_numChannels);
 
-	for (auto& buf : m_tempOutput)
-		buf.clear();
-	for (auto& buf : m_mameTempOutput)
-		buf.clear();
+	m_input.clear();
+	m_inputCapacity = 0;
+	m_inputSize = 0;
+	reserveInput(4096);
 
 	const auto factor = static_cast<double>(m_factorOutToIn);
 
 	if (useMameResampler())
 	{
 		const auto mode = (m_mode == Mode::MameLofi) ? MameResamplerMode::Lofi : MameResamplerMode::Hq;
-		for (auto& resampler : m_mameResamplerOut)
-			resampler = MameResampler::create(mode, static_cast<uint32_t>(m_samplerateIn), static_cast<uint32_t>(m_samplerateOut));
+		m_mameResampler = MameResampler::create(mode, static_cast<uint32_t>(m_samplerateIn), static_cast<uint32_t>(m_samplerateOut));
+
+		// the history starts with silence, the first outputs read source samples before index zero
+		m_mameHistory.reset(_numChannels, m_mameResampler->historySize());
 	}
 	else
 	{
@@ -4,7 +4,6 @@
 
 #include <functional>
 #include <vector>
-#include <deque>
 #include <memory>
 
 #include <cstdint>
@@ -48,7 +47,9 @@ namespace synthLib
 		uint32_t processResample(const TAudioOutputs& _output, uint32_t _numChannels, uint32_t _numSamples, const TProcessFunc& _processFunc);
 		uint32_t processResampleMame(const TAudioOutputs& _output, uint32_t _numChannels, uint32_t _numSamples, const TProcessFunc& _processFunc);
 		void ensureMameInput(uint32_t _numChannels, uint32_t _requiredInputSamples, const TProcessFunc& _processFunc);
-		void trimMameHistory(uint32_t _numChannels);
+		void trimMameHistory();
+		void reserveInput(uint32_t _numSamples);
+		float* getInput(const uint32_t _channel) { return m_input.data() + static_cast<size_t>(_channel) * m_inputCapacity; }
 		void destroyResamplers();
 		void setChannelCount(uint32_t _numChannels);
 		bool useMameResampler() const { return m_mode != Mode::Legacy; }
@@ -62,13 +63,19 @@ namespace synthLib
 		double m_inputLen = 0.0;
 
 		std::vector<void*> m_resamplerOut;
-		std::vector<std::unique_ptr<MameResampler>> m_mameResamplerOut;
-		std::vector<std::deque<float>> m_mameTempOutput;
+		std::unique_ptr<MameResampler> m_mameResampler;	// shared by all channels
+		MameSampleHistory m_mameHistory;
 		std::vector<std::vector<float>> m_mameInputTemp;
-		int64_t m_mameSourceBaseSample = 0;
 		uint64_t m_mameDestSample = 0;
 
-		std::vector< std::vector<float> > m_tempOutput;
+		uint32_t m_numChannels = 0;
+
+		// input of the legacy resamplers, all channels in one planar buffer with a fixed capacity per channel. Holds input
+		// that has been generated but not been consumed yet
+		std::vector<float> m_input;
+		uint32_t m_inputCapacity = 0;
+		uint32_t m_inputSize = 0;
+
 		TAudioOutputs m_outputPtrs;
 	};
 }
@@ -0,0 +1,99 @@
+#include "romData.h"
+
+#include <map>
+#include <mutex>
+
+#include "baseLib/filesystem.h"
+
+namespace synthLib
+{
+	namespace
+	{
+		template<typename TEntry>
+		class RomRegistry
+		{
+		public:
+			std::shared_ptr<const TEntry> get(std::vector<uint8_t>&& _data)
+			{
+				// hash outside of the lock, ROMs are up to a few megabytes
+				baseLib::MD5 hash(_data);
+
+				std::scoped_lock lock(m_mutex);
+
+				removeExpired();
+
+				auto& weak = m_entries[hash];
+
+				if(auto entry = weak.lock())
+					return entry;
+
+				auto entry = std::make_shared<const TEntry>(TEntry{hash, std::move(_data)});
+				weak = entry;
+				return entry;
+			}
+
+			size_t size()
+			{
+				std::scoped_lock lock(m_mutex);
+				removeExpired();
+				return m_entries.size();
+			}
+
+		private:
+			void removeExpired()
+			{
+				for(auto it = m_entries.begin(); it != m_entries.end();)
+				{
+					if(it->second.expired())
+						it = m_entries.erase(it);
+					else
+						++it;
+				}
+			}
+
+			std::mutex m_mutex;
+			std::map<baseLib::MD5, std::weak_ptr<const TEntry>> m_entries;
+		};
+
+		template<typename TEntry> RomRegistry<TEntry>& getRegistry()
+		{
+			static RomRegistry<TEntry> registry;
+			return registry;
+		}
+
+		const std::vector<uint8_t> g_empty;
+		const baseLib::MD5 g_emptyHash;
+	}
+
+	RomData::RomData(Buffer _data)
+	{
+		if(!_data.empty())
+			m_entry = getRegistry<Entry>().get(std::move(_data));
+	}
+
+	bool RomData::loadFromFile(const std::string& _filename)
+	{
+		Buffer data;
+
+		if(!baseLib::filesystem::readFile(data, _filename) || data.empty())
+			return false;
+
+		*this = RomData(std::move(data));
+		return true;
+	}
+
+	const RomData::Buffer& RomData::get() const
+	{
+		return m_entry ? m_entry->data : g_empty;
+	}
+
+	const baseLib::MD5& RomData::getHash() const
+	{
+		return m_entry ? m_entry->hash : g_emptyHash;
+	}
+
+	size_t RomData::getSharedCount()
+	{
+		return getRegistry<Entry>().size();
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "baseLib/md5.h"
+
+namespace synthLib
+{
+	// Immutable ROM contents. All instances with identical contents share one buffer per process, a ROM is released once
+	// the last instance that refers to it is destroyed. Emulators that write to flash need to copy the data first
+	class RomData
+	{
+	public:
+		using Buffer = std::vector<uint8_t>;
+
+		RomData() = default;
+		explicit RomData(Buffer _data);
+
+		template<typename TIt> void assign(TIt _begin, TIt _end)
+		{
+			*this = RomData(Buffer(_begin, _end));
+		}
+
+		// reads a file and shares the buffer with other users of the same contents
+		bool loadFromFile(const std::string& _filename);
+
+		void clear() { m_entry.reset(); }
+
+		const Buffer& get() const;
+		operator const Buffer& () const { return get(); }
+
+		const uint8_t* data() const { return get().data(); }
+		size_t size() const { return get().size(); }
+		bool empty() const { return get().empty(); }
+
+		Buffer::const_iterator begin() const { return get().begin(); }
+		Buffer::const_iterator end() const { return get().end(); }
+
+		uint8_t operator [] (const size_t _index) const { return get()[_index]; }
+
+		const baseLib::MD5& getHash() const;
+
+		// number of different ROMs that are currently in use in this process
+		static size_t getSharedCount();
+
+	private:
+		struct Entry
+		{
+			baseLib::MD5 hash;
+			Buffer data;
+		};
+
+		std::shared_ptr<const Entry> m_entry;
+	};
+}
@@ -0,0 +1,171 @@
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include "synthLib/resampler.h"
+#include "synthLib/romData.h"
+
+// Custom assertion that works in both Debug and Release builds
+#define TEST_ASSERT(condition) \
+	do { \
+		if (!(condition)) { \
+			std::ostringstream oss; \
+			oss << "Test assertion failed: " << #condition \
+			    << " at " << __FILE__ << ":" << __LINE__; \
+			throw std::runtime_error(oss.str()); \
+		} \
+	} while (0)
+
+namespace
+{
+	std::atomic<uint64_t> g_allocCount{0};
+}
+
+// count all heap allocations of this process to verify that code is allocation free
+void* operator new(const size_t _size)
+{
+	++g_allocCount;
+	if (void* p = std::malloc(_size ? _size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* _p) noexcept
+{
+	std::free(_p);
+}
+
+void operator delete(void* _p, size_t) noexcept
+{
+	std::free(_p);
+}
+
+void testResamplerAllocations()
+{
+	std::cout << "Testing Resampler allocations..." << std::endl;
+
+	constexpr uint32_t channelCount = 12;
+	constexpr uint32_t maxBlockSize = 512;
+
+	synthLib::Resampler resampler(46875.0f, 44100.0f);
+
+	std::vector<std::vector<float>> outputs(channelCount, std::vector<float>(maxBlockSize));
+
+	synthLib::TAudioOutputs outs{};
+	for (uint32_t c=0; c<channelCount; ++c)
+		outs[c] = outputs[c].data();
+
+	uint64_t inputSamples = 0;
+
+	const synthLib::Resampler::TProcessFunc processFunc = [&](synthLib::TAudioOutputs& _outs, const uint32_t _count)
+	{
+		for (uint32_t i=0; i<_count; ++i, ++inputSamples)
+		{
+			const auto v = std::sin(static_cast<float>(inputSamples) * 0.01f);
+			for (uint32_t c=0; c<channelCount; ++c)
+				_outs[c][i] = v;
+		}
+	};
+
+	// hosts do not always use the same block size
+	const uint32_t blockSizes[] = {maxBlockSize, 64, 1, 333, 128, maxBlockSize, 7};
+
+	uint64_t outputSamples = 0;
+
+	auto run = [&](const uint32_t _blocks)
+	{
+		for (uint32_t b=0; b<_blocks; ++b)
+		{
+			const auto count = blockSizes[b % std::size(blockSizes)];
+			TEST_ASSERT(resampler.process(outs, channelCount, count, false, processFunc) == count);
+			outputSamples += count;
+		}
+	};
+
+	// the first blocks allocate the resampler state
+	run(100);
+
+	const auto allocCount = g_allocCount.load();
+
+	run(10000);
+
+	TEST_ASSERT(g_allocCount.load() == allocCount);
+
+	// the generated input matches the requested output, except for the input that is buffered by the resampler
+	const auto expectedInput = static_cast<double>(outputSamples) * 46875.0 / 44100.0;
+	TEST_ASSERT(std::abs(static_cast<double>(inputSamples) - expectedInput) < 4096.0);
+
+	// all channels received the same input and produce the same output
+	for (uint32_t c=1; c<channelCount; ++c)
+		TEST_ASSERT(outputs[c] == outputs[0]);
+
+	std::cout << "  Resampler allocation tests passed!" << std::endl;
+}
+
+void testRomDataSharing()
+{
+	std::cout << "Testing RomData sharing..." << std::endl;
+
+	const std::vector<uint8_t> contentA(1024, 0x11);
+	const std::vector<uint8_t> contentB(1024, 0x22);
+
+	const auto sharedCount = synthLib::RomData::getSharedCount();
+
+	{
+		const synthLib::RomData a0(contentA);
+		const synthLib::RomData a1(contentA);
+		const synthLib::RomData b(contentB);
+
+		// identical contents share one buffer
+		TEST_ASSERT(a0.data() == a1.data());
+		TEST_ASSERT(a0.get() == contentA);
+		TEST_ASSERT(a0.getHash() == a1.getHash());
+
+		TEST_ASSERT(b.data() != a0.data());
+		TEST_ASSERT(b.getHash() != a0.getHash());
+
+		TEST_ASSERT(synthLib::RomData::getSharedCount() == sharedCount + 2);
+
+		{
+			// copies share the buffer too, the ROM stays registered as long as one of them exists
+			auto a2 = a0;
+			TEST_ASSERT(a2.data() == a0.data());
+			a2.clear();
+			TEST_ASSERT(a2.empty());
+		}
+
+		TEST_ASSERT(synthLib::RomData::getSharedCount() == sharedCount + 2);
+	}
+
+	// released once the last user is gone
+	TEST_ASSERT(synthLib::RomData::getSharedCount() == sharedCount);
+
+	// empty data is not registered
+	const synthLib::RomData empty{std::vector<uint8_t>()};
+	TEST_ASSERT(empty.empty());
+	TEST_ASSERT(synthLib::RomData::getSharedCount() == sharedCount);
+
+	std::cout << "  RomData sharing tests passed!" << std::endl;
+}
+
+int main()
+{
+	try
+	{
+		testResamplerAllocations();
+		testRomDataSharing();
+
+		std::cout << "All tests passed!" << std::endl;
+		return 0;
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "Test failed: " << e.what() << std::endl;
+		return 1;
+	}
+}
@@ -69,7 +69,7 @@ void ConsoleApp::waitReturn()
 
 void ConsoleApp::bootDSP(const bool _createDebugger) const
 {
-	virusLib::Device::bootDSPs(m_dsp1.get(), m_dsp2, m_rom, _createDebugger);
+	virusLib::Device::bootDSPs(m_dsp1.get(), m_dsp2, m_rom, _createDebugger, m_bootSnapshotFile, static_cast<float>(m_rom.getSamplerate()));
 }
 
 dsp56k::IPeripherals& ConsoleApp::getYPeripherals() const
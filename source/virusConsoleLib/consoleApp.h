@@ -29,6 +29,9 @@ public:
 
 	const virusLib::ROMFile& getRom() const { return m_rom; }
 
+	// see virusLib::DspBootSnapshot, the DSPs are booted from the snapshot if it exists or create it otherwise
+	void setBootSnapshotFile(const std::string& _filename) { m_bootSnapshotFile = _filename; }
+
 private:
 
 	void bootDSP(bool _createDebugger) const;
@@ -37,6 +40,7 @@ private:
 	void destroy();
 
 	const std::string m_romName;
+	std::string m_bootSnapshotFile;
 	virusLib::ROMFile m_rom;
 	std::unique_ptr<virusLib::DspSingle> m_dsp1;
 	virusLib::DspSingle* m_dsp2 = nullptr;
@@ -2,6 +2,7 @@
 
 #include "integrationTest.h"
 
+#include <cstring>
 #include <fstream>
 #include <utility>
 
@@ -14,6 +15,7 @@
 
 #include "synthLib/wavReader.h"
 
+#include "virusLib/device.h"
 #include "virusLib/romloader.h"
 
 namespace synthLib
@@ -21,6 +23,203 @@ namespace synthLib
 	class WavReader;
 }
 
+namespace
+{
+#if !SYNTHLIB_DEMO_MODE
+	// Microcontroller with DSPs that are not booted. Presets are not confirmed by the DSP and stay in the pending queue
+	struct MicrocontrollerInstance
+	{
+		explicit MicrocontrollerInstance(const virusLib::ROMFile& _rom)
+		{
+			virusLib::DspSingle* dspA = nullptr;
+			virusLib::DspSingle* dspB = nullptr;
+			virusLib::Device::createDspInstances(dspA, dspB, _rom, static_cast<float>(_rom.getSamplerate()));
+			dsp.reset(dspA);
+
+			uc.reset(new virusLib::Microcontroller(*dspA, _rom, false));
+			if(dspB)
+				uc->addDSP(*dspB, false);
+		}
+
+		std::unique_ptr<virusLib::DspSingle> dsp;
+		std::unique_ptr<virusLib::Microcontroller> uc;
+	};
+
+	bool isPendingPreset(const virusLib::Microcontroller::SPendingPresetWrite& _write, const uint8_t _program, const bool _isMulti, const virusLib::Microcontroller::TPreset& _data)
+	{
+		return _write.program == _program && _write.isMulti == _isMulti && _write.data == _data;
+	}
+
+	// Saves the binary state of a microcontroller and restores it into a fresh one. The restored state needs to be
+	// identical and the presets of the stored play mode need to be queued for the DSP
+	int testBinaryStateRoundtrip(const virusLib::ROMFile& _rom, const bool _multiMode)
+	{
+		using namespace virusLib;
+
+		Microcontroller::TPreset single;
+		Microcontroller::TPreset multi;
+
+		if(!_rom.getSingle(0, 1, single) || !_rom.getMulti(1, multi))
+		{
+			std::cout << "Failed to read presets from ROM for binary state test" << '\n';
+			return -1;
+		}
+
+		// modify RAM banks and edit buffers so that they differ from what a fresh instance has
+		single[241] = 'X';
+		multi[100] ^= 1;
+
+		MicrocontrollerInstance src(_rom);
+
+		src.uc->writeSingle(BankNumber::B, 7, single);
+		src.uc->writeMulti(BankNumber::A, 5, multi);
+
+		if(_multiMode)
+			src.uc->writeMulti(BankNumber::EditBuffer, 0, multi);
+		else
+			src.uc->writeSingle(BankNumber::EditBuffer, SINGLE, single);
+
+		std::vector<uint8_t> state;
+		if(!src.uc->getBinaryState(state) || !Microcontroller::isBinaryState(state))
+		{
+			std::cout << "Failed to create binary state" << '\n';
+			return -1;
+		}
+
+		MicrocontrollerInstance dst(_rom);
+
+		std::vector<uint8_t> initialState;
+		dst.uc->getBinaryState(initialState);
+
+		// a state of a different version or with missing data is rejected without modifying anything. The chunk is
+		// 4CC, version, length, data
+		auto wrongVersion = state;
+		++wrongVersion[4];
+
+		auto truncated = state;
+		truncated.pop_back();
+		uint32_t length;
+		memcpy(&length, &truncated[8], sizeof(length));
+		--length;
+		memcpy(&truncated[8], &length, sizeof(length));
+
+		if(dst.uc->setBinaryState(wrongVersion) || dst.uc->setBinaryState(truncated))
+		{
+			std::cout << "Binary state with wrong version or size has not been rejected" << '\n';
+			return -1;
+		}
+
+		std::vector<uint8_t> unchangedState;
+		dst.uc->getBinaryState(unchangedState);
+
+		if(unchangedState != initialState || !dst.uc->getPendingPresetWrites().empty())
+		{
+			std::cout << "Rejected binary state has modified the microcontroller" << '\n';
+			return -1;
+		}
+
+		if(!dst.uc->setBinaryState(state))
+		{
+			std::cout << "Failed to restore binary state" << '\n';
+			return -1;
+		}
+
+		std::vector<uint8_t> restoredState;
+		dst.uc->getBinaryState(restoredState);
+
+		if(restoredState != state)
+		{
+			std::cout << "Restored binary state differs from the saved one, " << (_multiMode ? "multi" : "single") << " mode" << '\n';
+			return -1;
+		}
+
+		const auto& pending = dst.uc->getPendingPresetWrites();
+
+		bool pendingValid;
+
+		if(_multiMode)
+		{
+			Microcontroller::TPreset part;
+
+			pendingValid = pending.size() == 1 + dst.uc->getPartCount() && isPendingPreset(pending.front(), 0, true, multi);
+
+			auto it = std::next(pending.begin());
+			for(uint8_t p=0; pendingValid && p<dst.uc->getPartCount(); ++p, ++it)
+			{
+				// the parts have not been changed, they are still the ones from the first ROM bank
+				pendingValid = _rom.getSingle(0, p, part) && isPendingPreset(*it, p, false, part);
+			}
+		}
+		else
+		{
+			pendingValid = pending.size() == 1 && isPendingPreset(pending.front(), SINGLE, false, single);
+		}
+
+		if(!pendingValid)
+		{
+			std::cout << "Presets queued for the DSP after restoring the binary state are not the ones of the saved state, " << (_multiMode ? "multi" : "single") << " mode" << '\n';
+			return -1;
+		}
+
+		return 0;
+	}
+
+	int testBinaryState(const std::string& _romFile)
+	{
+		const auto rom = virusLib::ROMLoader::findROM(_romFile);
+
+		if(!rom.isValid())
+		{
+			std::cout << "Failed to load ROM " << _romFile << " for binary state test" << '\n';
+			return -1;
+		}
+
+		if(const auto res = testBinaryStateRoundtrip(rom, false))
+			return res;
+		if(const auto res = testBinaryStateRoundtrip(rom, true))
+			return res;
+
+		std::cout << "Binary state test successful, ROM " << baseLib::filesystem::getFilenameWithoutPath(_romFile) << '\n';
+		return 0;
+	}
+#endif
+
+	// Runs a test with a cold booted DSP and then with a DSP that has been booted from a boot snapshot. If the snapshot
+	// does not exist yet, the second run creates it and a third run boots from it. All runs need to match the reference
+	int runTest(const baseLib::CommandLine& _cmd, const std::string& _romFile, const std::string& _preset, const std::string& _outputFolder, const std::string& _bootSnapshotFile)
+	{
+		{
+			IntegrationTest test(_cmd, _romFile, _preset, _outputFolder, virusLib::DeviceModel::Snow);
+			if(const auto res = test.run())
+				return res;
+		}
+
+		// reference files are created with a cold boot only
+		if(_cmd.contains("length") || _bootSnapshotFile.empty())
+			return 0;
+
+		const auto runCount = baseLib::filesystem::exists(_bootSnapshotFile) ? 1 : 2;
+
+		for(int i=0; i<runCount; ++i)
+		{
+			IntegrationTest test(_cmd, _romFile, _preset, _outputFolder, virusLib::DeviceModel::Snow, _bootSnapshotFile);
+
+			if(const auto res = test.run())
+			{
+				std::cout << "Test failed with DSP boot snapshot " << _bootSnapshotFile << '\n';
+				return res;
+			}
+
+			if(!baseLib::filesystem::exists(_bootSnapshotFile))
+			{
+				std::cout << "No DSP boot snapshot has been created for ROM " << _romFile << ", skipping boot snapshot test" << '\n';
+				return 0;
+			}
+		}
+		return 0;
+	}
+}
+
 int main(int _argc, char* _argv[])
 {
 	if constexpr (true)
@@ -57,9 +256,17 @@ int main(int _argc, char* _argv[])
 				const auto romFile = cmd.get("rom");
 				const auto preset = cmd.get("preset");
 
-				IntegrationTest test(cmd, romFile, preset, std::string(), virusLib::DeviceModel::Snow);
+#if !SYNTHLIB_DEMO_MODE
+				if(const auto res = testBinaryState(romFile))
+					return res;
+#endif
+
+				const std::string bootSnapshotFile = "integrationTest_bootSnapshot.bin";
+				baseLib::filesystem::remove(bootSnapshotFile);
+
+				const auto res = runTest(cmd, romFile, preset, std::string(), bootSnapshotFile);
+				baseLib::filesystem::remove(bootSnapshotFile);
 
-				const auto res = test.run();
 				if(0 == res)
 					std::cout << "test successful, ROM " << baseLib::filesystem::getFilenameWithoutPath(romFile) << ", preset " << preset << '\n';
 				return res;
@@ -148,13 +355,26 @@ int main(int _argc, char* _argv[])
 						return -1;
 					}
 
+#if !SYNTHLIB_DEMO_MODE
+					if(testBinaryState(romFile) != 0)
+						return -1;
+#endif
+
+					// the first preset creates the boot snapshot, all others boot from it
+					const auto bootSnapshotFile = subfolder + "/integrationTest_bootSnapshot.bin";
+					baseLib::filesystem::remove(bootSnapshotFile);
+
 					for (auto& preset : presets)
 					{
-						IntegrationTest test(cmd, romFile, preset, subfolder + '/', virusLib::DeviceModel::Snow);
-						if(test.run() != 0)
+						if(runTest(cmd, romFile, preset, subfolder + '/', bootSnapshotFile) != 0)
+						{
+							baseLib::filesystem::remove(bootSnapshotFile);
 							return -1;
+						}
 						finishedTests.emplace_back(romFile, preset);
 					}
+
+					baseLib::filesystem::remove(bootSnapshotFile);
 				}
 
 				if(!forever)
@@ -176,13 +396,14 @@ int main(int _argc, char* _argv[])
 	}
 }
 
-IntegrationTest::IntegrationTest(const baseLib::CommandLine& _commandLine, std::string _romFile, std::string _presetName, std::string _outputFolder, const virusLib::DeviceModel _tiModel)
+IntegrationTest::IntegrationTest(const baseLib::CommandLine& _commandLine, std::string _romFile, std::string _presetName, std::string _outputFolder, const virusLib::DeviceModel _tiModel, const std::string& _bootSnapshotFile/* = {}*/)
 	: m_cmd(_commandLine)
 	, m_romFile(std::move(_romFile))
 	, m_presetName(std::move(_presetName))
 	, m_outputFolder(std::move(_outputFolder))
 	, m_app(m_romFile, _tiModel)
 {
+	m_app.setBootSnapshotFile(_bootSnapshotFile);
 }
 
 int IntegrationTest::run()
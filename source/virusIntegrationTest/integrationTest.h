@@ -12,7 +12,7 @@ namespace baseLib
 class IntegrationTest
 {
 public:
-	explicit IntegrationTest(const baseLib::CommandLine& _commandLine, std::string _romFile, std::string _presetName, std::string _outputFolder, virusLib::DeviceModel _tiModel);
+	explicit IntegrationTest(const baseLib::CommandLine& _commandLine, std::string _romFile, std::string _presetName, std::string _outputFolder, virusLib::DeviceModel _tiModel, const std::string& _bootSnapshotFile = {});
 
 	int run();
 
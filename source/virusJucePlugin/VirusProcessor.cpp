@@ -89,6 +89,11 @@ namespace virus
 	{
 		synthLib::DeviceCreateParams p;
 		getRemoteDeviceParams(p);
+
+		// opt-in: store post-boot DSP snapshots to speed up creation of further instances
+		if(getConfig().getBoolValue("dspBootSnapshot", false))
+			p.homePath = getDataFolder();
+
 		return new virusLib::Device(p, true);
 	}
 
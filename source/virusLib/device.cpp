@@ -11,6 +11,7 @@
 
 #include <cstring>
 
+#include "dspBootSnapshot.h"
 #include "dspMemoryPatches.h"
 
 #include "baseLib/filesystem.h"
@@ -38,7 +39,10 @@ namespace virusLib
 		if(m_dsp2)
 			m_mc->addDSP(*m_dsp2, true);
 
-		bootDSPs(m_dsp.get(), m_dsp2, m_rom, _createDebugger);
+		// boot snapshots are opt-in, they are only used if the host provides a folder to store them
+		const auto snapshotFile = _params.homePath.empty() ? std::string() : DspBootSnapshot::getFilename(_params.homePath + "/bootSnapshots/", m_rom, m_samplerate);
+
+		bootDSPs(m_dsp.get(), m_dsp2, m_rom, _createDebugger, snapshotFile, m_samplerate);
 
 //		m_dsp->getMemory().saveAssembly("P.asm", 0, m_dsp->getMemory().sizeP(), true, false, m_dsp->getDSP().getPeriph(0), m_dsp->getDSP().getPeriph(1));
 
@@ -633,24 +637,44 @@ namespace virusLib
 		jit.setConfig(conf);
 	}
 
-	std::thread Device::bootDSP(DspSingle& _dsp, const ROMFile& _rom, const bool _createDebugger)
+	std::thread Device::bootDSP(DspSingle& _dsp, const ROMFile& _rom, const bool _createDebugger, const std::string& _snapshotFile/* = {}*/, const float _samplerate/* = 0.0f*/)
 	{
-		auto res = _rom.bootDSP(_dsp);
+		std::thread res;
+
+		if(_snapshotFile.empty())
+		{
+			res = _rom.bootDSP(_dsp);
+		}
+		else
+		{
+			DspBootSnapshot snapshot;
+
+			if(!snapshot.load(_snapshotFile, _rom, _samplerate) || !snapshot.restore(_dsp))
+			{
+				res = snapshot.capture(_dsp, _rom, _samplerate);
+
+				if(snapshot.isValid() && !snapshot.save(_snapshotFile))
+					LOG("Failed to write boot snapshot " << _snapshotFile);
+			}
+		}
+
 		_dsp.startDSPThread(_createDebugger);
 		return res;
 	}
 
-	void Device::bootDSPs(DspSingle* _dspA, DspSingle* _dspB, const ROMFile& _rom, bool _createDebugger)
+	void Device::bootDSPs(DspSingle* _dspA, DspSingle* _dspB, const ROMFile& _rom, bool _createDebugger, const std::string& _snapshotFile/* = {}*/, const float _samplerate/* = 0.0f*/)
 	{
-		auto loader = bootDSP(*_dspA, _rom, _createDebugger);
+		auto loader = bootDSP(*_dspA, _rom, _createDebugger, _snapshotFile, _samplerate);
 
 		if(_dspB)
 		{
-			auto loader2 = bootDSP(*_dspB, _rom, false);
-			loader2.join();
+			auto loader2 = bootDSP(*_dspB, _rom, false, _snapshotFile, _samplerate);
+			if(loader2.joinable())
+				loader2.join();
 		}
 
-		loader.join();
+		if(loader.joinable())
+			loader.join();
 
 //		applyDspMemoryPatches(_dspA, _dspB, _rom);
 	}
@@ -49,8 +49,8 @@ namespace virusLib
 		uint32_t getChannelCountOut() override;
 
 		static void createDspInstances(DspSingle*& _dspA, DspSingle*& _dspB, const ROMFile& _rom, float _samplerate);
-		static std::thread bootDSP(DspSingle& _dsp, const ROMFile& _rom, bool _createDebugger);
-		static void bootDSPs(DspSingle* _dspA, DspSingle* _dspB, const ROMFile& _rom, bool _createDebugger);
+		static std::thread bootDSP(DspSingle& _dsp, const ROMFile& _rom, bool _createDebugger, const std::string& _snapshotFile = {}, float _samplerate = 0.0f);
+		static void bootDSPs(DspSingle* _dspA, DspSingle* _dspB, const ROMFile& _rom, bool _createDebugger, const std::string& _snapshotFile = {}, float _samplerate = 0.0f);
 		
 		bool setDspClockPercent(uint32_t _percent) override;
 		uint32_t getDspClockPercent() const override;
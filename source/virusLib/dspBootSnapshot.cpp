@@ -0,0 +1,255 @@
+#include "dspBootSnapshot.h"
+
+#include "dspSingle.h"
+#include "romfile.h"
+
+#include "baseLib/binarystream.h"
+#include "baseLib/filesystem.h"
+
+#include "synthLib/buildconfig.h"
+
+#include "dsp56kEmu/dsp.h"
+
+#include "dsp56kBase/logging.h"
+
+namespace virusLib
+{
+	namespace
+	{
+		// unmodified words between two modified ones that are stored anyway to keep the number of ranges low
+		constexpr dsp56k::TWord g_maxRangeGap = 16;
+
+		// number of instructions the boot loader may execute after the command stream has been consumed
+		constexpr uint32_t g_maxStepsAfterCommandStream = 1'000'000;
+
+		// a snapshot is the result of running the loader on the emulated DSP, snapshots of other emulator builds are not used
+		const std::string g_buildVersion = SYNTHLIB_BUILD_VERSION;
+	}
+
+	std::string DspBootSnapshot::getFilename(const std::string& _folder, const ROMFile& _rom, const float _samplerate)
+	{
+		return baseLib::filesystem::validatePath(_folder) + "virusBoot_" + g_buildVersion + '_' + _rom.getHash().toString() + '_' +
+			std::to_string(static_cast<uint32_t>(_rom.getModel())) + '_' +
+			std::to_string(static_cast<uint32_t>(_samplerate)) + ".bin";
+	}
+
+	std::thread DspBootSnapshot::capture(DspSingle& _dsp, const ROMFile& _rom, const float _samplerate)
+	{
+		m_valid = false;
+
+		auto& dsp = _dsp.getDSP();
+		auto& mem = _dsp.getMemory();
+
+		// memory of the DSP before booting, the snapshot only stores the difference
+		std::array<std::vector<dsp56k::TWord>, dsp56k::MemArea_COUNT> initialMem;
+
+		for(uint32_t a=0; a<dsp56k::MemArea_COUNT; ++a)
+		{
+			const auto area = static_cast<dsp56k::EMemArea>(a);
+			m_memSize[a] = mem.size(area);
+			initialMem[a].resize(m_memSize[a]);
+			for(dsp56k::TWord i=0; i<m_memSize[a]; ++i)
+				initialMem[a][i] = mem.get(area, i);
+		}
+
+		auto loader = _rom.bootDSP(_dsp);
+
+		const auto& bootRom = _rom.getBootRom();
+
+		auto isInBootRom = [&](const dsp56k::TWord _pc)
+		{
+			return _pc >= bootRom.offset && _pc < bootRom.offset + bootRom.size;
+		};
+
+		uint32_t stepsAfterCommandStream = 0;
+
+		while(isInBootRom(dsp.getPC()) || !_dsp.isCommandStreamConsumed())
+		{
+			// If the loader leaves the boot ROM before the command stream has been consumed or does not leave it at all,
+			// there is no clean point to take a snapshot. Let the DSP thread continue to boot normally
+			if(!isInBootRom(dsp.getPC()))
+			{
+				LOG("Boot loader left the boot ROM before the command stream has been consumed, unable to create boot snapshot");
+				return loader;
+			}
+
+			if(_dsp.isCommandStreamConsumed() && ++stepsAfterCommandStream > g_maxStepsAfterCommandStream)
+			{
+				LOG("Boot loader did not jump to the firmware, unable to create boot snapshot");
+				return loader;
+			}
+
+			dsp.exec();
+		}
+
+		m_entry = dsp.getPC();
+
+		for(uint32_t a=0; a<dsp56k::MemArea_COUNT; ++a)
+		{
+			const auto area = static_cast<dsp56k::EMemArea>(a);
+			const auto& initial = initialMem[a];
+
+			auto& ranges = m_ranges[a];
+			ranges.clear();
+
+			Range* range = nullptr;
+			dsp56k::TWord lastModified = 0;
+
+			for(dsp56k::TWord i=0; i<m_memSize[a]; ++i)
+			{
+				const auto v = mem.get(area, i);
+
+				if(v == initial[i])
+					continue;
+
+				if(!range || i - lastModified > g_maxRangeGap)
+				{
+					range = &ranges.emplace_back();
+					range->first = i;
+				}
+
+				for(auto j = range->first + static_cast<dsp56k::TWord>(range->data.size()); j < i; ++j)
+					range->data.push_back(mem.get(area, j));
+
+				range->data.push_back(v);
+				lastModified = i;
+			}
+		}
+
+		m_romHash = _rom.getHash();
+		m_model = static_cast<uint32_t>(_rom.getModel());
+		m_samplerate = static_cast<uint32_t>(_samplerate);
+		m_valid = true;
+
+		return loader;
+	}
+
+	bool DspBootSnapshot::restore(DspSingle& _dsp) const
+	{
+		if(!m_valid)
+			return false;
+
+		auto& dsp = _dsp.getDSP();
+		auto& mem = _dsp.getMemory();
+
+		for(uint32_t a=0; a<dsp56k::MemArea_COUNT; ++a)
+		{
+			if(mem.size(static_cast<dsp56k::EMemArea>(a)) != m_memSize[a])
+				return false;
+		}
+
+		for(uint32_t a=0; a<dsp56k::MemArea_COUNT; ++a)
+		{
+			const auto area = static_cast<dsp56k::EMemArea>(a);
+
+			for (const auto& range : m_ranges[a])
+			{
+				for(size_t i=0; i<range.data.size(); ++i)
+				{
+					const auto addr = range.first + static_cast<dsp56k::TWord>(i);
+
+					if(area == dsp56k::MemArea_P)
+						dsp.memWriteP(addr, range.data[i]);
+					else
+						dsp.memWrite(area, addr, range.data[i]);
+				}
+			}
+		}
+
+		dsp.setPC(m_entry);
+
+		return true;
+	}
+
+	bool DspBootSnapshot::save(const std::string& _filename) const
+	{
+		if(!m_valid)
+			return false;
+
+		baseLib::BinaryStream s;
+
+		{
+			baseLib::ChunkWriter cw(s, "VBSS", 2);
+
+			s.write(g_buildVersion);
+			s.write(m_romHash);
+			s.write(m_model);
+			s.write(m_samplerate);
+			s.write(m_entry);
+
+			for(uint32_t a=0; a<dsp56k::MemArea_COUNT; ++a)
+			{
+				s.write(m_memSize[a]);
+				s.write(static_cast<uint32_t>(m_ranges[a].size()));
+
+				for (const auto& range : m_ranges[a])
+				{
+					s.write(range.first);
+					s.write(range.data);
+				}
+			}
+		}
+
+		std::vector<uint8_t> data;
+		s.toVector(data);
+
+		baseLib::filesystem::createDirectory(baseLib::filesystem::getPath(_filename));
+
+		// another instance may read the file while it is written
+		return baseLib::filesystem::writeFileAtomic(_filename, data);
+	}
+
+	bool DspBootSnapshot::load(const std::string& _filename, const ROMFile& _rom, const float _samplerate)
+	{
+		m_valid = false;
+
+		std::vector<uint8_t> data;
+
+		if(!baseLib::filesystem::readFile(data, _filename))
+			return false;
+
+		try
+		{
+			baseLib::BinaryStream stream(data);
+
+			auto s = stream.tryReadChunk("VBSS", 2);
+
+			if(!s)
+				return false;
+
+			if(s.readString() != g_buildVersion)
+				return false;
+
+			s.read(m_romHash);
+			s.read(m_model);
+			s.read(m_samplerate);
+
+			if(m_romHash != _rom.getHash() || m_model != static_cast<uint32_t>(_rom.getModel()) || m_samplerate != static_cast<uint32_t>(_samplerate))
+				return false;
+
+			s.read(m_entry);
+
+			for(uint32_t a=0; a<dsp56k::MemArea_COUNT; ++a)
+			{
+				s.read(m_memSize[a]);
+
+				auto& ranges = m_ranges[a];
+				ranges.resize(s.read<uint32_t>());
+
+				for (auto& range : ranges)
+				{
+					s.read(range.first);
+					s.read(range.data);
+				}
+			}
+		}
+		catch(std::range_error& e)
+		{
+			LOG("Failed to load boot snapshot " << _filename << ": " << e.what());
+			return false;
+		}
+
+		m_valid = true;
+		return true;
+	}
+}
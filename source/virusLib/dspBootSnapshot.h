@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "baseLib/md5.h"
+
+#include "dsp56kEmu/types.h"
+
+namespace virusLib
+{
+	class DspSingle;
+	class ROMFile;
+
+	// Memory image of a DSP at the point where the boot loader has consumed the whole command stream and jumps into the
+	// firmware. Restoring it skips the HDI08 transfer of the command stream and the execution of the boot loader.
+	// Only the memory that has been modified by the boot loader is stored, the firmware initializes registers and
+	// peripherals itself once it is running. virusIntegrationTest verifies that a DSP booted from a snapshot produces the
+	// same output as a cold booted one. A snapshot is only valid for the emulator build that created it
+	class DspBootSnapshot
+	{
+	public:
+		struct Range
+		{
+			dsp56k::TWord first = 0;
+			std::vector<dsp56k::TWord> data;
+		};
+
+		static std::string getFilename(const std::string& _folder, const ROMFile& _rom, float _samplerate);
+
+		// Boots the DSP on the calling thread until the firmware is entered. If no clean point to take the snapshot is
+		// found, the snapshot is invalid and the DSP continues to boot normally once its thread is started.
+		// Returns the thread that waits for the command stream to be consumed, same as ROMFile::bootDSP
+		std::thread capture(DspSingle& _dsp, const ROMFile& _rom, float _samplerate);
+
+		bool restore(DspSingle& _dsp) const;
+
+		bool save(const std::string& _filename) const;
+		bool load(const std::string& _filename, const ROMFile& _rom, float _samplerate);
+
+		bool isValid() const { return m_valid; }
+
+	private:
+		baseLib::MD5 m_romHash;
+		uint32_t m_model = 0;
+		uint32_t m_samplerate = 0;
+
+		dsp56k::TWord m_entry = 0;
+		std::array<dsp56k::TWord, dsp56k::MemArea_COUNT> m_memSize{};
+		std::array<std::vector<Range>, dsp56k::MemArea_COUNT> m_ranges;
+
+		bool m_valid = false;
+	};
+}
@@ -42,6 +42,7 @@ namespace virusLib
 		void drainESSI1();
 
 		std::thread boot(const ROMFile::BootRom& _bootRom, const std::vector<dsp56k::TWord>& _commandStream);
+		bool isCommandStreamConsumed() const { return m_commandStreamReadIndex >= m_commandStream.size(); }
 
 		template<typename T> static void ensureSize(std::vector<T>& _buf, size_t _size)
 		{
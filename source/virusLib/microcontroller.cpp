@@ -9,6 +9,8 @@
 #include "frontpanelState.h"
 #include "synthLib/midiTypes.h"
 
+#include "baseLib/binarystream.h"
+
 using namespace dsp56k;
 using namespace synthLib;
 
@@ -22,6 +24,9 @@ constexpr uint32_t g_sysexPresetFooterSize = 2;	// checksum, f7
 
 constexpr uint32_t g_singleRamBankCount = 2;
 
+constexpr char g_binaryStateChunk[] = "MCST";
+constexpr uint32_t g_binaryStateVersion = 1;
+
 const std::set<uint8_t> g_pageA = {0x05, 0x0A, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D,
                                    0x1E, 0x1F, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x2B, 0x2C, 0x2D,
                                    0x2E, 0x2F, 0x30, 0x31, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D,
@@ -1111,6 +1116,9 @@ void Microcontroller::process()
 #if !SYNTHLIB_DEMO_MODE
 bool Microcontroller::getState(std::vector<unsigned char>& _state, const StateType _type)
 {
+	if(_type == StateTypeGlobal)
+		return getBinaryState(_state);
+
 	const auto deviceId = static_cast<uint8_t>(m_globalSettings[DEVICE_ID]);
 
 	std::vector<SMidiEvent> responses;
@@ -1134,6 +1142,9 @@ bool Microcontroller::getState(std::vector<unsigned char>& _state, const StateTy
 
 bool Microcontroller::setState(const std::vector<unsigned char>& _state, const StateType _type)
 {
+	if(isBinaryState(_state))
+		return setBinaryState(_state);
+
 	std::vector<SMidiEvent> events;
 
 	for(size_t i=0; i<_state.size(); ++i)
@@ -1186,6 +1197,138 @@ bool Microcontroller::setState(const std::vector<synthLib::SMidiEvent>& _events)
 
 	return true;
 }
+
+bool Microcontroller::getBinaryState(std::vector<unsigned char>& _state)
+{
+	std::lock_guard lock(m_mutex);
+
+	receiveUpgradedPreset();
+
+	baseLib::BinaryStream s;
+
+	{
+		baseLib::ChunkWriter cw(s, g_binaryStateChunk, g_binaryStateVersion);
+
+		s.write(m_globalSettings);
+
+		const auto ramBankCount = std::min(static_cast<uint32_t>(m_singles.size()), g_singleRamBankCount);
+
+		s.write(ramBankCount);
+		for(uint32_t b=0; b<ramBankCount; ++b)
+			s.write(m_singles[b]);
+
+		s.write(m_multis);
+		s.write(m_multiEditBuffer);
+		s.write(m_singleEditBuffers);
+		s.write(m_singleEditBuffer);
+		s.write(m_currentBank);
+		s.write(m_currentSingle);
+	}
+
+	s.toVector(_state, true);
+	return true;
+}
+
+bool Microcontroller::setBinaryState(const std::vector<unsigned char>& _state)
+{
+	std::array<uint32_t, 256> globalSettings;
+	std::vector<std::vector<TPreset>> ramBanks;
+	std::array<TPreset,128> multis;
+	TPreset multiEditBuffer;
+	std::array<TPreset,16> singleEditBuffers;
+	TPreset singleEditBuffer;
+	uint8_t currentBank;
+	uint8_t currentSingle;
+
+	try
+	{
+		baseLib::BinaryStream stream(_state);
+
+		auto s = stream.tryReadChunk(g_binaryStateChunk, g_binaryStateVersion);
+
+		if(!s)
+			return false;
+
+		s.read(globalSettings);
+
+		const auto ramBankCount = s.read<uint32_t>();
+		if(ramBankCount > g_singleRamBankCount)
+			return false;
+
+		ramBanks.resize(ramBankCount);
+		for (auto& bank : ramBanks)
+			s.read(bank);
+
+		s.read(multis);
+		s.read(multiEditBuffer);
+		s.read(singleEditBuffers);
+		s.read(singleEditBuffer);
+		s.read(currentBank);
+		s.read(currentSingle);
+	}
+	catch(std::range_error& e)
+	{
+		LOG("Failed to read binary state: " << e.what());
+		return false;
+	}
+
+	std::lock_guard lock(m_mutex);
+
+	// tables that are not sent to the DSP are copied as they are
+	for(size_t b=0; b<ramBanks.size() && b<m_singles.size() && b<g_singleRamBankCount; ++b)
+	{
+		auto& dst = m_singles[b];
+		const auto& src = ramBanks[b];
+		std::copy_n(src.begin(), std::min(src.size(), dst.size()), dst.begin());
+	}
+
+	m_multis = multis;
+	m_currentBank = m_singles.empty() ? 0 : static_cast<uint8_t>(currentBank % m_singles.size());
+	m_currentSingle = currentSingle;
+
+	// send global settings to the DSP. Unlike the sysex based restore, this does not trigger program changes, the edit
+	// buffers are restored below
+	const auto page = globalSettingsPage();
+
+	for(uint32_t i=0; i<globalSettings.size(); ++i)
+	{
+		if(i != PLAY_MODE && globalSettings[i] <= 0xff)
+			send(page, 0, static_cast<uint8_t>(i), static_cast<uint8_t>(globalSettings[i]));
+	}
+
+	const auto playMode = static_cast<uint8_t>(globalSettings[PLAY_MODE] <= 0xff ? globalSettings[PLAY_MODE] : g_defaultPlayMode);
+
+	send(page, 0, PLAY_MODE, playMode);
+
+	// only the presets that are active in the current play mode are uploaded. All edit buffers are restored first,
+	// including parts that the model does not have
+	m_multiEditBuffer = multiEditBuffer;
+	m_singleEditBuffers = singleEditBuffers;
+	m_singleEditBuffer = singleEditBuffer;
+
+	m_loadingState = true;
+
+	if(playMode == PlayModeSingle)
+	{
+		writeSingle(BankNumber::EditBuffer, SINGLE, singleEditBuffer);
+	}
+	else
+	{
+		writeMulti(BankNumber::EditBuffer, 0, multiEditBuffer);
+
+		for(uint8_t p=0; p<getPartCount(); ++p)
+			writeSingle(BankNumber::EditBuffer, p, singleEditBuffers[p]);
+	}
+
+	m_loadingState = false;
+
+	return true;
+}
+
+bool Microcontroller::isBinaryState(const std::vector<unsigned char>& _state)
+{
+	return _state.size() > 4 && memcmp(_state.data(), g_binaryStateChunk, 4) == 0;
+}
 #endif
 
 void Microcontroller::addDSP(DspSingle& _dsp, bool _useEsaiBasedMidiTiming)
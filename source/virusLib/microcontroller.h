@@ -46,6 +46,12 @@ public:
 	bool getState(std::vector<unsigned char>& _state, synthLib::StateType _type);
 	bool setState(const std::vector<unsigned char>& _state, synthLib::StateType _type);
 	bool setState(const std::vector<synthLib::SMidiEvent>& _events);
+
+	// binary state, contains the global settings, RAM banks and edit buffers. Faster to restore than the sysex based
+	// state which is still used for the current program state for interchange
+	bool getBinaryState(std::vector<unsigned char>& _state);
+	bool setBinaryState(const std::vector<unsigned char>& _state);
+	static bool isBinaryState(const std::vector<unsigned char>& _state);
 #endif
 
 	void addDSP(DspSingle& _dsp, bool _useEsaiBasedMidiTiming);
@@ -72,6 +78,16 @@ public:
 	uint8_t getPartMidiChannel(uint8_t _part) const;
 	bool isPolyPressureForPageBEnabled() const;
 
+	// Device does not like if we send everything at once, therefore we delay the send of Singles after sending a Multi
+	struct SPendingPresetWrite
+	{
+		uint8_t program = 0;
+		bool isMulti = false;
+		TPreset data;
+	};
+
+	const std::list<SPendingPresetWrite>& getPendingPresetWrites() const { return m_pendingPresetWrites; }
+
 private:
 	bool send(Page page, uint8_t part, uint8_t param, uint8_t value);
 	void sendControlCommand(ControlCommand command, uint8_t value);
@@ -121,14 +137,6 @@ private:
 	uint8_t m_sentPresetProgram = 0xff;
 	bool m_sentPresetIsMulti = false;
 
-	// Device does not like if we send everything at once, therefore we delay the send of Singles after sending a Multi
-	struct SPendingPresetWrite
-	{
-		uint8_t program = 0;
-		bool isMulti = false;
-		TPreset data;
-	};
-
 	std::list<SPendingPresetWrite> m_pendingPresetWrites;
 
 	std::vector<std::pair<synthLib::MidiEventSource, synthLib::SysexBuffer>> m_pendingSysexInput;
@@ -17,7 +17,7 @@
 namespace virusLib
 {
 
-ROMFile::ROMFile(std::vector<uint8_t> _data, std::string _name, const DeviceModel _model/* = DeviceModel::ABC*/) : m_model(_model), m_romFileName(std::move(_name)), m_romFileData(std::move(_data))
+ROMFile::ROMFile(synthLib::RomData _data, std::string _name, const DeviceModel _model/* = DeviceModel::ABC*/) : m_model(_model), m_romFileName(std::move(_name)), m_romFileData(std::move(_data)), m_romDataHash(m_romFileData.getHash())
 {
 	if(initialize())
 		return;
@@ -32,7 +32,7 @@ ROMFile ROMFile::invalid()
 
 bool ROMFile::initialize()
 {
-	std::unique_ptr<std::istream> dsp(new imemstream(reinterpret_cast<std::vector<char>&>(m_romFileData)));
+	std::unique_ptr<std::istream> dsp(new imemstream(reinterpret_cast<const std::vector<char>&>(m_romFileData.get())));
 
 	ROMUnpacker::Firmware fw;
 
@@ -138,7 +138,7 @@ bool ROMFile::initialize()
 		//load presets in a fixed order, TI first, Snow last
 		auto loadFirmwarePresets = [this](const DeviceModel _model)
 		{
-			const std::unique_ptr<imemstream> file(new imemstream(reinterpret_cast<std::vector<char>&>(m_romFileData)));
+			const std::unique_ptr<imemstream> file(new imemstream(reinterpret_cast<const std::vector<char>&>(m_romFileData.get())));
 			const auto firmware = ROMUnpacker::getFirmware(*file, _model);
 			if(!firmware.Presets.empty())
 			{
@@ -367,7 +367,7 @@ bool ROMFile::getPreset(const uint32_t _offset, TPreset& _out) const
 	if(_offset + getSinglePresetSize() > m_romFileData.size())
 		return false;
 
-	memcpy(_out.data(), &m_romFileData[_offset], getSinglePresetSize());
+	memcpy(_out.data(), m_romFileData.data() + _offset, getSinglePresetSize());
 	return true;
 }
 
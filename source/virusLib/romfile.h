@@ -8,6 +8,8 @@
 
 #include "baseLib/md5.h"
 
+#include "synthLib/romData.h"
+
 #include "deviceModel.h"
 
 namespace dsp56k
@@ -40,7 +42,7 @@ public:
 
 	using TPreset = std::array<uint8_t, 512>;
 
-	explicit ROMFile(std::vector<uint8_t> _data, std::string _name, DeviceModel _model = DeviceModel::ABC);
+	explicit ROMFile(synthLib::RomData _data, std::string _name, DeviceModel _model = DeviceModel::ABC);
 
 	static ROMFile invalid();
 
@@ -56,6 +58,8 @@ public:
 
 	bool isValid() const { return m_bootRom.size > 0; }
 
+	const BootRom& getBootRom() const { return m_bootRom; }
+
 	DeviceModel getModel() const { return m_model; }
 
 	std::string getModelName() const;
@@ -145,7 +149,7 @@ private:
 	std::vector<uint8_t> m_demoData;
 
 	std::string m_romFileName;
-	std::vector<uint8_t> m_romFileData;
+	synthLib::RomData m_romFileData;
 	baseLib::MD5 m_romDataHash;
 };
 
@@ -227,7 +227,7 @@ namespace virusLib
 			if(fd.type == BinaryRom)
 			{
 				// load as-is
-				auto& rom = roms.emplace_back(fd.data, fd.filename, model);
+				auto& rom = roms.emplace_back(synthLib::RomData(fd.data), fd.filename, model);
 				if(!rom.isValid())
 					roms.pop_back();
 			}
@@ -237,7 +237,7 @@ namespace virusLib
 				if(presets.empty())
 				{
 					// none available, use without presets
-					auto& rom = roms.emplace_back(fd.data, fd.filename, model);
+					auto& rom = roms.emplace_back(synthLib::RomData(fd.data), fd.filename, model);
 					if(!rom.isValid())
 						roms.pop_back();
 				}
@@ -248,7 +248,7 @@ namespace virusLib
 					auto data = fd.data;
 					data.insert(data.end(), p.data.begin(), p.data.end());
 
-					auto& rom = roms.emplace_back(data, fd.filename, model);
+					auto& rom = roms.emplace_back(synthLib::RomData(std::move(data)), fd.filename, model);
 					if(!rom.isValid())
 						roms.pop_back();
 					else if(presets.size() > 1)
@@ -1,5 +1,8 @@
 #include "wHardware.h"
 
+#include <algorithm>
+#include <thread>
+
 #include "dsp56kEmu/audio.h"
 
 #include "synthLib/midiBufferParser.h"
@@ -13,8 +16,14 @@ namespace wLib
 	constexpr uint32_t g_syncEsaiFrameRate = 8;
 	constexpr uint32_t g_syncHaltDspEsaiThreshold = 16;
 
+	// if nothing is going on, the uc is synced to the DSP in chunks of this many frames only. Once MIDI input or
+	// DSP communication is in flight, it syncs every g_syncEsaiFrameRate frames for at least g_syncLockstepHoldFrames
+	constexpr uint32_t g_syncEsaiFramesIdle = 32;
+	constexpr uint32_t g_syncLockstepHoldFrames = 4096;
+
 	static_assert((g_syncEsaiFrameRate & (g_syncEsaiFrameRate - 1)) == 0, "esai frame sync rate must be power of two");
 	static_assert(g_syncHaltDspEsaiThreshold >= g_syncEsaiFrameRate * 2, "esai DSP halt threshold must be greater than two times the sync rate");
+	static_assert(g_syncEsaiFramesIdle >= g_syncEsaiFrameRate, "idle sync must not be more fine grained than the active sync");
 
 	Hardware::Hardware(const double& _samplerate) : m_samplerateInv(1.0 / _samplerate)
 	{
@@ -22,42 +31,39 @@ namespace wLib
 
 	void Hardware::haltDSP()
 	{
-		if(m_haltDSP)
-			return;
-
-		std::lock_guard uLockHalt(m_haltDSPmutex);
-		m_haltDSP = true;
+		// the DSP thread checks the flag once per ESAI frame and only blocks if it is set
+		m_haltDSP.store(true, std::memory_order_release);
 	}
 
 	void Hardware::resumeDSP()
 	{
-		if(!m_haltDSP)
+		if(!m_haltDSP.exchange(false))
 			return;
 
 		{
 			std::lock_guard uLockHalt(m_haltDSPmutex);
-			m_haltDSP = false;
 		}
 		m_haltDSPcv.notify_one();
 	}
 
 	void Hardware::ucYieldLoop(const std::function<bool()>& _continue)
 	{
-		const auto dspHalted = m_haltDSP;
+		notifyUcActivity();
+
+		const auto dspHalted = m_haltDSP.load();
 
 		resumeDSP();
 
 		while(_continue() && !m_terminateUcThread)
 		{
-			if(m_processAudio || m_esaiFrameIndex <= 0)
-			{
+			const auto esaiFrameIndex = m_esaiFrameIndex.load(std::memory_order_acquire);
+
+			// spin while audio is processed, the DSP is expected to answer quickly. Without ESAI frames, nobody would
+			// wake us up
+			if(m_processAudio || esaiFrameIndex == 0)
 				std::this_thread::yield();
-			}
 			else
-			{
-				std::unique_lock uLock(m_esaiFrameAddedMutex);
-				m_esaiFrameAddedCv.wait(uLock);
-			}
+				waitForEsaiFrame((esaiFrameIndex + g_syncEsaiFrameRate) & ~(g_syncEsaiFrameRate - 1));
 		}
 
 		if(dspHalted)
@@ -66,10 +72,18 @@ namespace wLib
 
 	void Hardware::requestUcTermination()
 	{
-		m_terminateUcThread = true;
+		{
+			std::lock_guard uLock(m_esaiFrameAddedMutex);
+			m_terminateUcThread = true;
+		}
 		m_esaiFrameAddedCv.notify_one();
 	}
 
+	void Hardware::notifyUcActivity()
+	{
+		m_ucActivity.store(true, std::memory_order_relaxed);
+	}
+
 	void Hardware::sendMidi(const synthLib::SMidiEvent& _ev)
 	{
 		m_midiIn.push_back(_ev);
@@ -82,27 +96,86 @@ namespace wLib
 
 	void Hardware::onEsaiCallback(dsp56k::Audio& _audio)
 	{
-		++m_esaiFrameIndex;
+		// single writer, no read-modify-write needed
+		const auto esaiFrameIndex = m_esaiFrameIndex.load(std::memory_order_relaxed) + 1;
+		m_esaiFrameIndex.store(esaiFrameIndex, std::memory_order_relaxed);
+
+		const auto midiWritten = processMidiInput();
+
+		// orders the frame index and the audio output written for this frame before reading the wait requests below.
+		// The waiting threads publish their request first and then check the state, either they see our update or we
+		// see their request
+		std::atomic_thread_fence(std::memory_order_seq_cst);
 
-		processMidiInput();
+		auto ucWaitFrameIndex = m_ucWaitFrameIndex.load(std::memory_order_relaxed);
 
-		if((m_esaiFrameIndex & (g_syncEsaiFrameRate-1)) == 0)
+		// wake the uc early if it waits for a large chunk of frames but MIDI has arrived
+		if(ucWaitFrameIndex && (esaiFrameIndex >= ucWaitFrameIndex || midiWritten) && m_ucWaitFrameIndex.compare_exchange_strong(ucWaitFrameIndex, 0))
+		{
+			m_syncStats.ucWakeups.fetch_add(1, std::memory_order_relaxed);
+			{
+				std::lock_guard uLock(m_esaiFrameAddedMutex);
+			}
 			m_esaiFrameAddedCv.notify_one();
+		}
 
-		m_requestedFramesAvailableMutex.lock();
+		const auto requestedFrames = m_requestedFrames.load(std::memory_order_relaxed);
 
-		if(m_requestedFrames && _audio.getAudioOutputs().size() >= m_requestedFrames)
+		if(requestedFrames && _audio.getAudioOutputs().size() >= requestedFrames)
 		{
-			m_requestedFramesAvailableMutex.unlock();
+			{
+				std::lock_guard uLock(m_requestedFramesAvailableMutex);
+			}
 			m_requestedFramesAvailableCv.notify_one();
 		}
-		else
+
+		if(m_haltDSP.load(std::memory_order_acquire))
 		{
-			m_requestedFramesAvailableMutex.unlock();
+			m_syncStats.dspHalts.fetch_add(1, std::memory_order_relaxed);
+			std::unique_lock uLock(m_haltDSPmutex);
+			m_haltDSPcv.wait(uLock, [&]{ return !m_haltDSP.load(); });
 		}
+	}
 
-		std::unique_lock uLock(m_haltDSPmutex);
-		m_haltDSPcv.wait(uLock, [&]{ return m_haltDSP == false; });
+	void Hardware::waitForAudioOutputs(dsp56k::Audio& _audio, const size_t _count)
+	{
+		if(_audio.getAudioOutputs().size() >= _count)
+			return;
+
+		// reduce thread contention by waiting for output buffer to be full enough to let us grab the data without entering the read mutex too often
+		std::unique_lock uLock(m_requestedFramesAvailableMutex);
+
+		m_requestedFrames.store(_count, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		m_requestedFramesAvailableCv.wait(uLock, [&]
+		{
+			return _audio.getAudioOutputs().size() >= _count;
+		});
+
+		m_requestedFrames.store(0, std::memory_order_relaxed);
+	}
+
+	void Hardware::waitForEsaiFrame(const uint32_t _frameIndex)
+	{
+		std::unique_lock uLock(m_esaiFrameAddedMutex);
+
+		m_ucWaitFrameIndex.store(_frameIndex, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		// the DSP thread resets the frame index we are waiting for if it wakes us up
+		const auto done = [&]
+		{
+			return m_ucWaitFrameIndex.load(std::memory_order_relaxed) == 0 || m_esaiFrameIndex.load(std::memory_order_acquire) >= _frameIndex || m_terminateUcThread;
+		};
+
+		if(!done())
+		{
+			m_syncStats.ucWaits.fetch_add(1, std::memory_order_relaxed);
+			m_esaiFrameAddedCv.wait(uLock, done);
+		}
+
+		m_ucWaitFrameIndex.store(0, std::memory_order_relaxed);
 	}
 
 	void Hardware::syncUcToDSP()
@@ -114,14 +187,18 @@ namespace wLib
 		if(m_esaiFrameIndex <= 0)
 			return;
 
-		if(m_esaiFrameIndex == m_lastEsaiFrameIndex)
+		if(m_ucActivity.exchange(false, std::memory_order_relaxed) || !m_midiIn.empty())
+			m_syncLockstepEnd = m_lastEsaiFrameIndex + g_syncLockstepHoldFrames;
+
+		const uint32_t syncFrames = static_cast<int32_t>(m_syncLockstepEnd - m_lastEsaiFrameIndex) > 0 ? g_syncEsaiFrameRate : g_syncEsaiFramesIdle;
+
+		if(m_esaiFrameIndex - m_lastEsaiFrameIndex < syncFrames)
 		{
 			resumeDSP();
-			std::unique_lock uLock(m_esaiFrameAddedMutex);
-			m_esaiFrameAddedCv.wait(uLock, [this]{return m_esaiFrameIndex > m_lastEsaiFrameIndex;});
+			waitForEsaiFrame(m_lastEsaiFrameIndex + syncFrames);
 		}
 
-		const auto esaiFrameIndex = m_esaiFrameIndex;
+		const auto esaiFrameIndex = m_esaiFrameIndex.load(std::memory_order_acquire);
 
 		const auto ucClock = getUc().getSim().getSystemClockHz();
 
@@ -141,7 +218,8 @@ namespace wLib
 		// and consume them
 		m_remainingUcCyclesD -= static_cast<double>(m_remainingUcCycles);
 
-		if(esaiDelta > g_syncHaltDspEsaiThreshold)
+		// the uc is expected to lag behind by up to one sync chunk
+		if(esaiDelta > std::max(g_syncHaltDspEsaiThreshold, syncFrames * 2))
 		{
 			haltDSP();
 		}
@@ -153,10 +231,22 @@ namespace wLib
 		m_lastEsaiFrameIndex = esaiFrameIndex;
 	}
 
-	void Hardware::processMidiInput()
+	Hardware::SyncStats Hardware::getSyncStats() const
+	{
+		SyncStats stats;
+		stats.esaiFrames = m_esaiFrameIndex.load(std::memory_order_relaxed);
+		stats.ucWaits = m_syncStats.ucWaits.load(std::memory_order_relaxed);
+		stats.ucWakeups = m_syncStats.ucWakeups.load(std::memory_order_relaxed);
+		stats.dspHalts = m_syncStats.dspHalts.load(std::memory_order_relaxed);
+		return stats;
+	}
+
+	bool Hardware::processMidiInput()
 	{
 		++m_midiOffsetCounter;
 
+		bool written = false;
+
 		while(!m_midiIn.empty())
 		{
 			const auto& e = m_midiIn.front();
@@ -166,6 +256,12 @@ namespace wLib
 
 			getMidi().write(e);
 			m_midiIn.pop_front();
+			written = true;
 		}
+
+		if(written)
+			notifyUcActivity();
+
+		return written;
 	}
 }
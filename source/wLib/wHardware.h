@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <functional>
 
@@ -28,6 +29,15 @@ namespace wLib
 	class Hardware
 	{
 	public:
+		// number of times the uc and the DSP thread blocked or woke each other up, each one is a system call
+		struct SyncStats
+		{
+			uint64_t esaiFrames = 0;
+			uint64_t ucWaits = 0;
+			uint64_t ucWakeups = 0;
+			uint64_t dspHalts = 0;
+		};
+
 		Hardware(const double& _samplerate);
 		virtual ~Hardware() = default;
 
@@ -43,22 +53,36 @@ namespace wLib
 		// Used during shutdown so the UC thread can check m_destroy.
 		void requestUcTermination();
 
+		// lets the uc sync to the DSP every frame for a while, call when communication between uc and DSP happens
+		void notifyUcActivity();
+
 		void sendMidi(const synthLib::SMidiEvent& _ev);
 		void receiveMidi(std::vector<uint8_t>& _data);
 
 		uint32_t getEsaiFrameIndex() const { return m_esaiFrameIndex; }
 
+		SyncStats getSyncStats() const;
+
 	protected:
 		void onEsaiCallback(dsp56k::Audio& _audio);
 		void syncUcToDSP();
-		void processMidiInput();
+		bool processMidiInput();	// returns true if MIDI has been forwarded to the uc
 
+		// blocks the audio thread until the DSP has produced at least _count output frames
+		void waitForAudioOutputs(dsp56k::Audio& _audio, size_t _count);
+
+	private:
+		void waitForEsaiFrame(uint32_t _frameIndex);
+
+	protected:
 		// timing
 		const double m_samplerateInv;
-		uint32_t m_esaiFrameIndex = 0;
+		std::atomic<uint32_t> m_esaiFrameIndex{0};
 		uint32_t m_lastEsaiFrameIndex = 0;
 		int64_t m_remainingUcCycles = 0;
 		double m_remainingUcCyclesD = 0;
+		uint32_t m_syncLockstepEnd = 0;
+		std::atomic<bool> m_ucActivity{true};
 
 		dsp56k::RingBuffer<synthLib::SMidiEvent, 16384, true> m_midiIn;
 		uint32_t m_midiOffsetCounter = 0;
@@ -66,18 +90,28 @@ namespace wLib
 		std::vector<dsp56k::TWord> m_dummyInput;
 		std::vector<dsp56k::TWord> m_dummyOutput;
 
+		// The DSP thread only takes a mutex if the other side is actually waiting, otherwise each ESAI frame costs a
+		// few atomic operations only
 		std::mutex m_esaiFrameAddedMutex;
 		dsp56k::ConditionVariable m_esaiFrameAddedCv;
+		std::atomic<uint32_t> m_ucWaitFrameIndex{0};		// frame index the uc waits for, 0 = not waiting
 
 		std::mutex m_requestedFramesAvailableMutex;
 		dsp56k::ConditionVariable m_requestedFramesAvailableCv;
-		size_t m_requestedFrames = 0;
+		std::atomic<size_t> m_requestedFrames{0};
 
-		bool m_haltDSP = false;
+		std::atomic<bool> m_haltDSP{false};
 		dsp56k::ConditionVariable m_haltDSPcv;
 		std::mutex m_haltDSPmutex;
-		bool m_processAudio = false;
+		std::atomic<bool> m_processAudio{false};
 		bool m_bootCompleted = false;
-		bool m_terminateUcThread = false;
+		std::atomic<bool> m_terminateUcThread{false};
+
+		struct
+		{
+			std::atomic<uint64_t> ucWaits{0};
+			std::atomic<uint64_t> ucWakeups{0};
+			std::atomic<uint64_t> dspHalts{0};
+		} m_syncStats;
 	};
 }
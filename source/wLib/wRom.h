@@ -5,6 +5,7 @@
 #include <vector>
 
 #include "synthLib/midiTypes.h"
+#include "synthLib/romData.h"
 
 namespace wLib
 {
@@ -12,7 +13,7 @@ namespace wLib
 	{
 	public:
 		ROM() = default;
-		explicit ROM(const std::string& _filename, const uint32_t _expectedSize, std::vector<uint8_t> _data = {}) : m_buffer(std::move(_data)), m_filename(_filename)
+		explicit ROM(const std::string& _filename, const uint32_t _expectedSize, synthLib::RomData _data = {}) : m_buffer(std::move(_data)), m_filename(_filename)
 		{
 			if (m_buffer.size() != _expectedSize)
 				loadFromFile(_filename, _expectedSize);
@@ -35,7 +36,7 @@ namespace wLib
 	private:
 		bool loadFromFile(const std::string& _filename, uint32_t _expectedSize);
 
-		std::vector<uint8_t> m_buffer;
+		synthLib::RomData m_buffer;
 		std::string m_filename;
 	};	
 }
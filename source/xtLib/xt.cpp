@@ -10,7 +10,7 @@
 
 namespace xt
 {
-	Xt::Xt(const std::vector<uint8_t>& _romData, const std::string& _romName, const bool _voiceExpansion/* = false*/)
+	Xt::Xt(const synthLib::RomData& _romData, const std::string& _romName, const bool _voiceExpansion/* = false*/)
 	{
 		m_hw.reset(new Hardware(_romData, _romName, _voiceExpansion));
 
@@ -11,6 +11,8 @@
 #include "xtLeds.h"
 #include "xtTypes.h"
 
+#include "synthLib/romData.h"
+
 namespace synthLib
 {
 	struct SMidiEvent;
@@ -30,7 +32,7 @@ namespace xt
 			Lcd			= 0x02,
 		};
 
-		Xt(const std::vector<uint8_t>& _romData, const std::string& _romName, bool _voiceExpansion = false);
+		Xt(const synthLib::RomData& _romData, const std::string& _romName, bool _voiceExpansion = false);
 		~Xt();
 
 		bool isValid() const;
@@ -9,14 +9,14 @@
 
 namespace xt
 {
-	Rom initializeRom(const std::vector<uint8_t>& _romData, const std::string& _romName)
+	Rom initializeRom(const synthLib::RomData& _romData, const std::string& _romName)
 	{
 		if(_romData.empty())
 			return RomLoader::findROM();
 		return Rom{_romName, _romData};
 	}
 
-	Hardware::Hardware(const std::vector<uint8_t>& _romData, const std::string& _romName, const bool _voiceExpansion/* = false*/)
+	Hardware::Hardware(const synthLib::RomData& _romData, const std::string& _romName, const bool _voiceExpansion/* = false*/)
 		: wLib::Hardware(40000)
 		, m_rom(initializeRom(_romData, _romName))
 		, m_useVoiceExpansion(_voiceExpansion)
@@ -331,18 +331,7 @@ namespace xt
 
 			const auto requiredSize = processCount > 8 ? processCount - 8 : 0;
 
-			if(essiMain.getAudioOutputs().size() < requiredSize)
-			{
-				std::unique_lock uLock(m_requestedFramesAvailableMutex);
-				m_requestedFrames = requiredSize;
-				m_requestedFramesAvailableCv.wait(uLock, [&]()
-				{
-					if(essiMain.getAudioOutputs().size() < requiredSize)
-						return false;
-					m_requestedFrames = 0;
-					return true;
-				});
-			}
+			waitForAudioOutputs(essiMain, requiredSize);
 
 			essiMain.processAudioOutputInterleaved(outputs, processCount);
 
@@ -22,7 +22,7 @@ namespace xt
 	class Hardware : public wLib::Hardware
 	{
 	public:
-		explicit Hardware(const std::vector<uint8_t>& _romData, const std::string& _romName, bool _voiceExpansion = false);
+		explicit Hardware(const synthLib::RomData& _romData, const std::string& _romName, bool _voiceExpansion = false);
 		~Hardware() override;
 
 		void process();
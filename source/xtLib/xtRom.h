@@ -13,7 +13,7 @@ namespace xt
 	public:
 		static constexpr uint32_t Size = g_romSize;
 
-		Rom(const std::string& _filename, std::vector<uint8_t> _data) : ROM(_filename, Size, std::move(_data))
+		Rom(const std::string& _filename, synthLib::RomData _data) : ROM(_filename, Size, std::move(_data))
 		{
 		}
 
@@ -154,7 +154,7 @@ namespace xt
 			best.name += "_upgraded_" + bestMidi.name;
 		}
 
-		return {best.name, best.data};
+		return {best.name, synthLib::RomData(std::move(best.data))};
 	}
 
 	std::vector<RomLoader::File> RomLoader::findFiles(const std::string& _extension, const size_t _sizeMin, const size_t _sizeMax)